@@ -589,10 +589,14 @@ typedef struct {
 	bool copied:1,		/* a copy of an existing map. */
 		hashash:1,	/* the string heap contains hash values */
 		cleanhash:1,	/* string heaps must clean hash */
-		dirty:1;	/* specific heap dirty marker */
+		dirty:1,	/* specific heap dirty marker */
+		hugepages:1,	/* advised to use huge pages */
+		compressed:1;	/* save as compressed segment */
 	storage_t storage;	/* storage mode (mmap/malloc). */
 	storage_t newstorage;	/* new desired storage mode at re-allocation. */
 	bat parentid;		/* cache id of VIEW parent bat */
+	struct strdedup *dedup;	/* string heaps: double elimination
+				 * beyond GDK_ELIMLIMIT (transient) */
 } Heap;
 
 typedef struct {
@@ -783,7 +787,8 @@ typedef struct {
 #define GDKLIBRARY_NIL_NAN	061037U	/* flt/dbl NIL not represented by NaN */
 #define GDKLIBRARY_BLOB_SORT	061040U /* blob compare changed */
 #define GDKLIBRARY_OLDDATE	061041U
-#define GDKLIBRARY		061042U
+#define GDKLIBRARY_SEGMENTS	061042U	/* no compressed segments */
+#define GDKLIBRARY		061043U
 
 typedef struct BAT {
 	/* static bat properties */
@@ -962,6 +967,8 @@ gdk_export uint8_t ATOMelmshift(int sz);
  * @item BAT*
  * @tab BATappend (BAT *b, BAT *n, BAT *s, bool force)
  * @item BAT*
+ * @tab BATappendmany (BAT *b, BAT **n, int nn, bool force)
+ * @item BAT*
  * @tab BUNappend (BAT *b, ptr right, bool force)
  * @item BAT*
  * @tab BUNreplace (BAT *b, oid left, ptr right, bool force)
@@ -987,7 +994,8 @@ gdk_export uint8_t ATOMelmshift(int sz);
  * copying the BAT first.
  *
  * The update operations come in two flavors: BUNappend and
- * BUNreplace.  The batch version of BUNappend is BATappend.
+ * BUNreplace.  The batch version of BUNappend is BATappend, and
+ * BATappendmany appends a list of BATs at once.
  *
  * The routine BUNfnd provides fast access to a single BUN providing a
  * value for the tail of the binary association.
@@ -1162,6 +1170,8 @@ gdk_export gdk_return BUNappend(BAT *b, const void *right, bool force)
 	__attribute__((__warn_unused_result__));
 gdk_export gdk_return BATappend(BAT *b, BAT *n, BAT *s, bool force)
 	__attribute__((__warn_unused_result__));
+gdk_export gdk_return BATappendmany(BAT *b, BAT **n, int nn, bool force)
+	__attribute__((__warn_unused_result__));
 
 gdk_export gdk_return BUNdelete(BAT *b, oid o)
 	__attribute__((__warn_unused_result__));
@@ -1323,6 +1333,18 @@ BUNtoid(BAT *b, BUN p)
  * a parent bat).  A special mode is append-only. It is then allowed
  * to insert BUNs at the end of the BAT, but not to modify anything
  * that already was in there.
+ *
+ * BATadvise passes an access hint for the values of a BAT (one of
+ * MMAP_NORMAL, MMAP_RANDOM, MMAP_SEQUENTIAL, MMAP_WILLNEED, or
+ * MMAP_DONTNEED) on to the OS.  It only has effect if the heaps are
+ * memory mapped.  MMAP_WILLNEED starts asynchronous read-ahead of the
+ * values.
+ *
+ * BATcompress marks a persistent BAT as cold: from then on its heaps
+ * are saved as compressed segments with checksummed blocks, which are
+ * read back into memory as a whole when the BAT is next loaded.  It is
+ * meant for BATs that are no longer modified.  BATcompress(b, false)
+ * reverts to saving raw heaps.
  */
 gdk_export BUN BATcount_no_nil(BAT *b);
 gdk_export void BATsetcapacity(BAT *b, BUN cnt);
@@ -1348,6 +1370,8 @@ typedef enum {
 
 gdk_export gdk_return BATsetaccess(BAT *b, restrict_t mode);
 gdk_export restrict_t BATgetaccess(BAT *b);
+gdk_export void BATadvise(BAT *b, int advice);
+gdk_export gdk_return BATcompress(BAT *b, bool compress);
 
 
 #define BATdirty(b)	(!(b)->batCopiedtodisk ||			\
@@ -1587,8 +1611,8 @@ typedef struct {
 	BAT *desc;		/* the BAT descriptor */
 	char physical[20];	/* dir + basename for storage */
 	str options;		/* A string list of options */
-	int refs;		/* in-memory references on which the loaded status of a BAT relies */
-	int lrefs;		/* logical references on which the existence of a BAT relies */
+	ATOMIC_TYPE refs;	/* in-memory references on which the loaded status of a BAT relies */
+	ATOMIC_TYPE lrefs;	/* logical references on which the existence of a BAT relies */
 	volatile unsigned status; /* status mask used for spin locking */
 	/* MT_Id pid;           non-zero thread-id if this BAT is private */
 } BBPrec;
@@ -1617,8 +1641,8 @@ gdk_export BBPrec *BBP[N_BBPINIT];
 #define BBP_physical(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].physical
 #define BBP_options(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].options
 #define BBP_desc(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].desc
-#define BBP_refs(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].refs
-#define BBP_lrefs(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].lrefs
+#define BBP_refs(i)	((int) ATOMIC_GET(&BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].refs))
+#define BBP_lrefs(i)	((int) ATOMIC_GET(&BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].lrefs))
 #define BBP_status(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].status
 #define BBP_pid(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].pid
 
@@ -1929,6 +1953,11 @@ gdk_export size_t GDK_vm_maxsize;	/* max allowed size of reserved vm */
 
 gdk_export size_t GDKmem_cursize(void);	/* RAM/swapmem that MonetDB has claimed from OS */
 gdk_export size_t GDKvm_cursize(void);	/* current MonetDB VM address space usage */
+gdk_export size_t GDKmemreserve(size_t want, size_t min);	/* ask the memory broker for a budget */
+gdk_export void GDKmemrelease(size_t size);	/* return (part of) a budget */
+gdk_export size_t GDKmemavail(void);	/* memory the calling thread can count on */
+gdk_export size_t GDKpool_cursize(void);	/* freed heap memory kept for reuse */
+gdk_export size_t GDKhuge_cursize(void);	/* heap memory advised to use huge pages */
 
 gdk_export void *GDKmalloc(size_t size)
 	__attribute__((__malloc__))
@@ -2340,6 +2369,7 @@ typedef struct threadStruct {
 	str name;
 	void *data[THREADDATA];
 	uintptr_t sp;
+	size_t memreserved;	/* memory reserved with GDKmemreserve */
 } ThreadRec, *Thread;
 
 
@@ -485,19 +485,25 @@ dofsum(const void *restrict values, oid seqb,
 			bool seenval = false;				\
 			*algo = "with candidates, no groups";		\
 			sum = 0;					\
-			for (i = 0; i < ncand && nils == 0; i++) {	\
-				x = vals[canditer_next(ci) - seqb];	\
-				if (is_##TYPE1##_nil(x)) {		\
-					if (!skip_nils) {		\
-						sum = TYPE2##_nil;	\
-						nils = 1;		\
+			oid o;						\
+			BUN n;						\
+			while (nils == 0 &&				\
+			       (n = canditer_next_run(ci, &o, ncand)) > 0) { \
+				const TYPE1 *restrict run = vals + (o - seqb); \
+				for (i = 0; i < n && nils == 0; i++) {	\
+					x = run[i];			\
+					if (is_##TYPE1##_nil(x)) {	\
+						if (!skip_nils) {	\
+							sum = TYPE2##_nil; \
+							nils = 1;	\
+						}			\
+					} else {			\
+						ADD_WITH_CHECK(x, sum,	\
+							       TYPE2, sum, \
+							       GDK_##TYPE2##_max, \
+							       goto overflow); \
+						seenval = true;		\
 					}				\
-				} else {				\
-					ADD_WITH_CHECK(x, sum,		\
-						       TYPE2, sum,	\
-						       GDK_##TYPE2##_max, \
-						       goto overflow);	\
-					seenval = true;			\
 				}					\
 			}						\
 			if (seenval)					\
@@ -608,16 +614,22 @@ dofsum(const void *restrict values, oid seqb,
 			bool seenval = false;				\
 			*algo = "with candidates, no groups, no overflow"; \
 			sum = 0;					\
-			for (i = 0; i < ncand && nils == 0; i++) {	\
-				x = vals[canditer_next(ci) - seqb];	\
-				if (is_##TYPE1##_nil(x)) {		\
-					if (!skip_nils) {		\
-						sum = TYPE2##_nil;	\
-						nils = 1;		\
+			oid o;						\
+			BUN n;						\
+			while (nils == 0 &&				\
+			       (n = canditer_next_run(ci, &o, ncand)) > 0) { \
+				const TYPE1 *restrict run = vals + (o - seqb); \
+				for (i = 0; i < n && nils == 0; i++) {	\
+					x = run[i];			\
+					if (is_##TYPE1##_nil(x)) {	\
+						if (!skip_nils) {	\
+							sum = TYPE2##_nil; \
+							nils = 1;	\
+						}			\
+					} else {			\
+						sum += x;		\
+						seenval = true;		\
 					}				\
-				} else {				\
-					sum += x;			\
-					seenval = true;			\
 				}					\
 			}						\
 			if (seenval)					\
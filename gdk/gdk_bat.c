@@ -735,6 +735,13 @@ COLcopy(BAT *b, int tt, bool writable, role_t role)
 			strconcat_len(thp.filename, sizeof(thp.filename),
 				      BBP_physical(bn->batCacheid),
 				      ".theap", NULL);
+			/* when memory is short, the dummy small heaps
+			 * may be memory mapped from the very files the
+			 * copies are to be created in */
+			if (bn->theap.storage != STORE_MEM)
+				HEAPfree(&bn->theap, true);
+			if (bn->tvheap && bn->tvheap->storage != STORE_MEM)
+				HEAPfree(bn->tvheap, true);
 			if ((b->ttype && HEAPcopy(&bthp, &b->theap) != GDK_SUCCEED) ||
 			    (bn->tvheap && HEAPcopy(&thp, b->tvheap) != GDK_SUCCEED)) {
 				HEAPfree(&thp, true);
@@ -2011,6 +2018,43 @@ BATgetaccess(BAT *b)
 	return (restrict_t) b->batRestricted;
 }
 
+/* Mark the heaps of b to be saved as compressed segments (or not).
+ * The segments are written when the BAT is next saved, i.e. at the
+ * next commit or when it is unloaded, so that heaps that are in use
+ * are not replaced underneath any readers. */
+gdk_return
+BATcompress(BAT *b, bool compress)
+{
+	BATcheck(b, "BATcompress", GDK_FAIL);
+	if (isVIEW(b)) {
+		GDKerror("BATcompress: %s is a view\n", BATgetId(b));
+		return GDK_FAIL;
+	}
+	if (b->theap.compressed != compress ||
+	    (b->tvheap && b->tvheap->compressed != compress)) {
+		b->theap.compressed = compress;
+		if (b->tvheap)
+			b->tvheap->compressed = compress;
+		b->batDirtydesc = true;
+	}
+	return GDK_SUCCEED;
+}
+
+/* Tell the OS how the values of b (only those, if b is a view) are
+ * going to be accessed.  This only has effect on memory mapped
+ * heaps. */
+void
+BATadvise(BAT *b, int advice)
+{
+	if (b == NULL)
+		return;
+	if (b->ttype != TYPE_void)
+		HEAPadvise(&b->theap, 0, (size_t) BATcount(b) << b->tshift,
+			   advice);
+	if (b->tvheap)
+		HEAPadvise(b->tvheap, 0, b->tvheap->free, advice);
+}
+
 /*
  * @- change BAT persistency (persistent,session,transient)
  * In the past, we prevented BATS with certain types from being saved at all:
@@ -138,7 +138,9 @@ insert_string_bat(BAT *b, BAT *n, BAT *s, bool force)
 			 * have the same offset in b.  In the latter
 			 * case we also want to insert strings
 			 * individually, but reusing the string in b's
-			 * string heap. */
+			 * string heap.  The same goes for strings that
+			 * b's string heap already contains elsewhere,
+			 * as far as its dedup table knows. */
 			int match = 0, i;
 			size_t len = b->tvheap->hashash ? 1024 * EXTRALEN : 0;
 			for (i = 0; i < 1024; i++) {
@@ -150,6 +152,10 @@ insert_string_bat(BAT *b, BAT *n, BAT *s, bool force)
 				    (!b->tvheap->hashash ||
 				     ((BUN *) (b->tvheap->base + off))[-1] == (n->tvheap->hashash ? ((BUN *) (n->tvheap->base + off))[-1] : strHash(n->tvheap->base + off))))
 					match++;
+				else if (b->batCount > 0 &&
+					 b->tvheap->parentid == b->batCacheid &&
+					 strDedupLocate(b->tvheap, n->tvheap->base + off) != 0)
+					match++;
 				len += (strlen(n->tvheap->base + off) + 8) & ~7;
 			}
 			if (match < 768 && (size_t) (BATcount(n) * (double) len / 1024) >= n->tvheap->free / 2) {
@@ -761,6 +767,298 @@ BATappend(BAT *b, BAT *n, BAT *s, bool force)
 	return GDK_FAIL;
 }
 
+/* Append a list of BATs to b.  This is equivalent to calling
+ * BATappend for each of them in turn, but when packing a number of
+ * string BATs into an empty transient BAT (e.g. the pieces produced
+ * by mitosis), all string heaps are merged in one go: the heaps are
+ * laid out back to back in b's string heap (the start of each being
+ * a prefix sum over the aligned heap sizes), so that the offsets of
+ * each piece only need to be shifted by a constant.  Pieces that
+ * share a string heap also share its copy in b, and if all pieces
+ * share the same string heap, b shares it too.  Copying the heaps
+ * and translating the offsets is spread over a number of threads.
+ * If the heaps are small enough that double elimination in b's heap
+ * pays off, or if the pieces only use a small part of their heaps,
+ * we fall back to appending the pieces one by one. */
+struct strmerge {
+	BAT *b;			/* destination */
+	BAT **n;		/* pieces to be appended */
+	int nn;			/* number of pieces */
+	struct strmergepiece {
+		size_t toff;	/* offset of the piece's heap in b's heap */
+		BUN pos;	/* position of the piece's first value in b */
+		bool copy;	/* whether this piece copies its heap */
+	} *pieces;
+};
+
+static gdk_return
+strmerge_piece(void *arg, int i)
+{
+	struct strmerge *m = arg;
+	BAT *b = m->b;
+	BAT *n = m->n[i];
+	const struct strmergepiece *pc = &m->pieces[i];
+	BUN cnt = BATcount(n);
+
+	if (cnt == 0)
+		return GDK_SUCCEED;
+	if (pc->copy)
+		memcpy(b->tvheap->base + pc->toff, n->tvheap->base,
+		       n->tvheap->free);
+	if (pc->toff == 0 && n->twidth == b->twidth) {
+		memcpy(Tloc(b, pc->pos), Tloc(n, 0), cnt << n->tshift);
+		return GDK_SUCCEED;
+	}
+	const void *restrict src = Tloc(n, 0);
+	void *restrict dst = Tloc(b, pc->pos);
+	for (BUN p = 0; p < cnt; p++) {
+		var_t v = (var_t) (VarHeapVal(src, p, n->twidth) + pc->toff);
+		assert((size_t) v < b->tvheap->free);
+		switch (b->twidth) {
+		case 1:
+			assert(v - GDK_VAROFFSET < ((var_t) 1 << 8));
+			((uint8_t *) dst)[p] = (uint8_t) (v - GDK_VAROFFSET);
+			break;
+		case 2:
+			assert(v - GDK_VAROFFSET < ((var_t) 1 << 16));
+			((uint16_t *) dst)[p] = (uint16_t) (v - GDK_VAROFFSET);
+			break;
+#if SIZEOF_VAR_T == 8
+		case 4:
+			assert(v < ((var_t) 1 << 32));
+			((uint32_t *) dst)[p] = (uint32_t) v;
+			break;
+#endif
+		default:
+			((var_t *) dst)[p] = v;
+			break;
+		}
+	}
+	return GDK_SUCCEED;
+}
+
+/* Check whether merging the string heaps of the pieces is possible
+ * and worthwhile.  On return, pieces[i].copy is set for the first
+ * non-empty piece using each distinct heap, and *ndistinct is the
+ * number of distinct heaps. */
+static bool
+strmerge_check(BAT *b, BAT **n, int nn, struct strmergepiece *pieces, int *ndistinct)
+{
+	BUN total = 0;
+	size_t heapsize = 0;
+	bool elim = true;
+
+	if (BATcount(b) != 0 ||
+	    b->batRole != TRANSIENT ||
+	    b->tunique ||
+	    b->tvheap->parentid != b->batCacheid)
+		return false;
+	*ndistinct = 0;
+	for (int i = 0; i < nn; i++) {
+		pieces[i].copy = false;
+		if (n[i]->ttype != TYPE_str)
+			return false;
+		if (BATcount(n[i]) == 0)
+			continue;
+		if (n[i]->tvheap->hashash != b->tvheap->hashash)
+			return false;
+		total += BATcount(n[i]);
+		if (total > BUN_MAX)
+			return false;
+		pieces[i].copy = true;
+		for (int j = 0; j < i; j++) {
+			if (pieces[j].copy && n[j]->tvheap == n[i]->tvheap) {
+				pieces[i].copy = false;
+				break;
+			}
+		}
+		if (!pieces[i].copy)
+			continue;
+		(*ndistinct)++;
+		heapsize += n[i]->tvheap->free;
+		elim &= GDK_ELIMDOUBLES(n[i]->tvheap);
+	}
+	if (*ndistinct == 0)
+		return false;
+	if (*ndistinct == 1)
+		return true;	/* b can share the heap */
+	if (elim && heapsize <= GDK_ELIMLIMIT) {
+		/* small, double eliminated heaps: inserting strings
+		 * individually keeps b's heap double eliminated */
+		return false;
+	}
+	for (int i = 0; i < nn; i++) {
+		if (!pieces[i].copy || n[i]->tvheap->free <= GDK_ELIMLIMIT)
+			continue;
+		/* estimate, by sampling, which part of the heap is
+		 * used by the pieces that refer to it (cf.
+		 * insert_string_bat); if it's only a small part,
+		 * copying the whole (large) heap is wasteful */
+		const Heap *h = n[i]->tvheap;
+		BATiter ni = bat_iterator(n[i]);
+		BUN cnt = 0;
+		size_t len = 0;
+
+		for (int j = i; j < nn; j++)
+			if (BATcount(n[j]) > 0 && n[j]->tvheap == h)
+				cnt += BATcount(n[j]);
+		for (int k = 0; k < 64; k++) {
+			BUN p = (BUN) (((double) rand() / RAND_MAX) * (BATcount(n[i]) - 1));
+			len += (strlen(h->base + BUNtvaroff(ni, p)) + 8) & ~7;
+		}
+		if ((size_t) (cnt * (double) len / 64) < h->free / 2)
+			return false;
+	}
+	return true;
+}
+
+static gdk_return
+strmerge(BAT *b, BAT **n, int nn, struct strmergepiece *pieces, int ndistinct, bool force)
+{
+	struct strmerge m = {
+		.b = b,
+		.n = n,
+		.nn = nn,
+		.pieces = pieces,
+	};
+	int nthreads = 1;
+	size_t toff = 0;
+	BUN total = 0;
+	bool nil = false, nonil = true;
+
+	for (int i = 0; i < nn; i++) {
+		pieces[i].pos = total;
+		total += BATcount(n[i]);
+		nil |= n[i]->tnil;
+		nonil &= n[i]->tnonil;
+	}
+	IMPSdestroy(b);
+	OIDXdestroy(b);
+	HASHdestroy(b);
+	if (ndistinct == 1) {
+		/* all pieces use the same heap, so b can share it */
+		for (int i = 0; i < nn; i++) {
+			if (pieces[i].copy) {
+				HEAPfree(b->tvheap, true);
+				GDKfree(b->tvheap);
+				BBPshare(n[i]->tvheap->parentid);
+				b->tvheap = n[i]->tvheap;
+				b->batDirtydesc = true;
+				pieces[i].copy = false;
+				break;
+			}
+		}
+		for (int i = 0; i < nn; i++)
+			pieces[i].toff = 0;
+	} else {
+		/* lay out the heaps back to back */
+		for (int i = 0; i < nn; i++) {
+			if (pieces[i].copy) {
+				pieces[i].toff = toff;
+				toff += n[i]->tvheap->free;
+				/* make sure we get alignment right */
+				toff = (toff + GDK_VARALIGN - 1) & ~(GDK_VARALIGN - 1);
+			}
+		}
+		for (int i = 0; i < nn; i++) {
+			if (BATcount(n[i]) > 0 && !pieces[i].copy) {
+				for (int j = 0; j < i; j++) {
+					if (pieces[j].copy && n[j]->tvheap == n[i]->tvheap) {
+						pieces[i].toff = pieces[j].toff;
+						break;
+					}
+				}
+			}
+		}
+		if (HEAPextend(b->tvheap, toff, force) != GDK_SUCCEED)
+			return GDK_FAIL;
+	}
+	if (b->twidth < SIZEOF_VAR_T &&
+	    ((size_t) 1 << 8 * b->twidth) <= (b->twidth <= 2 ? b->tvheap->size - GDK_VAROFFSET : b->tvheap->size)) {
+		/* offsets aren't going to fit, so widen offset heap */
+		if (GDKupgradevarheap(b, (var_t) b->tvheap->size, false, force) != GDK_SUCCEED)
+			return GDK_FAIL;
+	}
+	if (total > BATcapacity(b) && BATextend(b, total) != GDK_SUCCEED)
+		return GDK_FAIL;
+	if (ndistinct > 1)
+		b->tvheap->free = toff;
+
+	/* only use threads if there is enough work to be done */
+	if ((ndistinct > 1 ? toff : 0) + (total << b->tshift) >= ((size_t) 1 << 20))
+		nthreads = GDKnr_threads;
+	if (GDKparallel("strmerge", nthreads, nn, 1, strmerge_piece, &m) != GDK_SUCCEED)
+		return GDK_FAIL;
+
+	if (ndistinct > 1) {
+		/* flush double-elimination hash table, it was
+		 * overwritten by the first heap */
+		memset(b->tvheap->base, 0, GDK_STRHASHSIZE);
+		b->tvheap->dirty = true;
+	}
+	b->theap.dirty = true;
+	BATsetcount(b, total);
+
+	/* properties: b is sorted (and key) if all pieces are and
+	 * they are in order */
+	bool sorted = true, revsorted = true, key = true;
+	BAT *prev = NULL;
+	for (int i = 0; i < nn && (sorted || revsorted || key); i++) {
+		if (BATcount(n[i]) == 0)
+			continue;
+		sorted &= n[i]->tsorted;
+		revsorted &= n[i]->trevsorted;
+		key &= n[i]->tkey;
+		if (prev) {
+			BATiter pi = bat_iterator(prev);
+			BATiter ni = bat_iterator(n[i]);
+			int c = strCmp(BUNtvar(pi, BUNlast(prev) - 1),
+				       BUNtvar(ni, 0));
+			sorted &= c <= 0;
+			revsorted &= c >= 0;
+			key &= (sorted || revsorted) && c != 0;
+		}
+		prev = n[i];
+	}
+	if (total > 1) {
+		b->tsorted = sorted;
+		b->trevsorted = revsorted;
+		b->tkey = key && (sorted || revsorted);
+	}
+	b->tnosorted = b->tnorevsorted = 0;
+	b->tnokey[0] = b->tnokey[1] = 0;
+	b->tseqbase = oid_nil;
+	b->tnil = nil;
+	b->tnonil = nonil;
+	return GDK_SUCCEED;
+}
+
+gdk_return
+BATappendmany(BAT *b, BAT **n, int nn, bool force)
+{
+	if (b->ttype == TYPE_str && nn > 1) {
+		struct strmergepiece *pieces;
+		int ndistinct;
+
+		ALIGNapp(b, "BATappendmany", force, GDK_FAIL);
+		if ((pieces = GDKmalloc(nn * sizeof(struct strmergepiece))) == NULL)
+			return GDK_FAIL;
+		if (strmerge_check(b, n, nn, pieces, &ndistinct)) {
+			gdk_return rc;
+
+			b->batDirtydesc = true;
+			rc = strmerge(b, n, nn, pieces, ndistinct, force);
+			GDKfree(pieces);
+			return rc;
+		}
+		GDKfree(pieces);
+	}
+	for (int i = 0; i < nn; i++)
+		if (BATappend(b, n[i], NULL, force) != GDK_SUCCEED)
+			return GDK_FAIL;
+	return GDK_SUCCEED;
+}
+
 gdk_return
 BATdel(BAT *b, BAT *d)
 {
@@ -1527,7 +1825,7 @@ BATsort(BAT **sorted, BAT **order, BAT **groups,
 				goto error;
 			bn->tsorted = true;
 			if (groups) {
-				if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true) != GDK_SUCCEED)
+				if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true, true) != GDK_SUCCEED)
 					goto error;
 				if (sorted &&
 				    (*groups)->tkey &&
@@ -1757,7 +2055,7 @@ BATsort(BAT **sorted, BAT **order, BAT **groups,
 	bn->tnorevsorted = 0;
 	bn->tnokey[0] = bn->tnokey[1] = 0;
 	if (groups) {
-		if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true) != GDK_SUCCEED)
+		if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true, true) != GDK_SUCCEED)
 			goto error;
 		if ((*groups)->tkey &&
 		    (g == NULL || (g->tsorted && g->trevsorted))) {
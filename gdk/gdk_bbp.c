@@ -353,6 +353,10 @@ BBPextend(int idx, bool buildhash)
 			GDKerror("BBPextend: failed to extend BAT pool\n");
 			return GDK_FAIL;
 		}
+		for (bat i = BBPlimit; i < BBPlimit + BBPINIT; i++) {
+			ATOMIC_INIT(BBP_refcnt(i), 0);
+			ATOMIC_INIT(BBP_lrefcnt(i), 0);
+		}
 		BBPlimit += BBPINIT;
 	}
 
@@ -919,7 +923,7 @@ heapinit(BAT *b, const char *buf, int *hashash, unsigned bbpversion, bat bid, co
 		return -1;
 	}
 
-	if (properties & ~0x0F81) {
+	if (properties & ~0x1F81) {
 		GDKerror("BBPinit: unknown properties are set: incompatible database\n");
 		return -1;
 	}
@@ -977,6 +981,9 @@ heapinit(BAT *b, const char *buf, int *hashash, unsigned bbpversion, bat bid, co
 	b->theap.newstorage = (storage_t) storage;
 	b->theap.farmid = BBPselectfarm(PERSISTENT, b->ttype, offheap);
 	b->theap.dirty = false;
+	/* (properties & 0x1000) is only used since GDKLIBRARY_SEGMENTS */
+	b->theap.compressed = bbpversion > GDKLIBRARY_SEGMENTS &&
+		(properties & 0x1000) != 0;
 #ifdef GDKLIBRARY_BLOB_SORT
 	if (bbpversion <= GDKLIBRARY_BLOB_SORT && strcmp(type, "blob") == 0) {
 		b->tsorted = b->trevsorted = false;
@@ -1022,6 +1029,8 @@ vheapinit(BAT *b, const char *buf, int hashash, bat bid, const char *filename)
 		b->tvheap->cleanhash = true;
 		b->tvheap->newstorage = (storage_t) storage;
 		b->tvheap->dirty = false;
+		/* BATcompress marks both heaps */
+		b->tvheap->compressed = b->theap.compressed;
 		b->tvheap->parentid = bid;
 		b->tvheap->farmid = BBPselectfarm(PERSISTENT, b->ttype, varheap);
 		if (b->tvheap->free > b->tvheap->size) {
@@ -1032,218 +1041,327 @@ vheapinit(BAT *b, const char *buf, int hashash, bat bid, const char *filename)
 	return n;
 }
 
+/* Reading BBP.dir and checking the files of all BATs at startup both
+ * take a while when there are many BATs, so the items of such work
+ * are handed out in chunks to a number of threads. */
+#define BBPINIT_CHUNK	64
+
 static gdk_return
-BBPreadEntries(FILE *fp, unsigned bbpversion)
+BBPinit_parallel(gdk_return (*func)(void *, int), void *arg, int n)
 {
-	bat bid = 0;
-	char buf[4096];
-	BAT *bn;
+	/* GDKnr_threads is only set after BBPinit */
+	return GDKparallel("BBPinit", MT_check_nr_cores(), n, BBPINIT_CHUNK,
+			   func, arg);
+}
 
-	/* read the BBP.dir and insert the BATs into the BBP */
-	while (fgets(buf, sizeof(buf), fp) != NULL) {
-		uint64_t batid;
-		uint16_t status;
-		char headname[129];
-		char filename[20];
-		unsigned int properties;
-		int nread, n;
-		char *s, *options = NULL;
-		char logical[1024];
-		uint64_t first = 0, count, capacity, base = 0;
-		int Thashash;
-
-		static_assert(sizeof(BBP_physical(0)) == sizeof(filename),
-			"filename should be same size as BBPrec.physical");
-		if ((s = strchr(buf, '\r')) != NULL) {
-			/* convert \r\n into just \n */
-			if (s[1] != '\n') {
-				GDKerror("BBPinit: invalid format for BBP.dir");
-				return GDK_FAIL;
-			}
-			*s++ = '\n';
-			*s = 0;
-		}
+struct bbpentries {
+	char **lines;		/* the lines of BBP.dir */
+	unsigned bbpversion;
+};
 
-		if (sscanf(buf,
-			   "%" SCNu64 " %" SCNu16 " %128s %19s %u %" SCNu64
-			   " %" SCNu64 " %" SCNu64
-			   "%n",
-			   &batid, &status, headname, filename,
-			   &properties,
-			   &count, &capacity, &base,
-			   &nread) < 8) {
-			GDKerror("BBPinit: invalid format for BBP.dir\n%s", buf);
+/* parse a single line of BBP.dir and insert the BAT into the BBP; the
+ * BBP must already be large enough */
+static gdk_return
+BBPreadEntry(void *arg, int i)
+{
+	char *buf = ((struct bbpentries *) arg)->lines[i];
+	unsigned bbpversion = ((struct bbpentries *) arg)->bbpversion;
+	bat bid;
+	BAT *bn;
+	uint64_t batid;
+	uint16_t status;
+	char headname[129];
+	char filename[20];
+	unsigned int properties;
+	int nread, n;
+	char *s, *options = NULL;
+	char logical[1024];
+	uint64_t first = 0, count, capacity, base = 0;
+	int Thashash;
+
+	static_assert(sizeof(BBP_physical(0)) == sizeof(filename),
+		"filename should be same size as BBPrec.physical");
+	if ((s = strchr(buf, '\r')) != NULL) {
+		/* convert \r\n into just \n */
+		if (s[1] != '\n') {
+			GDKerror("BBPinit: invalid format for BBP.dir");
 			return GDK_FAIL;
 		}
+		*s++ = '\n';
+		*s = 0;
+	}
 
-		if (batid >= N_BBPINIT * BBPINIT) {
-			GDKerror("BBPinit: bat ID (%" PRIu64 ") too large to accomodate (max %d).", batid, N_BBPINIT * BBPINIT - 1);
-			return GDK_FAIL;
-		}
+	if (sscanf(buf,
+		   "%" SCNu64 " %" SCNu16 " %128s %19s %u %" SCNu64
+		   " %" SCNu64 " %" SCNu64
+		   "%n",
+		   &batid, &status, headname, filename,
+		   &properties,
+		   &count, &capacity, &base,
+		   &nread) < 8) {
+		GDKerror("BBPinit: invalid format for BBP.dir\n%s", buf);
+		return GDK_FAIL;
+	}
+	assert(batid < (uint64_t) ATOMIC_GET(&BBPsize));
 
-		/* convert both / and \ path separators to our own DIR_SEP */
+	/* convert both / and \ path separators to our own DIR_SEP */
 #if DIR_SEP != '/'
-		s = filename;
-		while ((s = strchr(s, '/')) != NULL)
-			*s++ = DIR_SEP;
+	s = filename;
+	while ((s = strchr(s, '/')) != NULL)
+		*s++ = DIR_SEP;
 #endif
 #if DIR_SEP != '\\'
-		s = filename;
-		while ((s = strchr(s, '\\')) != NULL)
-			*s++ = DIR_SEP;
+	s = filename;
+	while ((s = strchr(s, '\\')) != NULL)
+		*s++ = DIR_SEP;
 #endif
 
-		if (first != 0) {
-			GDKerror("BBPinit: first != 0 (ID = %" PRIu64 ").",
-				 batid);
-			return GDK_FAIL;
-		}
+	if (first != 0) {
+		GDKerror("BBPinit: first != 0 (ID = %" PRIu64 ").",
+			 batid);
+		return GDK_FAIL;
+	}
 
-		bid = (bat) batid;
-		if (batid >= (uint64_t) ATOMIC_GET(&BBPsize)) {
-			ATOMIC_SET(&BBPsize, batid + 1);
-			if ((bat) ATOMIC_GET(&BBPsize) >= BBPlimit)
-				BBPextend(0, false);
-		}
-		if (BBP_desc(bid) != NULL) {
-			GDKerror("BBPinit: duplicate entry in BBP.dir (ID = "
-				 "%" PRIu64 ").", batid);
-			return GDK_FAIL;
-		}
-		bn = GDKzalloc(sizeof(BAT));
-		if (bn == NULL) {
-			GDKerror("BBPinit: cannot allocate memory for BAT.");
-			return GDK_FAIL;
-		}
-		bn->batCacheid = bid;
-		if (BATroles(bn, NULL) != GDK_SUCCEED) {
-			GDKfree(bn);
-			GDKerror("BBPinit: BATroles failed.");
-			return GDK_FAIL;
-		}
-		bn->batTransient = false;
-		bn->batCopiedtodisk = true;
-		bn->batRestricted = (properties & 0x06) >> 1;
-		bn->batCount = (BUN) count;
-		bn->batInserted = bn->batCount;
-		bn->batCapacity = (BUN) capacity;
-		char name[16];
-		snprintf(name, sizeof(name), "BATlock%d", bn->batCacheid); /* fits */
-		MT_lock_init(&bn->batIdxLock, name);
-
-		if (base > (uint64_t) GDK_oid_max) {
-			BATdestroy(bn);
-			GDKerror("BBPinit: head seqbase out of range (ID = %" PRIu64 ", seq = %" PRIu64 ").", batid, base);
-			return GDK_FAIL;
-		}
-		bn->hseqbase = (oid) base;
-		n = heapinit(bn, buf + nread, &Thashash, bbpversion, bid, filename);
-		if (n < 0) {
-			BATdestroy(bn);
-			return GDK_FAIL;
-		}
-		nread += n;
-		n = vheapinit(bn, buf + nread, Thashash, bid, filename);
-		if (n < 0) {
-			BATdestroy(bn);
-			return GDK_FAIL;
-		}
-		nread += n;
+	bid = (bat) batid;
+	bn = GDKzalloc(sizeof(BAT));
+	if (bn == NULL) {
+		GDKerror("BBPinit: cannot allocate memory for BAT.");
+		return GDK_FAIL;
+	}
+	bn->batCacheid = bid;
+	if (BATroles(bn, NULL) != GDK_SUCCEED) {
+		GDKfree(bn);
+		GDKerror("BBPinit: BATroles failed.");
+		return GDK_FAIL;
+	}
+	bn->batTransient = false;
+	bn->batCopiedtodisk = true;
+	bn->batRestricted = (properties & 0x06) >> 1;
+	bn->batCount = (BUN) count;
+	bn->batInserted = bn->batCount;
+	bn->batCapacity = (BUN) capacity;
+	char name[16];
+	snprintf(name, sizeof(name), "BATlock%d", bn->batCacheid); /* fits */
+	MT_lock_init(&bn->batIdxLock, name);
+
+	if (base > (uint64_t) GDK_oid_max) {
+		BATdestroy(bn);
+		GDKerror("BBPinit: head seqbase out of range (ID = %" PRIu64 ", seq = %" PRIu64 ").", batid, base);
+		return GDK_FAIL;
+	}
+	bn->hseqbase = (oid) base;
+	n = heapinit(bn, buf + nread, &Thashash, bbpversion, bid, filename);
+	if (n < 0) {
+		BATdestroy(bn);
+		return GDK_FAIL;
+	}
+	nread += n;
+	n = vheapinit(bn, buf + nread, Thashash, bid, filename);
+	if (n < 0) {
+		BATdestroy(bn);
+		return GDK_FAIL;
+	}
+	nread += n;
 
-		if (buf[nread] != '\n' && buf[nread] != ' ') {
-			BATdestroy(bn);
-			GDKerror("BBPinit: invalid format for BBP.dir\n%s", buf);
-			return GDK_FAIL;
-		}
-		if (buf[nread] == ' ')
-			options = buf + nread + 1;
+	if (buf[nread] != '\n' && buf[nread] != ' ') {
+		BATdestroy(bn);
+		GDKerror("BBPinit: invalid format for BBP.dir\n%s", buf);
+		return GDK_FAIL;
+	}
+	if (buf[nread] == ' ')
+		options = buf + nread + 1;
 
-		if ((s = strchr(headname, '~')) != NULL && s == headname) {
-			int len = snprintf(logical, sizeof(logical), "tmp_%o", (unsigned) bid);
-			if (len == -1 || len >= (int) sizeof(logical))
-				GDKfatal("BBPinit: BBP logical filename directory is too large\n");
-		} else {
-			if (s)
-				*s = 0;
-			strcpy_len(logical, headname, sizeof(logical));
-		}
-		s = logical;
-		BBP_logical(bid) = GDKstrdup(s);
-		if (BBP_logical(bid) == NULL) {
-			BATdestroy(bn);
-			return GDK_FAIL;
-		}
-		/* tailname is ignored */
-		strcpy_len(BBP_physical(bid), filename, sizeof(BBP_physical(bid)));
+	if ((s = strchr(headname, '~')) != NULL && s == headname) {
+		int len = snprintf(logical, sizeof(logical), "tmp_%o", (unsigned) bid);
+		if (len == -1 || len >= (int) sizeof(logical))
+			GDKfatal("BBPinit: BBP logical filename directory is too large\n");
+	} else {
+		if (s)
+			*s = 0;
+		strcpy_len(logical, headname, sizeof(logical));
+	}
+	s = logical;
+	BBP_logical(bid) = GDKstrdup(s);
+	if (BBP_logical(bid) == NULL) {
+		BATdestroy(bn);
+		return GDK_FAIL;
+	}
+	/* tailname is ignored */
+	strcpy_len(BBP_physical(bid), filename, sizeof(BBP_physical(bid)));
 #ifdef STATIC_CODE_ANALYSIS
-		/* help coverity */
-		BBP_physical(bid)[sizeof(BBP_physical(bid)) - 1] = 0;
+	/* help coverity */
+	BBP_physical(bid)[sizeof(BBP_physical(bid)) - 1] = 0;
 #endif
-		BBP_options(bid) = NULL;
-		if (options)
-			BBP_options(bid) = GDKstrdup(options);
-		BBP_refs(bid) = 0;
-		BBP_lrefs(bid) = 1;	/* any BAT we encounter here is persistent, so has a logical reference */
-		BBP_desc(bid) = bn;
-		BBP_status(bid) = BBPEXISTING;	/* do we need other status bits? */
-	}
+	BBP_options(bid) = NULL;
+	if (options)
+		BBP_options(bid) = GDKstrdup(options);
+	ATOMIC_SET(BBP_refcnt(bid), 0);
+	ATOMIC_SET(BBP_lrefcnt(bid), 1);	/* any BAT we encounter here is persistent, so has a logical reference */
+	BBP_desc(bid) = bn;
+	BBP_status(bid) = BBPEXISTING;	/* do we need other status bits? */
 	return GDK_SUCCEED;
 }
 
-/* check that the necessary files for all BATs exist and are large
- * enough */
 static gdk_return
-BBPcheckbats(void)
+BBPreadEntries(FILE *fp, unsigned bbpversion)
 {
-	for (bat bid = 1; bid < (bat) ATOMIC_GET(&BBPsize); bid++) {
-		struct stat statb;
-		BAT *b;
-		char *path;
+	struct bbpentries e = {
+		.bbpversion = bbpversion,
+	};
+	char buf[4096];
+	char *text = NULL, *s;
+	size_t len = 0, size = 0, l;
+	int nlines = 0, i;
+	uint64_t batid, maxid = 0;
+	uint8_t *seen;
+	gdk_return ret;
 
-		if ((b = BBP_desc(bid)) == NULL) {
-			/* not a valid BAT */
-			continue;
+	/* read the rest of BBP.dir into memory, each line followed by
+	 * a NUL byte */
+	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		l = strlen(buf) + 1;
+		if (len + l > size) {
+			size = MAX(2 * size, (size_t) 1 << 16);
+			s = GDKrealloc(text, size);
+			if (s == NULL) {
+				GDKfree(text);
+				return GDK_FAIL;
+			}
+			text = s;
 		}
-		if (b->ttype == TYPE_void) {
-			/* no files needed */
-			continue;
+		memcpy(text + len, buf, l);
+		len += l;
+		nlines++;
+	}
+	if (nlines == 0)
+		return GDK_SUCCEED;
+	e.lines = GDKmalloc(nlines * sizeof(char *));
+	if (e.lines == NULL) {
+		GDKfree(text);
+		return GDK_FAIL;
+	}
+	for (i = 0, s = text; i < nlines; i++, s += strlen(s) + 1)
+		e.lines[i] = s;
+
+	/* find the largest BAT ID so that the BBP is extended only
+	 * once, after which the lines can be parsed independently */
+	for (i = 0; i < nlines; i++) {
+		if (sscanf(e.lines[i], "%" SCNu64, &batid) != 1) {
+			GDKerror("BBPinit: invalid format for BBP.dir\n%s", e.lines[i]);
+			goto bailout;
+		}
+		if (batid >= N_BBPINIT * BBPINIT) {
+			GDKerror("BBPinit: bat ID (%" PRIu64 ") too large to accomodate (max %d).", batid, N_BBPINIT * BBPINIT - 1);
+			goto bailout;
 		}
-		path = GDKfilepath(0, BATDIR, BBP_physical(b->batCacheid), "tail");
+		if (batid > maxid)
+			maxid = batid;
+	}
+	seen = GDKzalloc(maxid / 8 + 1);
+	if (seen == NULL)
+		goto bailout;
+	for (i = 0; i < nlines; i++) {
+		batid = strtoull(e.lines[i], NULL, 10);
+		if (seen[batid / 8] & (1 << (batid % 8))) {
+			GDKfree(seen);
+			GDKerror("BBPinit: duplicate entry in BBP.dir (ID = "
+				 "%" PRIu64 ").", batid);
+			goto bailout;
+		}
+		seen[batid / 8] |= 1 << (batid % 8);
+	}
+	GDKfree(seen);
+	if (maxid >= (uint64_t) ATOMIC_GET(&BBPsize)) {
+		ATOMIC_SET(&BBPsize, maxid + 1);
+		if (BBPextend(0, false) != GDK_SUCCEED)
+			goto bailout;
+	}
+
+	ret = BBPinit_parallel(BBPreadEntry, &e, nlines);
+	GDKfree(e.lines);
+	GDKfree(text);
+	return ret;
+
+  bailout:
+	GDKfree(e.lines);
+	GDKfree(text);
+	return GDK_FAIL;
+}
+
+/* check that the necessary files for a BAT exist and are large
+ * enough */
+gdk_return
+BBPcheckbat(BAT *b)
+{
+	struct stat statb;
+	char *path;
+
+	if (b->ttype == TYPE_void) {
+		/* no files needed */
+		return GDK_SUCCEED;
+	}
+	path = GDKfilepath(0, BATDIR, BBP_physical(b->batCacheid), "tail");
+	if (path == NULL)
+		return GDK_FAIL;
+	if (stat(path, &statb) < 0) {
+		GDKsyserror("BBPcheckbat: cannot stat file %s\n",
+			    path);
+		GDKfree(path);
+		return GDK_FAIL;
+	}
+	/* compressed segments are smaller than the heap */
+	if ((size_t) statb.st_size < b->theap.free &&
+	    !GDKissegment(0, BBP_physical(b->batCacheid), "tail")) {
+		GDKerror("BBPcheckbat: file %s too small (expected %zu, actual %zu)\n", path, b->theap.free, (size_t) statb.st_size);
+		GDKfree(path);
+		return GDK_FAIL;
+	}
+	GDKfree(path);
+	if (b->tvheap != NULL) {
+		path = GDKfilepath(0, BATDIR, BBP_physical(b->batCacheid), "theap");
 		if (path == NULL)
 			return GDK_FAIL;
 		if (stat(path, &statb) < 0) {
-			GDKsyserror("BBPcheckbats: cannot stat file %s\n",
+			GDKsyserror("BBPcheckbat: cannot stat file %s\n",
 				    path);
 			GDKfree(path);
 			return GDK_FAIL;
 		}
-		if ((size_t) statb.st_size < b->theap.free) {
-			GDKerror("BBPcheckbats: file %s too small (expected %zu, actual %zu)\n", path, b->theap.free, (size_t) statb.st_size);
+		if ((size_t) statb.st_size < b->tvheap->free &&
+		    !GDKissegment(0, BBP_physical(b->batCacheid), "theap")) {
+			GDKerror("BBPcheckbat: file %s too small (expected %zu, actual %zu)\n", path, b->tvheap->free, (size_t) statb.st_size);
 			GDKfree(path);
 			return GDK_FAIL;
 		}
 		GDKfree(path);
-		if (b->tvheap != NULL) {
-			path = GDKfilepath(0, BATDIR, BBP_physical(b->batCacheid), "theap");
-			if (path == NULL)
-				return GDK_FAIL;
-			if (stat(path, &statb) < 0) {
-				GDKsyserror("BBPcheckbats: cannot stat file %s\n",
-					    path);
-				GDKfree(path);
-				return GDK_FAIL;
-			}
-			if ((size_t) statb.st_size < b->tvheap->free) {
-				GDKerror("BBPcheckbats: file %s too small (expected %zu, actual %zu)\n", path, b->tvheap->free, (size_t) statb.st_size);
-				GDKfree(path);
-				return GDK_FAIL;
-			}
-			GDKfree(path);
-		}
 	}
 	return GDK_SUCCEED;
 }
 
+static gdk_return
+BBPcheckbats_item(void *arg, int i)
+{
+	BAT *b;
+
+	(void) arg;
+	if ((b = BBP_desc((bat) i)) == NULL) {
+		/* not a valid BAT */
+		return GDK_SUCCEED;
+	}
+	return BBPcheckbat(b);
+}
+
+/* check the files of all BATs; with gdk_lazy_checkbats set, the
+ * files of a BAT are only checked when it is loaded */
+static gdk_return
+BBPcheckbats(void)
+{
+	if (GDK_lazy_checkbats)
+		return GDK_SUCCEED;
+	return BBPinit_parallel(BBPcheckbats_item, NULL,
+				(int) ATOMIC_GET(&BBPsize));
+}
+
 #ifdef HAVE_HGE
 #define SIZEOF_MAX_INT SIZEOF_HGE
 #else
@@ -1268,6 +1386,7 @@ BBPheader(FILE *fp)
 		return 0;
 	}
 	if (bbpversion != GDKLIBRARY &&
+	    bbpversion != GDKLIBRARY_SEGMENTS &&
 	    bbpversion != GDKLIBRARY_OLDDATE &&
 	    bbpversion != GDKLIBRARY_BLOB_SORT &&
 	    bbpversion != GDKLIBRARY_NIL_NAN &&
@@ -1606,11 +1725,11 @@ BBPexit(void)
 						bat vtp = VIEWvtparent(b);
 						if (tp) {
 							BBP_desc(tp)->batSharecnt--;
-							--BBP_lrefs(tp);
+							(void) ATOMIC_DEC(BBP_lrefcnt(tp));
 						}
 						if (vtp) {
 							BBP_desc(vtp)->batSharecnt--;
-							--BBP_lrefs(vtp);
+							(void) ATOMIC_DEC(BBP_lrefcnt(vtp));
 						}
 						VIEWdestroy(b);
 					} else {
@@ -1654,7 +1773,8 @@ heap_entry(FILE *fp, BAT *b)
 			   (((unsigned short) b->tkey & 0x01) << 8) |
 		           ((unsigned short) BATtdense(b) << 9) |
 			   ((unsigned short) b->tnonil << 10) |
-			   ((unsigned short) b->tnil << 11),
+			   ((unsigned short) b->tnil << 11) |
+			   ((unsigned short) b->theap.compressed << 12),
 		       b->tnokey[0],
 		       b->tnokey[1],
 		       b->tnosorted,
@@ -2209,8 +2329,8 @@ BBPinsert(BAT *bn)
 	BBP_status_set(i, BBPDELETING, "BBPinsert");
 	BBP_cache(i) = NULL;
 	BBP_desc(i) = NULL;
-	BBP_refs(i) = 1;	/* new bats have 1 pin */
-	BBP_lrefs(i) = 0;	/* ie. no logical refs */
+	ATOMIC_SET(BBP_refcnt(i), 1);	/* new bats have 1 pin */
+	ATOMIC_SET(BBP_lrefcnt(i), 0);	/* ie. no logical refs */
 
 #ifdef HAVE_HGE
 	if (bn->ttype == TYPE_hge)
@@ -2322,8 +2442,8 @@ bbpclear(bat i, int idx, bool lock)
 		fprintf(stderr, "#BBPclear set to unloading %d\n", i);
 	}
 	BBP_status_set(i, BBPUNLOADING, "BBPclear");
-	BBP_refs(i) = 0;
-	BBP_lrefs(i) = 0;
+	ATOMIC_SET(BBP_refcnt(i), 0);
+	ATOMIC_SET(BBP_lrefcnt(i), 0);
 	if (lock)
 		MT_lock_set(&GDKcacheLock(idx));
 
@@ -2468,6 +2588,35 @@ BBPspin(bat i, const char *s, unsigned event)
  * case if the parent bat cannot be loaded.
  * This means the return value of BBPfix should be checked in these
  * circumstances, but not necessarily in others. */
+/* Add delta (1 or -1) to the reference count *cnt of BAT i without
+ * taking the swap lock.  This is only done if the count is and stays
+ * positive: the transitions from and to zero are where BATs get
+ * loaded, unloaded and destroyed, and those are left to the locked
+ * code.  Returns the new count, or 0 if the caller must take the
+ * lock. */
+static inline int
+fastref(ATOMIC_TYPE *cnt, int delta, bat i)
+{
+	ATOMIC_BASE_TYPE old = ATOMIC_GET(cnt);
+
+	while (old > 0 && (int) old + delta > 0 &&
+	       !(BBP_status(i) & (BBPUNSTABLE|BBPLOADING))) {
+		if (ATOMIC_CAS(cnt, &old, old + delta)) {
+#ifdef LOCK_STATS
+			(void) ATOMIC_INC(&GDKbbpfastcnt);
+#endif
+			return (int) old + delta;
+		}
+#ifdef LOCK_STATS
+		(void) ATOMIC_INC(&GDKbbpretrycnt);
+#endif
+	}
+#ifdef LOCK_STATS
+	(void) ATOMIC_INC(&GDKbbpslowcnt);
+#endif
+	return 0;
+}
+
 static inline int
 incref(bat i, bool logical, bool lock)
 {
@@ -2479,6 +2628,12 @@ incref(bat i, bool logical, bool lock)
 	if (!BBPcheck(i, logical ? "BBPretain" : "BBPfix"))
 		return 0;
 
+	/* if there already is a reference of the same kind, the BAT
+	 * is loaded (resp. exists) and stays so, so we only need to
+	 * count */
+	if ((refs = fastref(logical ? BBP_lrefcnt(i) : BBP_refcnt(i), 1, i)) > 0)
+		return refs;
+
 	/* Before we get the lock and before we do all sorts of
 	 * things, make sure we can load the parent bats if there are
 	 * any.  If we can't load them, we can still easily fail.  If
@@ -2526,21 +2681,22 @@ incref(bat i, bool logical, bool lock)
 	if (logical) {
 		/* parent BATs are not relevant for logical refs */
 		tp = tvp = 0;
-		refs = ++BBP_lrefs(i);
+		refs = (int) ATOMIC_INC(BBP_lrefcnt(i));
 	} else {
 		tp = b->theap.parentid;
 		assert(tp >= 0);
 		tvp = b->tvheap == 0 || b->tvheap->parentid == i ? 0 : b->tvheap->parentid;
-		refs = ++BBP_refs(i);
-		if (refs == 1 && (tp || tvp)) {
+		if (BBP_refs(i) == 0 && (tp || tvp)) {
 			/* If this is a view, we must load the parent
 			 * BATs, but we must do that outside of the
 			 * lock.  Set the BBPLOADING flag so that
 			 * other threads will wait until we're
-			 * done. */
+			 * done.  The flag is set before the count
+			 * goes up so that fastref sees it. */
 			BBP_status_on(i, BBPLOADING, "BBPfix");
 			load = true;
 		}
+		refs = (int) ATOMIC_INC(BBP_refcnt(i));
 	}
 	if (lock)
 		MT_lock_unset(&GDKswapLock(i));
@@ -2608,6 +2764,13 @@ decref(bat i, bool logical, bool releaseShare, bool lock, const char *func)
 	BAT *b;
 
 	assert(i > 0);
+	/* as long as the count doesn't drop to zero, nothing happens
+	 * to the BAT; dropping a logical reference of an unfixed BAT
+	 * may unload it, though */
+	if (!releaseShare && (!logical || BBP_refs(i) > 0) &&
+	    (refs = fastref(logical ? BBP_lrefcnt(i) : BBP_refcnt(i), -1, i)) > 0)
+		return refs;
+
 	if (lock)
 		MT_lock_set(&GDKswapLock(i));
 	if (releaseShare) {
@@ -2633,7 +2796,7 @@ decref(bat i, bool logical, bool releaseShare, bool lock, const char *func)
 			GDKerror("%s: %s does not have logical references.\n", func, BBPname(i));
 			assert(0);
 		} else {
-			refs = --BBP_lrefs(i);
+			refs = (int) ATOMIC_DEC(BBP_lrefcnt(i));
 		}
 	} else {
 		if (BBP_refs(i) == 0) {
@@ -2642,7 +2805,7 @@ decref(bat i, bool logical, bool releaseShare, bool lock, const char *func)
 		} else {
 			assert(b == NULL || b->theap.parentid == 0 || BBP_refs(b->theap.parentid) > 0);
 			assert(b == NULL || b->tvheap == NULL || b->tvheap->parentid == 0 || BBP_refs(b->tvheap->parentid) > 0);
-			refs = --BBP_refs(i);
+			refs = (int) ATOMIC_DEC(BBP_refcnt(i));
 			if (b && refs == 0) {
 				if ((tp = b->theap.parentid) != 0)
 					b->theap.base = (char *) (b->theap.base - BBP_cache(tp)->theap.base);
@@ -3328,6 +3491,24 @@ fail:
 	return GDK_FAIL;
 }
 
+/* Saving the BATs of a commit one at a time makes the commit wait for
+ * the write and sync of each file in turn.  When there is more than
+ * one BAT to save, a number of threads take the BATs from a shared
+ * list and save them, so that the writes and syncs of the different
+ * files are in flight at the same time. */
+static gdk_return
+BBPsave_one(void *arg, int i)
+{
+	return BATsave(((BAT **) arg)[i]);
+}
+
+static gdk_return
+BBPsave_many(BAT **bats, int nbats)
+{
+	return GDKparallel("BBPsave", GDKnr_threads, nbats, 1,
+			   BBPsave_one, bats);
+}
+
 /*
  * @+ Atomic Write
  * The atomic BBPsync() function first safeguards the old images of
@@ -3390,21 +3571,28 @@ BBPsync(int cnt, bat *subcommit)
 
 	/* PHASE 2: save the repository */
 	if (ret == GDK_SUCCEED) {
-		int idx = 0;
-
-		while (++idx < cnt) {
-			bat i = subcommit ? subcommit[idx] : idx;
+		int idx = 0, nbats = 0;
+		BAT **bats;
 
-			if (BBP_status(i) & BBPPERSISTENT) {
-				BAT *b = dirty_bat(&i, subcommit != NULL);
-				if (i <= 0)
-					break;
-				if (b != NULL && BATsave(b) != GDK_SUCCEED)
-					break;	/* write error */
+		if ((bats = GDKmalloc(cnt * sizeof(BAT *))) == NULL)
+			ret = GDK_FAIL;
+		else {
+			while (++idx < cnt) {
+				bat i = subcommit ? subcommit[idx] : idx;
+
+				if (BBP_status(i) & BBPPERSISTENT) {
+					BAT *b = dirty_bat(&i, subcommit != NULL);
+					if (i <= 0)
+						break;
+					if (b != NULL)
+						bats[nbats++] = b;
+				}
 			}
+			if (idx < cnt ||
+			    BBPsave_many(bats, nbats) != GDK_SUCCEED)
+				ret = GDK_FAIL;	/* write error */
+			GDKfree(bats);
 		}
-		if (idx < cnt)
-			ret = GDK_FAIL;
 	}
 
 	PERFDEBUG fprintf(stderr, "#BBPsync (write time %d)\n", (t0 = GDKms()) - t1);
@@ -3451,6 +3639,91 @@ BBPsync(int cnt, bat *subcommit)
 	return ret;
 }
 
+/* Write back the modified pages of the memory mapped heaps of
+ * persistent BATs ahead of a checkpoint.  Such heaps are modified in
+ * place and are protected by the write-ahead log (see do_backup), so
+ * their pages can be written to disk at any time (the kernel is free
+ * to do so as well), but whatever is written now no longer has to be
+ * written by the msync in BBPsync.  At most about maxsize bytes of
+ * heap are synced per call, starting at BAT *bid, offset *offset
+ * (counting the tail heap first, then the var heap), where the next
+ * call is to continue.  *bid is set to 0 after a complete pass over
+ * the BBP.  Returns the number of bytes synced. */
+#define WRITEBACK_CHUNK	((size_t) 1 << 20)
+
+size_t
+BBPwriteback(bat *bid, size_t *offset, size_t maxsize)
+{
+	size_t done = 0;
+#ifdef MS_SYNC
+	size_t pagesize = MT_pagesize();
+	bat i = *bid;
+	size_t off = *offset;
+
+	if (GDKinmemory() || (GDKdebug & NOSYNCMASK))
+		return 0;
+	if (i <= 0) {
+		i = 1;
+		off = 0;
+	}
+	while (done < maxsize && i < (bat) ATOMIC_GET(&BBPsize)) {
+		BAT *b;
+		Heap *h = NULL;
+		size_t hoff = 0, end = 0, start, len;
+
+		/* the swap lock keeps the BAT from being unloaded
+		 * while we're at it */
+		MT_lock_set(&GDKswapLock(i));
+		if ((b = BBP_cache(i)) != NULL &&
+		    (BBP_status(i) & BBPPERSISTENT) &&
+		    !(BBP_status(i) & BBPUNSTABLE) &&
+		    !isVIEW(b)) {
+			if (off < b->theap.free) {
+				h = &b->theap;
+				hoff = off;
+				end = b->theap.free;
+			} else if (b->tvheap &&
+				   off - b->theap.free < b->tvheap->free) {
+				h = b->tvheap;
+				hoff = off - b->theap.free;
+				end = b->theap.free + b->tvheap->free;
+			}
+		}
+		if (h == NULL) {
+			/* done with this BAT */
+			MT_lock_unset(&GDKswapLock(i));
+			i++;
+			off = 0;
+			continue;
+		}
+		if (h->storage != STORE_MMAP || !h->dirty || h->farmid != 0 ||
+		    h->base == NULL) {
+			/* nothing to write back in this heap */
+			MT_lock_unset(&GDKswapLock(i));
+			off = end;
+			continue;
+		}
+		start = hoff & ~(pagesize - 1);
+		len = MIN(h->free - start, WRITEBACK_CHUNK);
+		/* the heap may be extended (and moved) by a concurrent
+		 * append, in which case we sync a stale range; that
+		 * fails or writes pages that can be written anyway,
+		 * so errors are ignored */
+		(void) msync(h->base + start, len, MS_SYNC);
+		MT_lock_unset(&GDKswapLock(i));
+		off += start + len - hoff;
+		done += len;
+	}
+	*bid = i < (bat) ATOMIC_GET(&BBPsize) ? i : 0;
+	*offset = off;
+#else
+	(void) bid;
+	(void) offset;
+	(void) maxsize;
+#endif
+	return done;
+}
+
 /*
  * Recovery just moves all files back to their original location. this
  * is an incremental process: if something fails, just stop with still
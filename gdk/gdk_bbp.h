@@ -70,6 +70,7 @@ gdk_export BAT *BBPdescriptor(bat b);
 
 /* swapping interface */
 gdk_export gdk_return BBPsync(int cnt, bat *subcommit);
+gdk_export size_t BBPwriteback(bat *bid, size_t *offset, size_t maxsize);
 gdk_export int BBPfix(bat b);
 gdk_export int BBPunfix(bat b);
 gdk_export int BBPretain(bat b);
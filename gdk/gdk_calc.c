@@ -164,27 +164,34 @@ checkbats(BAT *b1, BAT *b2, const char *func)
 		}							\
 	} while (0)
 
+/* The nonil variant is only used if there are no nils in the inputs
+ * and all values are to be calculated (i.e. the candidate list, if
+ * any, covers the whole input), so we don't need to look at the
+ * candidate iterator and the loops are simple enough for the
+ * compiler to vectorize them. */
 #define BINARY_3TYPE_FUNC_nonil(TYPE1, TYPE2, TYPE3, FUNC)		\
 	do {								\
-		do {							\
-			while (k < x) {					\
-				((TYPE3 *) dst)[k++] = TYPE3##_nil;	\
-				nils++;					\
-			}						\
-			i = x * incr1;					\
-			j = x * incr2;					\
-			TYPE1 v1 = ((const TYPE1 *) lft)[i];		\
-			TYPE2 v2 = ((const TYPE2 *) rgt)[j];		\
-			((TYPE3 *) dst)[k] = FUNC(v1, v2);		\
-			k++;						\
-			x = canditer_next(ci);				\
-			if (is_oid_nil(x))				\
-				break;					\
-			x -= candoff;					\
-		} while (k < cnt);					\
-		while (k < cnt) {					\
-			((TYPE3 *) dst)[k++] = TYPE3##_nil;		\
-			nils++;						\
+		const TYPE1 *restrict l = (const TYPE1 *) lft;		\
+		const TYPE2 *restrict r = (const TYPE2 *) rgt;		\
+		TYPE3 *restrict d = (TYPE3 *) dst;			\
+									\
+		assert(ci->ncand == cnt);				\
+		(void) x;						\
+		if (incr1 && incr2) {					\
+			for (k = 0; k < cnt; k++)			\
+				d[k] = FUNC(l[k], r[k]);		\
+		} else if (incr1) {					\
+			const TYPE2 v2 = r[0];				\
+			for (k = 0; k < cnt; k++)			\
+				d[k] = FUNC(l[k], v2);			\
+		} else if (incr2) {					\
+			const TYPE1 v1 = l[0];				\
+			for (k = 0; k < cnt; k++)			\
+				d[k] = FUNC(v1, r[k]);			\
+		} else {						\
+			const TYPE3 v = FUNC(l[0], r[0]);		\
+			for (k = 0; k < cnt; k++)			\
+				d[k] = v;				\
 		}							\
 	} while (0)
 
@@ -1770,6 +1777,191 @@ BATcalccstmax_no_nil(const ValRecord *v, BAT *b, BAT *s)
 	return BATcalcmaxcst_no_nil(b, v, s);
 }
 
+/* ---------------------------------------------------------------------- */
+/* arithmetic without nils (same numeric type for operands and result) */
+
+/* Most columns cannot contain nils, and often all values are to be
+ * calculated.  In that case, and if both operands and the result are
+ * of the same type, the functions below are used for +, -, * and /.
+ * Their loops contain neither nil checks nor candidate iteration, so
+ * that the compiler can vectorize them.  Overflow (and division by
+ * zero) is not checked per value but per block of values on the
+ * result.  If a problem is detected, the function gives up and
+ * returns false, and the caller redoes the calculation with the
+ * regular, checked functions which then produce the proper error (or
+ * nil values).  Since overflow is the exception, this is hardly ever
+ * needed. */
+
+#define NONIL_BLOCK	1024
+
+/* the various calculations; they set ovf if the result is not valid */
+#define NONIL_WIDE(OP, a, b, d, TYPE, WTYPE)				\
+	do {								\
+		WTYPE c = (WTYPE) (a) OP (b);				\
+		(d) = (TYPE) c;						\
+		ovf |= (c < -GDK_##TYPE##_max) | (c > GDK_##TYPE##_max); \
+	} while (0)
+#define NONIL_ADD_WIDE(a, b, d, TYPE, WTYPE)	NONIL_WIDE(+, a, b, d, TYPE, WTYPE)
+#define NONIL_SUB_WIDE(a, b, d, TYPE, WTYPE)	NONIL_WIDE(-, a, b, d, TYPE, WTYPE)
+#define NONIL_MUL_WIDE(a, b, d, TYPE, WTYPE)	NONIL_WIDE(*, a, b, d, TYPE, WTYPE)
+/* lng addition and subtraction in unsigned (wrap-around) arithmetic,
+ * overflow is detected by looking at the signs */
+#define NONIL_ADD_WRAP(a, b, d, TYPE, WTYPE)				\
+	do {								\
+		TYPE c = (TYPE) ((WTYPE) (a) + (WTYPE) (b));		\
+		(d) = c;						\
+		ovf |= (((a) ^ c) & ((b) ^ c)) < 0;			\
+		ovf |= c == TYPE##_nil;					\
+	} while (0)
+#define NONIL_SUB_WRAP(a, b, d, TYPE, WTYPE)				\
+	do {								\
+		TYPE c = (TYPE) ((WTYPE) (a) - (WTYPE) (b));		\
+		(d) = c;						\
+		ovf |= (((a) ^ (b)) & ((a) ^ c)) < 0;			\
+		ovf |= c == TYPE##_nil;					\
+	} while (0)
+/* integer division: avoid the trap on division by zero, the result
+ * is thrown away anyway */
+#define NONIL_DIV_INT(a, b, d, TYPE, WTYPE)				\
+	do {								\
+		ovf |= (b) == 0;					\
+		(d) = (a) / ((b) + ((b) == 0));				\
+	} while (0)
+#define NONIL_FLT(OP, a, b, d, TYPE)					\
+	do {								\
+		TYPE c = (a) OP (b);					\
+		(d) = c;						\
+		ovf |= (c < -GDK_##TYPE##_max) | (c > GDK_##TYPE##_max); \
+	} while (0)
+#define NONIL_ADD_FLT(a, b, d, TYPE, WTYPE)	NONIL_FLT(+, a, b, d, TYPE)
+#define NONIL_SUB_FLT(a, b, d, TYPE, WTYPE)	NONIL_FLT(-, a, b, d, TYPE)
+#define NONIL_MUL_FLT(a, b, d, TYPE, WTYPE)	NONIL_FLT(*, a, b, d, TYPE)
+#define NONIL_DIV_FLT(a, b, d, TYPE, WTYPE)				\
+	do {								\
+		ovf |= (b) == 0;					\
+		NONIL_FLT(/, a, b, d, TYPE);				\
+	} while (0)
+
+#define NONIL_LOOP(NAME, TYPE, WTYPE, CALC)				\
+static bool								\
+NAME##_nonil_##TYPE(const TYPE *restrict lft, int incr1,		\
+		    const TYPE *restrict rgt, int incr2,		\
+		    TYPE *restrict dst, BUN cnt)			\
+{									\
+	BUN lo, hi, k;							\
+									\
+	for (lo = 0; lo < cnt; lo = hi) {				\
+		int ovf = 0;						\
+									\
+		hi = cnt - lo > NONIL_BLOCK ? lo + NONIL_BLOCK : cnt;	\
+		if (incr1 && incr2) {					\
+			for (k = lo; k < hi; k++)			\
+				CALC(lft[k], rgt[k], dst[k], TYPE, WTYPE); \
+		} else if (incr1) {					\
+			const TYPE v2 = rgt[0];				\
+			for (k = lo; k < hi; k++)			\
+				CALC(lft[k], v2, dst[k], TYPE, WTYPE);	\
+		} else {						\
+			const TYPE v1 = lft[0];				\
+			for (k = lo; k < hi; k++)			\
+				CALC(v1, rgt[k], dst[k], TYPE, WTYPE);	\
+		}							\
+		if (ovf)						\
+			return false;					\
+	}								\
+	return true;							\
+}
+
+NONIL_LOOP(add, bte, sht, NONIL_ADD_WIDE)
+NONIL_LOOP(add, sht, int, NONIL_ADD_WIDE)
+NONIL_LOOP(add, int, lng, NONIL_ADD_WIDE)
+NONIL_LOOP(add, lng, ulng, NONIL_ADD_WRAP)
+NONIL_LOOP(add, flt, flt, NONIL_ADD_FLT)
+NONIL_LOOP(add, dbl, dbl, NONIL_ADD_FLT)
+NONIL_LOOP(sub, bte, sht, NONIL_SUB_WIDE)
+NONIL_LOOP(sub, sht, int, NONIL_SUB_WIDE)
+NONIL_LOOP(sub, int, lng, NONIL_SUB_WIDE)
+NONIL_LOOP(sub, lng, ulng, NONIL_SUB_WRAP)
+NONIL_LOOP(sub, flt, flt, NONIL_SUB_FLT)
+NONIL_LOOP(sub, dbl, dbl, NONIL_SUB_FLT)
+NONIL_LOOP(mul, bte, sht, NONIL_MUL_WIDE)
+NONIL_LOOP(mul, sht, int, NONIL_MUL_WIDE)
+NONIL_LOOP(mul, int, lng, NONIL_MUL_WIDE)
+#ifdef HAVE_HGE
+NONIL_LOOP(mul, lng, hge, NONIL_MUL_WIDE)
+#endif
+NONIL_LOOP(mul, flt, flt, NONIL_MUL_FLT)
+NONIL_LOOP(mul, dbl, dbl, NONIL_MUL_FLT)
+NONIL_LOOP(div, bte, bte, NONIL_DIV_INT)
+NONIL_LOOP(div, sht, sht, NONIL_DIV_INT)
+NONIL_LOOP(div, int, int, NONIL_DIV_INT)
+NONIL_LOOP(div, lng, lng, NONIL_DIV_INT)
+NONIL_LOOP(div, flt, flt, NONIL_DIV_FLT)
+NONIL_LOOP(div, dbl, dbl, NONIL_DIV_FLT)
+
+/* Calculate lft OP rgt into dst if the types allow it and no
+ * overflow occurs; the caller must make sure that there are no nils
+ * in the operands and that all cnt values are to be calculated.  At
+ * least one of the operands is a column (incr == 1). */
+static bool
+arith_nonil(char op, const void *lft, int tp1, int incr1,
+	    const void *rgt, int tp2, int incr2,
+	    void *restrict dst, int tp, BUN cnt)
+{
+	tp = ATOMbasetype(tp);
+	if (ATOMbasetype(tp1) != tp || ATOMbasetype(tp2) != tp || cnt == 0)
+		return false;
+	assert(incr1 || incr2);
+
+#define NONIL_CALL(NAME, TYPE)						\
+	NAME##_nonil_##TYPE((const TYPE *) lft, incr1,			\
+			    (const TYPE *) rgt, incr2,			\
+			    (TYPE *) dst, cnt)
+#define NONIL_SWITCH(NAME)						\
+	switch (tp) {							\
+	case TYPE_bte:							\
+		return NONIL_CALL(NAME, bte);				\
+	case TYPE_sht:							\
+		return NONIL_CALL(NAME, sht);				\
+	case TYPE_int:							\
+		return NONIL_CALL(NAME, int);				\
+	case TYPE_flt:							\
+		return NONIL_CALL(NAME, flt);				\
+	case TYPE_dbl:							\
+		return NONIL_CALL(NAME, dbl);				\
+	default:							\
+		break;							\
+	}
+
+	switch (op) {
+	case '+':
+		NONIL_SWITCH(add);
+		if (tp == TYPE_lng)
+			return NONIL_CALL(add, lng);
+		break;
+	case '-':
+		NONIL_SWITCH(sub);
+		if (tp == TYPE_lng)
+			return NONIL_CALL(sub, lng);
+		break;
+	case '*':
+		NONIL_SWITCH(mul);
+#ifdef HAVE_HGE
+		if (tp == TYPE_lng)
+			return NONIL_CALL(mul, lng);
+#endif
+		break;
+	case '/':
+		NONIL_SWITCH(div);
+		if (tp == TYPE_lng)
+			return NONIL_CALL(div, lng);
+		break;
+	}
+	return false;
+#undef NONIL_SWITCH
+#undef NONIL_CALL
+}
+
 /* ---------------------------------------------------------------------- */
 /* addition (any numeric type) */
 
@@ -1789,32 +1981,29 @@ add_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			ADD##IF##_WITH_CHECK(lft[i], rgt[j],		\
-					     TYPE3, dst[k],		\
-					     max,			\
-					     ON_OVERFLOW(TYPE1, TYPE2, "+")); \
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else {					\
+				ADD##IF##_WITH_CHECK(lft[i], rgt[j],	\
+						     TYPE3, dst[k],	\
+						     max,		\
+						     ON_OVERFLOW(TYPE1, TYPE2, "+")); \
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -1830,35 +2019,32 @@ add_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 	const bool couldoverflow = (max < (TYPE3) GDK_##TYPE1##_max + (TYPE3) GDK_##TYPE2##_max); \
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else if (couldoverflow) {				\
-			ADD##IF##_WITH_CHECK(lft[i], rgt[j],		\
-					     TYPE3, dst[k],		\
-					     max,			\
-					     ON_OVERFLOW(TYPE1, TYPE2, "+")); \
-		} else {						\
-			dst[k] = (TYPE3) lft[i] + rgt[j];		\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else if (couldoverflow) {			\
+				ADD##IF##_WITH_CHECK(lft[i], rgt[j],	\
+						     TYPE3, dst[k],	\
+						     max,		\
+						     ON_OVERFLOW(TYPE1, TYPE2, "+")); \
+			} else {					\
+				dst[k] = (TYPE3) lft[i] + rgt[j];	\
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -3494,13 +3680,19 @@ BATcalcadd(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error)
 	if (b1->ttype == TYPE_str && b2->ttype == TYPE_str && tp == TYPE_str) {
 		nils = addstr_loop(b1, NULL, b2, NULL, bn, cnt, &ci);
 	} else {
-		nils = add_typeswitchloop(Tloc(b1, 0),
-					  b1->ttype, 1,
-					  Tloc(b2, 0),
-					  b2->ttype, 1,
-					  Tloc(bn, 0), tp,
-					  cnt, &ci, b1->hseqbase,
-					  abort_on_error, __func__);
+		if (ncand == cnt && b1->tnonil && b2->tnonil &&
+		    arith_nonil('+', Tloc(b1, 0), b1->ttype, 1,
+				Tloc(b2, 0), b2->ttype, 1,
+				Tloc(bn, 0), tp, cnt))
+			nils = 0;
+		else
+			nils = add_typeswitchloop(Tloc(b1, 0),
+						  b1->ttype, 1,
+						  Tloc(b2, 0),
+						  b2->ttype, 1,
+						  Tloc(bn, 0), tp,
+						  cnt, &ci, b1->hseqbase,
+						  abort_on_error, __func__);
 	}
 
 	if (nils == BUN_NONE) {
@@ -3547,11 +3739,18 @@ BATcalcaddcst(BAT *b, const ValRecord *v, BAT *s, int tp, bool abort_on_error)
 	if (b->ttype == TYPE_str && v->vtype == TYPE_str && tp == TYPE_str) {
 		nils = addstr_loop(b, NULL, NULL, v->val.sval, bn, cnt, &ci);
 	} else {
-		nils = add_typeswitchloop(Tloc(b, 0), b->ttype, 1,
-					  VALptr(v), v->vtype, 0,
-					  Tloc(bn, 0), tp,
-					  cnt, &ci, b->hseqbase,
-					  abort_on_error, __func__);
+		if (ncand == cnt && b->tnonil &&
+		    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+		    arith_nonil('+', Tloc(b, 0), b->ttype, 1,
+				VALptr(v), v->vtype, 0,
+				Tloc(bn, 0), tp, cnt))
+			nils = 0;
+		else
+			nils = add_typeswitchloop(Tloc(b, 0), b->ttype, 1,
+						  VALptr(v), v->vtype, 0,
+						  Tloc(bn, 0), tp,
+						  cnt, &ci, b->hseqbase,
+						  abort_on_error, __func__);
 	}
 
 	if (nils == BUN_NONE) {
@@ -3598,11 +3797,18 @@ BATcalccstadd(const ValRecord *v, BAT *b, BAT *s, int tp, bool abort_on_error)
 	if (b->ttype == TYPE_str && v->vtype == TYPE_str && tp == TYPE_str) {
 		nils = addstr_loop(NULL, v->val.sval, b, NULL, bn, cnt, &ci);
 	} else {
-		nils = add_typeswitchloop(VALptr(v), v->vtype, 0,
-					  Tloc(b, 0), b->ttype, 1,
-					  Tloc(bn, 0), tp,
-					  cnt, &ci, b->hseqbase,
-					  abort_on_error, __func__);
+		if (ncand == cnt && b->tnonil &&
+		    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+		    arith_nonil('+', VALptr(v), v->vtype, 0,
+				Tloc(b, 0), b->ttype, 1,
+				Tloc(bn, 0), tp, cnt))
+			nils = 0;
+		else
+			nils = add_typeswitchloop(VALptr(v), v->vtype, 0,
+						  Tloc(b, 0), b->ttype, 1,
+						  Tloc(bn, 0), tp,
+						  cnt, &ci, b->hseqbase,
+						  abort_on_error, __func__);
 	}
 
 	if (nils == BUN_NONE) {
@@ -3731,32 +3937,29 @@ sub_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			SUB##IF##_WITH_CHECK(lft[i], rgt[j],		\
-					     TYPE3, dst[k],		\
-					     max,			\
-					     ON_OVERFLOW(TYPE1, TYPE2, "-")); \
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else {					\
+				SUB##IF##_WITH_CHECK(lft[i], rgt[j],	\
+						     TYPE3, dst[k],	\
+						     max,		\
+						     ON_OVERFLOW(TYPE1, TYPE2, "-")); \
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -3772,35 +3975,32 @@ sub_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 	const bool couldoverflow = (max < (TYPE3) GDK_##TYPE1##_max + (TYPE3) GDK_##TYPE2##_max); \
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else if (couldoverflow) {				\
-			SUB##IF##_WITH_CHECK(lft[i], rgt[j],		\
-					     TYPE3, dst[k],		\
-					     max,			\
-					     ON_OVERFLOW(TYPE1, TYPE2, "-")); \
-		} else {						\
-			dst[k] = (TYPE3) lft[i] + rgt[j];		\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else if (couldoverflow) {			\
+				SUB##IF##_WITH_CHECK(lft[i], rgt[j],	\
+						     TYPE3, dst[k],	\
+						     max,		\
+						     ON_OVERFLOW(TYPE1, TYPE2, "-")); \
+			} else {					\
+				dst[k] = (TYPE3) lft[i] + rgt[j];	\
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -5366,11 +5566,17 @@ BATcalcsub(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = sub_typeswitchloop(Tloc(b1, 0), b1->ttype, 1,
-				  Tloc(b2, 0), b2->ttype, 1,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b1->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b1->tnonil && b2->tnonil &&
+	    arith_nonil('-', Tloc(b1, 0), b1->ttype, 1,
+			Tloc(b2, 0), b2->ttype, 1,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = sub_typeswitchloop(Tloc(b1, 0), b1->ttype, 1,
+					  Tloc(b2, 0), b2->ttype, 1,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b1->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils == BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -5408,11 +5614,18 @@ BATcalcsubcst(BAT *b, const ValRecord *v, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = sub_typeswitchloop(Tloc(b, 0), b->ttype, 1,
-				  VALptr(v), v->vtype, 0,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b->tnonil &&
+	    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+	    arith_nonil('-', Tloc(b, 0), b->ttype, 1,
+			VALptr(v), v->vtype, 0,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = sub_typeswitchloop(Tloc(b, 0), b->ttype, 1,
+					  VALptr(v), v->vtype, 0,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils == BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -5455,11 +5668,18 @@ BATcalccstsub(const ValRecord *v, BAT *b, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = sub_typeswitchloop(VALptr(v), v->vtype, 0,
-				  Tloc(b, 0), b->ttype, 1,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b->tnonil &&
+	    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+	    arith_nonil('-', VALptr(v), v->vtype, 0,
+			Tloc(b, 0), b->ttype, 1,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = sub_typeswitchloop(VALptr(v), v->vtype, 0,
+					  Tloc(b, 0), b->ttype, 1,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils == BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -5528,33 +5748,30 @@ mul_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			MUL##IF##4_WITH_CHECK(lft[i], rgt[j],		\
-					      TYPE3, dst[k],		\
-					      max,			\
-					      TYPE4,			\
-					      ON_OVERFLOW(TYPE1, TYPE2, "*")); \
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else {					\
+				MUL##IF##4_WITH_CHECK(lft[i], rgt[j],	\
+						      TYPE3, dst[k],	\
+						      max,		\
+						      TYPE4,		\
+						      ON_OVERFLOW(TYPE1, TYPE2, "*")); \
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -5570,36 +5787,33 @@ mul_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 	const bool couldoverflow = (max < (TYPE3) GDK_##TYPE1##_max * (TYPE3) GDK_##TYPE2##_max); \
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else if (couldoverflow) {				\
-			MUL##IF##4_WITH_CHECK(lft[i], rgt[j],		\
-					      TYPE3, dst[k],		\
-					      max,			\
-					      TYPE3,			\
-					      ON_OVERFLOW(TYPE1, TYPE2, "*")); \
-		} else {						\
-			dst[k] = (TYPE3) lft[i] * rgt[j];		\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else if (couldoverflow) {			\
+				MUL##IF##4_WITH_CHECK(lft[i], rgt[j],	\
+						      TYPE3, dst[k],	\
+						      max,		\
+						      TYPE3,		\
+						      ON_OVERFLOW(TYPE1, TYPE2, "*")); \
+			} else {					\
+				dst[k] = (TYPE3) lft[i] * rgt[j];	\
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -5619,32 +5833,29 @@ mul_##TYPE1##_##TYPE2##_hge(const TYPE1 *lft, int incr1,		\
 			    struct canditer *restrict ci,		\
 			    oid candoff, bool abort_on_error)		\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = hge_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = hge_nil;				\
 			nils++;						\
-		} else {						\
-			HGEMUL_CHECK(lft[i], rgt[j],			\
-				     dst[k],				\
-				     max,				\
-				     ON_OVERFLOW(TYPE1, TYPE2, "*"));	\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = hge_nil;			\
+				nils++;					\
+			} else {					\
+				HGEMUL_CHECK(lft[i], rgt[j],		\
+					     dst[k],			\
+					     max,			\
+					     ON_OVERFLOW(TYPE1, TYPE2, "*")); \
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = hge_nil;					\
 		nils++;							\
@@ -5662,32 +5873,29 @@ mul_##TYPE1##_##TYPE2##_lng(const TYPE1 *lft, int incr1,		\
 			    struct canditer *restrict ci,		\
 			    oid candoff, bool abort_on_error)		\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = lng_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = lng_nil;				\
 			nils++;						\
-		} else {						\
-			LNGMUL_CHECK(lft[i], rgt[j],			\
-				     dst[k],				\
-				     max,				\
-				     ON_OVERFLOW(TYPE1, TYPE2, "*"));	\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = lng_nil;			\
+				nils++;					\
+			} else {					\
+				LNGMUL_CHECK(lft[i], rgt[j],		\
+					     dst[k],			\
+					     max,			\
+					     ON_OVERFLOW(TYPE1, TYPE2, "*")); \
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = lng_nil;					\
 		nils++;							\
@@ -5705,36 +5913,33 @@ mul_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			/* only check for overflow, not for underflow */ \
-			dst[k] = (TYPE3) (lft[i] * rgt[j]);		\
-			if (isinf(dst[k]) || ABSOLUTE(dst[k]) > max) {	\
-				if (abort_on_error)			\
-					ON_OVERFLOW(TYPE1, TYPE2, "*");	\
+		}							\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
 				dst[k] = TYPE3##_nil;			\
 				nils++;					\
+			} else {					\
+				/* only check for overflow, not for underflow */ \
+				dst[k] = (TYPE3) (lft[i] * rgt[j]);	\
+				if (isinf(dst[k]) || ABSOLUTE(dst[k]) > max) { \
+					if (abort_on_error)		\
+						ON_OVERFLOW(TYPE1, TYPE2, "*"); \
+					dst[k] = TYPE3##_nil;		\
+					nils++;				\
+				}					\
 			}						\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -7280,6 +7485,7 @@ mul_typeswitchloop(const void *lft, int tp1, int incr1,
 
 static BAT *
 BATcalcmuldivmod(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error,
+		 char op,
 		 BUN (*typeswitchloop)(const void *, int, int,
 				       const void *, int, int,
 				       void *restrict, int, BUN,
@@ -7308,11 +7514,17 @@ BATcalcmuldivmod(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error,
 	if (bn == NULL)
 		return NULL;
 
-	nils = (*typeswitchloop)(Tloc(b1, 0), b1->ttype, 1,
-				 Tloc(b2, 0), b2->ttype, 1,
-				 Tloc(bn, 0), tp,
-				 cnt, &ci, b1->hseqbase,
-				 abort_on_error, func);
+	if (ncand == cnt && b1->tnonil && b2->tnonil &&
+	    arith_nonil(op, Tloc(b1, 0), b1->ttype, 1,
+			Tloc(b2, 0), b2->ttype, 1,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = (*typeswitchloop)(Tloc(b1, 0), b1->ttype, 1,
+					 Tloc(b2, 0), b2->ttype, 1,
+					 Tloc(bn, 0), tp,
+					 cnt, &ci, b1->hseqbase,
+					 abort_on_error, func);
 
 	if (nils >= BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -7333,7 +7545,7 @@ BATcalcmuldivmod(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error,
 BAT *
 BATcalcmul(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error)
 {
-	return BATcalcmuldivmod(b1, b2, s, tp, abort_on_error,
+	return BATcalcmuldivmod(b1, b2, s, tp, abort_on_error, '*',
 				mul_typeswitchloop, __func__);
 }
 
@@ -7357,11 +7569,18 @@ BATcalcmulcst(BAT *b, const ValRecord *v, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = mul_typeswitchloop(Tloc(b, 0), b->ttype, 1,
-				  VALptr(v), v->vtype, 0,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b->tnonil &&
+	    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+	    arith_nonil('*', Tloc(b, 0), b->ttype, 1,
+			VALptr(v), v->vtype, 0,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = mul_typeswitchloop(Tloc(b, 0), b->ttype, 1,
+					  VALptr(v), v->vtype, 0,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils == BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -7414,11 +7633,18 @@ BATcalccstmul(const ValRecord *v, BAT *b, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = mul_typeswitchloop(VALptr(v), v->vtype, 0,
-				  Tloc(b, 0), b->ttype, 1,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b->tnonil &&
+	    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+	    arith_nonil('*', VALptr(v), v->vtype, 0,
+			Tloc(b, 0), b->ttype, 1,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = mul_typeswitchloop(VALptr(v), v->vtype, 0,
+					  Tloc(b, 0), b->ttype, 1,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils == BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -7475,40 +7701,37 @@ div_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
-			dst[k] = TYPE3##_nil;				\
-			nils++;						\
-		} else if (rgt[j] == 0) {				\
-			if (abort_on_error)				\
-				return BUN_NONE + 1;			\
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			dst[k] = (TYPE3) (lft[i] / rgt[j]);		\
-			if (dst[k] < -max || dst[k] > max) {		\
+		}							\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else if (rgt[j] == 0) {			\
 				if (abort_on_error)			\
-					return BUN_NONE + 2;		\
+					return BUN_NONE + 1;		\
 				dst[k] = TYPE3##_nil;			\
 				nils++;					\
+			} else {					\
+				dst[k] = (TYPE3) (lft[i] / rgt[j]);	\
+				if (dst[k] < -max || dst[k] > max) {	\
+					if (abort_on_error)		\
+						return BUN_NONE + 2;	\
+					dst[k] = TYPE3##_nil;		\
+					nils++;				\
+				}					\
 			}						\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -7524,46 +7747,43 @@ div_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
-			dst[k] = TYPE3##_nil;				\
-			nils++;						\
-		} else if (rgt[j] == 0 ||				\
-			   (ABSOLUTE(rgt[j]) < 1 &&			\
-			    GDK_##TYPE3##_max * ABSOLUTE(rgt[j]) < lft[i])) { \
-			/* only check for overflow, not for underflow */ \
-			if (abort_on_error) {				\
-				if (rgt[j] == 0)			\
-					return BUN_NONE + 1;		\
-				ON_OVERFLOW(TYPE1, TYPE2, "/");		\
-			}						\
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			dst[k] = (TYPE3) lft[i] / rgt[j];		\
-			if (dst[k] < -max || dst[k] > max) {		\
-				if (abort_on_error)			\
-					return BUN_NONE + 2;		\
+		}							\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
 				dst[k] = TYPE3##_nil;			\
 				nils++;					\
-			}						\
-		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+			} else if (rgt[j] == 0 ||			\
+				   (ABSOLUTE(rgt[j]) < 1 &&		\
+				    GDK_##TYPE3##_max * ABSOLUTE(rgt[j]) < lft[i])) { \
+				/* only check for overflow, not for underflow */ \
+				if (abort_on_error) {			\
+					if (rgt[j] == 0)		\
+						return BUN_NONE + 1;	\
+					ON_OVERFLOW(TYPE1, TYPE2, "/");	\
+				}					\
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else {					\
+				dst[k] = (TYPE3) lft[i] / rgt[j];	\
+				if (dst[k] < -max || dst[k] > max) {	\
+					if (abort_on_error)		\
+						return BUN_NONE + 2;	\
+					dst[k] = TYPE3##_nil;		\
+					nils++;				\
+				}					\
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -9231,7 +9451,7 @@ div_typeswitchloop(const void *lft, int tp1, int incr1,
 BAT *
 BATcalcdiv(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error)
 {
-	return BATcalcmuldivmod(b1, b2, s, tp, abort_on_error,
+	return BATcalcmuldivmod(b1, b2, s, tp, abort_on_error, '/',
 				div_typeswitchloop, __func__);
 }
 
@@ -9255,11 +9475,18 @@ BATcalcdivcst(BAT *b, const ValRecord *v, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = div_typeswitchloop(Tloc(b, 0), b->ttype, 1,
-				  VALptr(v), v->vtype, 0,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b->tnonil &&
+	    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+	    arith_nonil('/', Tloc(b, 0), b->ttype, 1,
+			VALptr(v), v->vtype, 0,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = div_typeswitchloop(Tloc(b, 0), b->ttype, 1,
+					  VALptr(v), v->vtype, 0,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils >= BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -9315,11 +9542,18 @@ BATcalccstdiv(const ValRecord *v, BAT *b, BAT *s, int tp, bool abort_on_error)
 	if (bn == NULL)
 		return NULL;
 
-	nils = div_typeswitchloop(VALptr(v), v->vtype, 0,
-				  Tloc(b, 0), b->ttype, 1,
-				  Tloc(bn, 0), tp,
-				  cnt, &ci, b->hseqbase,
-				  abort_on_error, __func__);
+	if (ncand == cnt && b->tnonil &&
+	    ATOMcmp(v->vtype, VALptr(v), ATOMnilptr(v->vtype)) != 0 &&
+	    arith_nonil('/', VALptr(v), v->vtype, 0,
+			Tloc(b, 0), b->ttype, 1,
+			Tloc(bn, 0), tp, cnt))
+		nils = 0;
+	else
+		nils = div_typeswitchloop(VALptr(v), v->vtype, 0,
+					  Tloc(b, 0), b->ttype, 1,
+					  Tloc(bn, 0), tp,
+					  cnt, &ci, b->hseqbase,
+					  abort_on_error, __func__);
 
 	if (nils >= BUN_NONE) {
 		BBPunfix(bn->batCacheid);
@@ -9361,34 +9595,31 @@ mod_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
-			dst[k] = TYPE3##_nil;				\
-			nils++;						\
-		} else if (rgt[j] == 0) {				\
-			if (abort_on_error)				\
-				return BUN_NONE + 1;			\
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else {						\
-			dst[k] = (TYPE3) lft[i] % rgt[j];		\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else if (rgt[j] == 0) {			\
+				if (abort_on_error)			\
+					return BUN_NONE + 1;		\
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else {					\
+				dst[k] = (TYPE3) lft[i] % rgt[j];	\
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -9404,35 +9635,32 @@ mod_##TYPE1##_##TYPE2##_##TYPE3(const TYPE1 *lft, int incr1,		\
 				struct canditer *restrict ci,		\
 				oid candoff, bool abort_on_error)	\
 {									\
-	oid x = canditer_next(ci) - candoff;				\
-	BUN i, j, k = 0;						\
+	oid x;								\
+	BUN i, j, k = 0, n;						\
 	BUN nils = 0;							\
 									\
-	do {								\
-		while (k < x) {						\
-			dst[k++] = TYPE3##_nil;				\
-			nils++;						\
-		}							\
-		i = x * incr1;						\
-		j = x * incr2;						\
-		if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+	while ((n = canditer_next_run(ci, &x, cnt)) > 0) {		\
+		for (x -= candoff; k < x; k++) {			\
 			dst[k] = TYPE3##_nil;				\
 			nils++;						\
-		} else if (rgt[j] == 0) {				\
-			if (abort_on_error)				\
-				return BUN_NONE + 1;			\
-			dst[k] = TYPE3##_nil;				\
-			nils++;						\
-		} else {						\
-			dst[k] = (TYPE3) FUNC((TYPE3) lft[i],		\
-					      (TYPE3) rgt[j]);		\
 		}							\
-		k++;							\
-		x = canditer_next(ci);					\
-		if (is_oid_nil(x))					\
-			break;						\
-		x -= candoff;						\
-	} while (k < cnt);						\
+		for (n += k; k < n; k++) {				\
+			i = k * incr1;					\
+			j = k * incr2;					\
+			if (is_##TYPE1##_nil(lft[i]) || is_##TYPE2##_nil(rgt[j])) { \
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else if (rgt[j] == 0) {			\
+				if (abort_on_error)			\
+					return BUN_NONE + 1;		\
+				dst[k] = TYPE3##_nil;			\
+				nils++;					\
+			} else {					\
+				dst[k] = (TYPE3) FUNC((TYPE3) lft[i],	\
+						      (TYPE3) rgt[j]);	\
+			}						\
+		}							\
+	}								\
 	while (k < cnt) {						\
 		dst[k++] = TYPE3##_nil;					\
 		nils++;							\
@@ -10715,7 +10943,7 @@ mod_typeswitchloop(const void *lft, int tp1, int incr1,
 BAT *
 BATcalcmod(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error)
 {
-	return BATcalcmuldivmod(b1, b2, s, tp, abort_on_error,
+	return BATcalcmuldivmod(b1, b2, s, tp, abort_on_error, '%',
 				mod_typeswitchloop, __func__);
 }
 
@@ -10816,6 +11044,347 @@ VARcalcmod(ValPtr ret, const ValRecord *lft, const ValRecord *rgt,
 	return GDK_SUCCEED;
 }
 
+/* ---------------------------------------------------------------------- */
+/* fused element-wise arithmetic (any numeric type) */
+
+/* Evaluate an expression consisting of the operators +, -, * and /
+ * over a number of aligned BATs and constants, all of the same type,
+ * in a single pass and without intermediate BATs.  The expression is
+ * given in postfix notation as a string of space separated tokens,
+ * where a number refers to an operand (b[n] if it is not NULL,
+ * otherwise v[n]) and the other tokens are operators, e.g. "0 1 * 2 +"
+ * for (b0 * b1) + b2.  The values are processed in vectors of
+ * FUSE_VECSIZE values, so that all intermediate results stay in the
+ * cache.  The semantics (nil handling, overflow and division by zero)
+ * are those of BATcalcadd and friends with equal input and output
+ * types. */
+
+#define FUSE_VECSIZE	1024
+#define FUSE_MAXDEPTH	16
+#define FUSE_MAXOPS	128
+
+struct fuseop {
+	char op;		/* 0 for operand, otherwise operator */
+	int arg;		/* operand number */
+};
+
+#define FUSE_MUL_bte(lft, rgt, dst, on_overflow)			\
+	MULI4_WITH_CHECK(lft, rgt, bte, dst, GDK_bte_max, sht, on_overflow)
+#define FUSE_MUL_sht(lft, rgt, dst, on_overflow)			\
+	MULI4_WITH_CHECK(lft, rgt, sht, dst, GDK_sht_max, int, on_overflow)
+#define FUSE_MUL_int(lft, rgt, dst, on_overflow)			\
+	MULI4_WITH_CHECK(lft, rgt, int, dst, GDK_int_max, lng, on_overflow)
+#define FUSE_MUL_lng(lft, rgt, dst, on_overflow)			\
+	LNGMUL_CHECK(lft, rgt, dst, GDK_lng_max, on_overflow)
+#ifdef HAVE_HGE
+#define FUSE_MUL_hge(lft, rgt, dst, on_overflow)			\
+	HGEMUL_CHECK(lft, rgt, dst, GDK_hge_max, on_overflow)
+#endif
+
+#define FUSE_INT(TYPE)							\
+static BUN								\
+fuse_##TYPE(char op, const TYPE *lft, int incr1,			\
+	    const TYPE *rgt, int incr2,					\
+	    TYPE *dst, BUN cnt, bool abort_on_error)			\
+{									\
+	BUN i, j, k;							\
+	BUN nils = 0;							\
+									\
+	for (k = 0; k < cnt; k++) {					\
+		i = k * incr1;						\
+		j = k * incr2;						\
+		if (is_##TYPE##_nil(lft[i]) || is_##TYPE##_nil(rgt[j])) { \
+			dst[k] = TYPE##_nil;				\
+			nils++;						\
+			continue;					\
+		}							\
+		switch (op) {						\
+		case '+':						\
+			ADDI_WITH_CHECK(lft[i], rgt[j], TYPE, dst[k],	\
+					GDK_##TYPE##_max,		\
+					ON_OVERFLOW(TYPE, TYPE, "+"));	\
+			break;						\
+		case '-':						\
+			SUBI_WITH_CHECK(lft[i], rgt[j], TYPE, dst[k],	\
+					GDK_##TYPE##_max,		\
+					ON_OVERFLOW(TYPE, TYPE, "-"));	\
+			break;						\
+		case '*':						\
+			FUSE_MUL_##TYPE(lft[i], rgt[j], dst[k],		\
+					ON_OVERFLOW(TYPE, TYPE, "*"));	\
+			break;						\
+		default:						\
+			if (rgt[j] == 0) {				\
+				if (abort_on_error)			\
+					return BUN_NONE + 1;		\
+				dst[k] = TYPE##_nil;			\
+				nils++;					\
+			} else {					\
+				dst[k] = lft[i] / rgt[j];		\
+			}						\
+			break;						\
+		}							\
+	}								\
+	return nils;							\
+}
+
+#define FUSE_FLT(TYPE)							\
+static BUN								\
+fuse_##TYPE(char op, const TYPE *lft, int incr1,			\
+	    const TYPE *rgt, int incr2,					\
+	    TYPE *dst, BUN cnt, bool abort_on_error)			\
+{									\
+	BUN i, j, k;							\
+	BUN nils = 0;							\
+									\
+	for (k = 0; k < cnt; k++) {					\
+		i = k * incr1;						\
+		j = k * incr2;						\
+		if (is_##TYPE##_nil(lft[i]) || is_##TYPE##_nil(rgt[j])) { \
+			dst[k] = TYPE##_nil;				\
+			nils++;						\
+			continue;					\
+		}							\
+		switch (op) {						\
+		case '+':						\
+			ADDF_WITH_CHECK(lft[i], rgt[j], TYPE, dst[k],	\
+					GDK_##TYPE##_max,		\
+					ON_OVERFLOW(TYPE, TYPE, "+"));	\
+			break;						\
+		case '-':						\
+			SUBF_WITH_CHECK(lft[i], rgt[j], TYPE, dst[k],	\
+					GDK_##TYPE##_max,		\
+					ON_OVERFLOW(TYPE, TYPE, "-"));	\
+			break;						\
+		case '*':						\
+			/* only check for overflow, not for underflow */ \
+			dst[k] = lft[i] * rgt[j];			\
+			if (isinf(dst[k]) ||				\
+			    ABSOLUTE(dst[k]) > GDK_##TYPE##_max) {	\
+				if (abort_on_error)			\
+					ON_OVERFLOW(TYPE, TYPE, "*");	\
+				dst[k] = TYPE##_nil;			\
+				nils++;					\
+			}						\
+			break;						\
+		default:						\
+			if (rgt[j] == 0 ||				\
+			    (ABSOLUTE(rgt[j]) < 1 &&			\
+			     GDK_##TYPE##_max * ABSOLUTE(rgt[j]) < lft[i])) { \
+				/* only check for overflow, not for underflow */ \
+				if (abort_on_error) {			\
+					if (rgt[j] == 0)		\
+						return BUN_NONE + 1;	\
+					ON_OVERFLOW(TYPE, TYPE, "/");	\
+				}					\
+				dst[k] = TYPE##_nil;			\
+				nils++;					\
+			} else {					\
+				dst[k] = lft[i] / rgt[j];		\
+				if (dst[k] < -GDK_##TYPE##_max ||	\
+				    dst[k] > GDK_##TYPE##_max) {	\
+					if (abort_on_error)		\
+						ON_OVERFLOW(TYPE, TYPE, "/"); \
+					dst[k] = TYPE##_nil;		\
+					nils++;				\
+				}					\
+			}						\
+			break;						\
+		}							\
+	}								\
+	return nils;							\
+}
+
+FUSE_INT(bte)
+FUSE_INT(sht)
+FUSE_INT(int)
+FUSE_INT(lng)
+#ifdef HAVE_HGE
+FUSE_INT(hge)
+#endif
+FUSE_FLT(flt)
+FUSE_FLT(dbl)
+
+static int
+fuse_parse(const char *expr, int nargs, struct fuseop *ops, int maxops)
+{
+	int nops = 0, depth = 0;
+
+	while (*expr) {
+		if (*expr == ' ') {
+			expr++;
+			continue;
+		}
+		if (nops == maxops)
+			return -1;
+		if (isdigit((unsigned char) *expr)) {
+			char *e;
+			long n = strtol(expr, &e, 10);
+			if (n >= nargs)
+				return -1;
+			ops[nops++] = (struct fuseop) {.op = 0, .arg = (int) n};
+			expr = e;
+			if (++depth > FUSE_MAXDEPTH)
+				return -1;
+		} else {
+			if (strchr("+-*/", *expr) == NULL || depth < 2)
+				return -1;
+			ops[nops++] = (struct fuseop) {.op = *expr++};
+			depth--;
+		}
+		if (*expr != ' ' && *expr != 0)
+			return -1;
+	}
+	return depth == 1 && nops > 1 ? nops : -1;
+}
+
+BAT *
+BATcalcfused(const char *expr, int nargs, BAT **b, const ValRecord *v,
+	     int tp, bool abort_on_error)
+{
+	struct fuseop ops[FUSE_MAXOPS];
+	int nops;
+	BAT *bn, *b0 = NULL;
+	BUN cnt, nils = 0;
+	char *scratch;
+	size_t width = ATOMsize(tp);
+	struct {
+		const char *p;	/* pointer to first value */
+		int incr;	/* 1 for vectors, 0 for constants */
+	} stack[FUSE_MAXDEPTH];
+
+	nops = fuse_parse(expr, nargs, ops, FUSE_MAXOPS);
+	if (nops < 0) {
+		GDKerror("%s: invalid expression \"%s\".\n", __func__, expr);
+		return NULL;
+	}
+	switch (ATOMbasetype(tp)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		break;
+	default:
+		GDKerror("%s: type %s not supported.\n", __func__, ATOMname(tp));
+		return NULL;
+	}
+	for (int i = 0; i < nargs; i++) {
+		if (b[i] ? ATOMbasetype(b[i]->ttype) != ATOMbasetype(tp) :
+		    ATOMbasetype(v[i].vtype) != ATOMbasetype(tp)) {
+			GDKerror("%s: operands must all be of type %s.\n",
+				 __func__, ATOMname(tp));
+			return NULL;
+		}
+		if (b[i] == NULL)
+			continue;
+		if (b0 == NULL) {
+			b0 = b[i];
+		} else if (BATcount(b[i]) != BATcount(b0) ||
+			   b[i]->hseqbase != b0->hseqbase) {
+			GDKerror("%s: inputs not the same size.\n", __func__);
+			return NULL;
+		}
+	}
+	if (b0 == NULL) {
+		GDKerror("%s: at least one operand must be a BAT.\n", __func__);
+		return NULL;
+	}
+
+	cnt = BATcount(b0);
+	bn = COLnew(b0->hseqbase, tp, cnt, TRANSIENT);
+	if (bn == NULL)
+		return NULL;
+	scratch = GDKmalloc(FUSE_MAXDEPTH * FUSE_VECSIZE * width);
+	if (scratch == NULL) {
+		BBPunfix(bn->batCacheid);
+		return NULL;
+	}
+
+	for (BUN lo = 0; lo < cnt; lo += FUSE_VECSIZE) {
+		BUN n = cnt - lo < FUSE_VECSIZE ? cnt - lo : FUSE_VECSIZE;
+		int depth = 0;
+
+		for (int k = 0; k < nops; k++) {
+			if (ops[k].op == 0) {
+				int a = ops[k].arg;
+				if (b[a]) {
+					stack[depth].p = (const char *) Tloc(b[a], lo);
+					stack[depth].incr = 1;
+				} else {
+					stack[depth].p = VALptr(&v[a]);
+					stack[depth].incr = 0;
+				}
+				depth++;
+				continue;
+			}
+			depth--;
+			/* the last operator writes straight into
+			 * the result, the others into the scratch
+			 * vector of their stack position */
+			char *dst = k == nops - 1 ?
+				(char *) Tloc(bn, lo) :
+				scratch + (depth - 1) * FUSE_VECSIZE * width;
+			const char *lft = stack[depth - 1].p;
+			const char *rgt = stack[depth].p;
+			int incr1 = stack[depth - 1].incr;
+			int incr2 = stack[depth].incr;
+			BUN nn;
+
+			switch (ATOMbasetype(tp)) {
+			case TYPE_bte:
+				nn = fuse_bte(ops[k].op, (const bte *) lft, incr1, (const bte *) rgt, incr2, (bte *) dst, n, abort_on_error);
+				break;
+			case TYPE_sht:
+				nn = fuse_sht(ops[k].op, (const sht *) lft, incr1, (const sht *) rgt, incr2, (sht *) dst, n, abort_on_error);
+				break;
+			case TYPE_int:
+				nn = fuse_int(ops[k].op, (const int *) lft, incr1, (const int *) rgt, incr2, (int *) dst, n, abort_on_error);
+				break;
+			case TYPE_lng:
+				nn = fuse_lng(ops[k].op, (const lng *) lft, incr1, (const lng *) rgt, incr2, (lng *) dst, n, abort_on_error);
+				break;
+#ifdef HAVE_HGE
+			case TYPE_hge:
+				nn = fuse_hge(ops[k].op, (const hge *) lft, incr1, (const hge *) rgt, incr2, (hge *) dst, n, abort_on_error);
+				break;
+#endif
+			case TYPE_flt:
+				nn = fuse_flt(ops[k].op, (const flt *) lft, incr1, (const flt *) rgt, incr2, (flt *) dst, n, abort_on_error);
+				break;
+			default:
+				nn = fuse_dbl(ops[k].op, (const dbl *) lft, incr1, (const dbl *) rgt, incr2, (dbl *) dst, n, abort_on_error);
+				break;
+			}
+			if (nn >= BUN_NONE) {
+				if (nn == BUN_NONE + 1)
+					GDKerror("22012!division by zero.\n");
+				GDKfree(scratch);
+				BBPunfix(bn->batCacheid);
+				return NULL;
+			}
+			if (k == nops - 1)
+				nils += nn;
+			stack[depth - 1].p = dst;
+			stack[depth - 1].incr = 1;
+		}
+	}
+	GDKfree(scratch);
+
+	BATsetcount(bn, cnt);
+	bn->tsorted = cnt <= 1 || nils == cnt;
+	bn->trevsorted = cnt <= 1 || nils == cnt;
+	bn->tkey = cnt <= 1;
+	bn->tnil = nils != 0;
+	bn->tnonil = nils == 0;
+
+	return bn;
+}
+
 /* ---------------------------------------------------------------------- */
 /* logical (for type bit) or bitwise (for integral types) exclusive OR */
 
@@ -12298,8 +12867,44 @@ VARcalcrsh(ValPtr ret, const ValRecord *lft, const ValRecord *rgt,
 			   between3(v, hi, hinc, lo, linc, TYPE))	\
 		     : between3(v, lo, linc, hi, hinc, TYPE))))
 
+/* without nils and with all values to be calculated, the
+ * three-valued logic is not needed and the loop can be vectorized */
+#define BETWEEN_NONIL(v, lo, hi)					\
+	((bit) (((((v) > (lo)) | (linc & ((v) == (lo)))) &		\
+		 (((v) < (hi)) | (hinc & ((v) == (hi))))) ^ anti))
+
+#define BETWEEN_LOOP_TYPE_nonil(TYPE)					\
+	do {								\
+		const TYPE *restrict vp = (const TYPE *) src;		\
+		const TYPE *restrict lp = (const TYPE *) lo;		\
+		const TYPE *restrict hp = (const TYPE *) hi;		\
+									\
+		assert(ci->ncand == cnt);				\
+		assert(incr1 == 1);					\
+		if (incr2 && incr3) {					\
+			for (l = 0; l < cnt; l++)			\
+				dst[l] = BETWEEN_NONIL(vp[l], lp[l], hp[l]); \
+		} else if (incr2) {					\
+			const TYPE h = hp[0];				\
+			for (l = 0; l < cnt; l++)			\
+				dst[l] = BETWEEN_NONIL(vp[l], lp[l], h); \
+		} else if (incr3) {					\
+			const TYPE lw = lp[0];				\
+			for (l = 0; l < cnt; l++)			\
+				dst[l] = BETWEEN_NONIL(vp[l], lw, hp[l]); \
+		} else {						\
+			const TYPE lw = lp[0], h = hp[0];		\
+			for (l = 0; l < cnt; l++)			\
+				dst[l] = BETWEEN_NONIL(vp[l], lw, h);	\
+		}							\
+	} while (0)
+
 #define BETWEEN_LOOP_TYPE(TYPE)						\
 	do {								\
+		if (nonil && !symmetric) {				\
+			BETWEEN_LOOP_TYPE_nonil(TYPE);			\
+			break;						\
+		}							\
 		do {							\
 			while (l < x) {					\
 				dst[l++] = bit_nil;			\
@@ -12331,7 +12936,8 @@ BATcalcbetween_intern(const void *src, int incr1, const char *hp1, int wd1,
 		      const void *hi, int incr3, const char *hp3, int wd3,
 		      int tp, BUN cnt, struct canditer *restrict ci,
 		      oid seqbase, bool symmetric, bool anti,
-		      bool linc, bool hinc, bool nils_false, const char *func)
+		      bool linc, bool hinc, bool nils_false, bool nonil,
+		      const char *func)
 {
 	BAT *bn;
 	BUN nils = 0;
@@ -12473,7 +13079,10 @@ BATcalcbetween(BAT *b, BAT *lo, BAT *hi, BAT *s, bool symmetric,
 				   b->ttype, cnt,
 				   &ci,
 				   b->hseqbase, symmetric, anti, linc, hinc,
-				   nils_false, __func__);
+				   nils_false,
+				   cnt == ncand && b->tnonil &&
+				   lo->tnonil && hi->tnonil,
+				   __func__);
 
 	return bn;
 }
@@ -12510,6 +13119,9 @@ BATcalcbetweencstcst(BAT *b, const ValRecord *lo, const ValRecord *hi, BAT *s,
 				   &ci,
 				   b->hseqbase, symmetric, anti,
 				   linc, hinc, nils_false,
+				   cnt == ncand && b->tnonil &&
+				   ATOMcmp(lo->vtype, VALptr(lo), ATOMnilptr(lo->vtype)) != 0 &&
+				   ATOMcmp(hi->vtype, VALptr(hi), ATOMnilptr(hi->vtype)) != 0,
 				   __func__);
 
 	return bn;
@@ -12552,6 +13164,8 @@ BATcalcbetweenbatcst(BAT *b, BAT *lo, const ValRecord *hi, BAT *s,
 				   &ci,
 				   b->hseqbase, symmetric, anti,
 				   linc, hinc, nils_false,
+				   cnt == ncand && b->tnonil && lo->tnonil &&
+				   ATOMcmp(hi->vtype, VALptr(hi), ATOMnilptr(hi->vtype)) != 0,
 				   __func__);
 
 	return bn;
@@ -12594,6 +13208,8 @@ BATcalcbetweencstbat(BAT *b, const ValRecord *lo, BAT *hi, BAT *s,
 				   &ci,
 				   b->hseqbase, symmetric, anti,
 				   linc, hinc, nils_false,
+				   cnt == ncand && b->tnonil && hi->tnonil &&
+				   ATOMcmp(lo->vtype, VALptr(lo), ATOMnilptr(lo->vtype)) != 0,
 				   __func__);
 
 	return bn;
@@ -12657,8 +13273,37 @@ VARcalcbetween(ValPtr ret, const ValRecord *v, const ValRecord *lo,
 /* ---------------------------------------------------------------------- */
 /* if-then-else (any type) */
 
+/* if the condition has no nils, this is a simple selection between
+ * two values which the compiler can do without branches */
+#define IFTHENELSELOOP_nonil(TYPE)					\
+	do {								\
+		const TYPE *restrict c1 = (const TYPE *) col1;		\
+		const TYPE *restrict c2 = (const TYPE *) col2;		\
+		TYPE *restrict d = (TYPE *) dst;			\
+									\
+		if (incr1 && incr2) {					\
+			for (i = 0; i < cnt; i++)			\
+				d[i] = src[i] ? c1[i] : c2[i];		\
+		} else if (incr1) {					\
+			const TYPE v2 = c2[0];				\
+			for (i = 0; i < cnt; i++)			\
+				d[i] = src[i] ? c1[i] : v2;		\
+		} else if (incr2) {					\
+			const TYPE v1 = c1[0];				\
+			for (i = 0; i < cnt; i++)			\
+				d[i] = src[i] ? v1 : c2[i];		\
+		} else {						\
+			const TYPE v1 = c1[0], v2 = c2[0];		\
+			for (i = 0; i < cnt; i++)			\
+				d[i] = src[i] ? v1 : v2;		\
+		}							\
+	} while (0)
 #define IFTHENELSELOOP(TYPE)						\
 	do {								\
+		if (b->tnonil) {					\
+			IFTHENELSELOOP_nonil(TYPE);			\
+			break;						\
+		}							\
 		for (i = 0; i < cnt; i++) {				\
 			if (is_bit_nil(src[i])) {			\
 				((TYPE *) dst)[i] = * (TYPE *) nil;	\
@@ -12880,6 +13525,636 @@ BATcalcifthencstelsecst(BAT *b, const ValRecord *c1, const ValRecord *c2)
 					c1->vtype);
 }
 
+/* ---------------------------------------------------------------------- */
+/* predicates evaluated into bit masks (numeric types) */
+
+/* A predicate is a boolean expression over a number of aligned BATs
+ * and constants, consisting of comparisons and logical operators.  It
+ * is given in postfix notation as a string of space separated tokens,
+ * where a number refers to an operand (b[n] if it is not NULL,
+ * otherwise v[n]) and the other tokens are the comparison operators
+ * <, <=, ==, !=, >, >= and the logical operators and, or, not and
+ * istrue (nil becomes false), e.g. "0 1 < 2 3 == or" for
+ * (b0 < b1) or (b2 == v3).  Operands of a logical operator must be of
+ * type bit, operands of a comparison of the same numeric type.
+ *
+ * Instead of one bit value per row, the predicate is evaluated into
+ * two bit masks with one bit per row: one for the rows for which the
+ * predicate is true, one for the rows for which it is nil.  This takes
+ * a quarter of the space of the bit values and allows the logical
+ * operators to process 32 rows at a time.  The evaluation is done in
+ * vectors of MASK_VECSIZE rows so that the masks never leave the
+ * cache; the masks are consumed directly by BATmaskselect and
+ * BATmaskifthenelse.  The semantics are those of BATcalclt and friends
+ * followed by BATcalcand etc., i.e. three valued logic. */
+
+#define MASK_VECSIZE	1024
+#define MASK_VECWORDS	(MASK_VECSIZE / 32)
+#define MASK_MAXDEPTH	16
+#define MASK_MAXOPS	128
+
+struct maskop {
+	char op;		/* 0 for operand, otherwise operator */
+	int arg;		/* operand number */
+};
+
+/* compare 32 rows at a time, producing a word of each mask */
+#define MASK_CMP_WORDS(TYPE, OP, L, R)					\
+	do {								\
+		for (BUN w = 0; w * 32 < n; w++) {			\
+			uint32_t tm = 0, nm = 0;			\
+			BUN e = n - w * 32 < 32 ? n - w * 32 : 32;	\
+			for (BUN j = 0; j < e; j++) {			\
+				const BUN i = w * 32 + j;		\
+				const TYPE x = L, y = R;		\
+				nm |= (uint32_t) (is_##TYPE##_nil(x) |	\
+						  is_##TYPE##_nil(y)) << j; \
+				tm |= (uint32_t) (x OP y) << j;		\
+			}						\
+			tw[w] = tm & ~nm;				\
+			nw[w] = nm;					\
+		}							\
+	} while (0)
+#define MASK_CMP_LOOP(TYPE, OP)						\
+	do {								\
+		if (incr1 && incr2) {					\
+			MASK_CMP_WORDS(TYPE, OP, lft[i], rgt[i]);	\
+		} else if (incr1) {					\
+			const TYPE r = rgt[0];				\
+			MASK_CMP_WORDS(TYPE, OP, lft[i], r);		\
+		} else {						\
+			const TYPE l = lft[0];				\
+			MASK_CMP_WORDS(TYPE, OP, l, rgt[i]);		\
+		}							\
+	} while (0)
+#define MASK_CMP(TYPE)							\
+static void								\
+maskcmp_##TYPE(char op, const TYPE *restrict lft, int incr1,		\
+	       const TYPE *restrict rgt, int incr2,			\
+	       uint32_t *restrict tw, uint32_t *restrict nw, BUN n)	\
+{									\
+	switch (op) {							\
+	case '<':							\
+		MASK_CMP_LOOP(TYPE, <);					\
+		break;							\
+	case 'l':							\
+		MASK_CMP_LOOP(TYPE, <=);				\
+		break;							\
+	case '>':							\
+		MASK_CMP_LOOP(TYPE, >);					\
+		break;							\
+	case 'g':							\
+		MASK_CMP_LOOP(TYPE, >=);				\
+		break;							\
+	case '=':							\
+		MASK_CMP_LOOP(TYPE, ==);				\
+		break;							\
+	default:							\
+		assert(op == '!');					\
+		MASK_CMP_LOOP(TYPE, !=);				\
+		break;							\
+	}								\
+}
+
+MASK_CMP(bte)
+MASK_CMP(sht)
+MASK_CMP(int)
+MASK_CMP(lng)
+#ifdef HAVE_HGE
+MASK_CMP(hge)
+#endif
+MASK_CMP(flt)
+MASK_CMP(dbl)
+
+static const struct {
+	const char *name;
+	char op;
+} maskops[] = {
+	{"<", '<'}, {"<=", 'l'}, {">", '>'}, {">=", 'g'},
+	{"==", '='}, {"!=", '!'},
+	{"and", '&'}, {"or", '|'}, {"not", '~'}, {"istrue", 't'},
+};
+
+static bool
+mask_cmptype(int tp)
+{
+	switch (ATOMstorage(tp)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Parse the predicate and check the types of the operands.  Returns
+ * the number of operations, or -1 if the predicate is invalid. */
+static int
+mask_parse(const char *expr, int nargs, BAT **b, const ValRecord *v,
+	   struct maskop *ops, int maxops)
+{
+	int nops = 0, depth = 0;
+	struct {
+		int tpe;	/* operand type, or -1 for a predicate */
+		bool cst;	/* operand is a constant */
+	} stack[MASK_MAXDEPTH];
+
+	while (*expr) {
+		if (*expr == ' ') {
+			expr++;
+			continue;
+		}
+		if (nops == maxops)
+			return -1;
+		if (isdigit((unsigned char) *expr)) {
+			char *e;
+			long n = strtol(expr, &e, 10);
+			if (n >= nargs || depth == MASK_MAXDEPTH)
+				return -1;
+			ops[nops++] = (struct maskop) {.op = 0, .arg = (int) n};
+			stack[depth].tpe = b[n] ? b[n]->ttype : v[n].vtype;
+			stack[depth].cst = b[n] == NULL;
+			depth++;
+			expr = e;
+		} else {
+			size_t len = strcspn(expr, " ");
+			char op = 0;
+			for (size_t i = 0; i < sizeof(maskops) / sizeof(maskops[0]); i++)
+				if (strlen(maskops[i].name) == len &&
+				    strncmp(maskops[i].name, expr, len) == 0) {
+					op = maskops[i].op;
+					break;
+				}
+			switch (op) {
+			case 0:
+				return -1;
+			case '~':
+			case 't':
+				if (depth < 1 ||
+				    (stack[depth - 1].tpe != -1 &&
+				     stack[depth - 1].tpe != TYPE_bit))
+					return -1;
+				break;
+			case '&':
+			case '|':
+				if (depth < 2 ||
+				    (stack[depth - 1].tpe != -1 &&
+				     stack[depth - 1].tpe != TYPE_bit) ||
+				    (stack[depth - 2].tpe != -1 &&
+				     stack[depth - 2].tpe != TYPE_bit))
+					return -1;
+				depth--;
+				break;
+			default:
+				if (depth < 2 ||
+				    stack[depth - 1].tpe == -1 ||
+				    stack[depth - 2].tpe == -1 ||
+				    ATOMbasetype(stack[depth - 1].tpe) != ATOMbasetype(stack[depth - 2].tpe) ||
+				    !mask_cmptype(stack[depth - 1].tpe) ||
+				    (stack[depth - 1].cst && stack[depth - 2].cst))
+					return -1;
+				depth--;
+				break;
+			}
+			ops[nops++] = (struct maskop) {.op = op};
+			stack[depth - 1].tpe = -1;
+			stack[depth - 1].cst = false;
+			expr += len;
+		}
+		if (*expr != ' ' && *expr != 0)
+			return -1;
+	}
+	if (depth != 1 || (stack[0].tpe != -1 && stack[0].tpe != TYPE_bit))
+		return -1;
+	return nops;
+}
+
+/* convert bit values to masks */
+static void
+mask_frombit(const bit *src, int incr, uint32_t *restrict tw,
+	     uint32_t *restrict nw, BUN n)
+{
+	for (BUN w = 0; w * 32 < n; w++) {
+		uint32_t tm = 0, nm = 0;
+		BUN e = n - w * 32 < 32 ? n - w * 32 : 32;
+		for (BUN j = 0; j < e; j++) {
+			const bit x = src[(w * 32 + j) * incr];
+			nm |= (uint32_t) is_bit_nil(x) << j;
+			tm |= (uint32_t) (x != 0 && !is_bit_nil(x)) << j;
+		}
+		tw[w] = tm;
+		nw[w] = nm;
+	}
+}
+
+struct maskpred {
+	const struct maskop *ops;
+	int nops;
+	BAT **b;
+	const ValRecord *v;
+	uint32_t *scratch;	/* MASK_MAXDEPTH pairs of masks */
+};
+
+/* Evaluate the predicate for the n (<= MASK_VECSIZE) rows starting at
+ * row lo; on return *tp and *np point to the masks of the true and nil
+ * rows.  Bits beyond n in the last word are zero. */
+static void
+mask_eval(const struct maskpred *pred, BUN lo, BUN n,
+	  const uint32_t **tp, const uint32_t **np)
+{
+	struct {
+		const char *p;	/* pointer to first value, NULL for masks */
+		int incr;	/* 1 for vectors, 0 for constants */
+		int tpe;
+		uint32_t *t, *n;
+	} stack[MASK_MAXDEPTH];
+	const BUN nw = (n + 31) / 32;
+	int depth = 0;
+
+	for (int k = 0; k < pred->nops; k++) {
+		int op = pred->ops[k].op;
+
+		if (op == 0) {
+			int a = pred->ops[k].arg;
+			if (pred->b[a]) {
+				stack[depth].p = (const char *) Tloc(pred->b[a], lo);
+				stack[depth].incr = 1;
+				stack[depth].tpe = pred->b[a]->ttype;
+			} else {
+				stack[depth].p = VALptr(&pred->v[a]);
+				stack[depth].incr = 0;
+				stack[depth].tpe = pred->v[a].vtype;
+			}
+			stack[depth].t = pred->scratch + depth * 2 * MASK_VECWORDS;
+			stack[depth].n = stack[depth].t + MASK_VECWORDS;
+			depth++;
+			continue;
+		}
+		if (op == '&' || op == '|' || op == '~' || op == 't') {
+			/* logical operators work on masks */
+			for (int d = depth - (op == '&' || op == '|' ? 2 : 1); d < depth; d++) {
+				if (stack[d].p) {
+					mask_frombit((const bit *) stack[d].p, stack[d].incr, stack[d].t, stack[d].n, n);
+					stack[d].p = NULL;
+				}
+			}
+		}
+		uint32_t *t1 = stack[depth - 1].t, *n1 = stack[depth - 1].n;
+		switch (op) {
+		case 't':
+			for (BUN w = 0; w < nw; w++)
+				n1[w] = 0;
+			break;
+		case '~':
+			for (BUN w = 0; w < nw; w++)
+				t1[w] = ~(t1[w] | n1[w]);
+			if (n % 32)
+				t1[nw - 1] &= ((uint32_t) 1 << (n % 32)) - 1;
+			break;
+		case '&': {
+			uint32_t *restrict t0 = stack[depth - 2].t;
+			uint32_t *restrict n0 = stack[depth - 2].n;
+			/* nil unless one of the operands is false */
+			for (BUN w = 0; w < nw; w++) {
+				n0[w] = (n0[w] | n1[w]) & (t0[w] | n0[w]) & (t1[w] | n1[w]);
+				t0[w] &= t1[w];
+			}
+			depth--;
+			break;
+		}
+		case '|': {
+			uint32_t *restrict t0 = stack[depth - 2].t;
+			uint32_t *restrict n0 = stack[depth - 2].n;
+			/* nil unless one of the operands is true */
+			for (BUN w = 0; w < nw; w++) {
+				t0[w] |= t1[w];
+				n0[w] = (n0[w] | n1[w]) & ~t0[w];
+			}
+			depth--;
+			break;
+		}
+		default: {
+			const char *lft = stack[depth - 2].p;
+			const char *rgt = stack[depth - 1].p;
+			int incr1 = stack[depth - 2].incr;
+			int incr2 = stack[depth - 1].incr;
+			uint32_t *t0 = stack[depth - 2].t, *n0 = stack[depth - 2].n;
+
+			switch (ATOMstorage(stack[depth - 2].tpe)) {
+			case TYPE_bte:
+				maskcmp_bte(op, (const bte *) lft, incr1, (const bte *) rgt, incr2, t0, n0, n);
+				break;
+			case TYPE_sht:
+				maskcmp_sht(op, (const sht *) lft, incr1, (const sht *) rgt, incr2, t0, n0, n);
+				break;
+			case TYPE_int:
+				maskcmp_int(op, (const int *) lft, incr1, (const int *) rgt, incr2, t0, n0, n);
+				break;
+			case TYPE_lng:
+				maskcmp_lng(op, (const lng *) lft, incr1, (const lng *) rgt, incr2, t0, n0, n);
+				break;
+#ifdef HAVE_HGE
+			case TYPE_hge:
+				maskcmp_hge(op, (const hge *) lft, incr1, (const hge *) rgt, incr2, t0, n0, n);
+				break;
+#endif
+			case TYPE_flt:
+				maskcmp_flt(op, (const flt *) lft, incr1, (const flt *) rgt, incr2, t0, n0, n);
+				break;
+			default:
+				maskcmp_dbl(op, (const dbl *) lft, incr1, (const dbl *) rgt, incr2, t0, n0, n);
+				break;
+			}
+			stack[depth - 2].p = NULL;
+			depth--;
+			break;
+		}
+		}
+	}
+	assert(depth == 1);
+	if (stack[0].p) {
+		/* the predicate is a single bit operand */
+		mask_frombit((const bit *) stack[0].p, stack[0].incr, stack[0].t, stack[0].n, n);
+	}
+	*tp = stack[0].t;
+	*np = stack[0].n;
+}
+
+/* Check the predicate and its operands, and return the BAT that
+ * determines the size and alignment of the result, or NULL on error. */
+static BAT *
+mask_init(struct maskpred *pred, struct maskop *ops, const char *expr,
+	  int nargs, BAT **b, const ValRecord *v, const char *func)
+{
+	BAT *b0 = NULL;
+
+	pred->nops = mask_parse(expr, nargs, b, v, ops, MASK_MAXOPS);
+	if (pred->nops < 0) {
+		GDKerror("%s: invalid predicate \"%s\".\n", func, expr);
+		return NULL;
+	}
+	for (int i = 0; i < nargs; i++) {
+		if (b[i] == NULL)
+			continue;
+		if (b[i]->ttype == TYPE_void) {
+			GDKerror("%s: type %s not supported.\n", func, ATOMname(TYPE_void));
+			return NULL;
+		}
+		if (b0 == NULL) {
+			b0 = b[i];
+		} else if (BATcount(b[i]) != BATcount(b0) ||
+			   b[i]->hseqbase != b0->hseqbase) {
+			GDKerror("%s: inputs not the same size.\n", func);
+			return NULL;
+		}
+	}
+	if (b0 == NULL) {
+		GDKerror("%s: at least one operand must be a BAT.\n", func);
+		return NULL;
+	}
+	pred->scratch = GDKmalloc(MASK_MAXDEPTH * 2 * MASK_VECWORDS * sizeof(uint32_t));
+	if (pred->scratch == NULL)
+		return NULL;
+	pred->ops = ops;
+	pred->b = b;
+	pred->v = v;
+	return b0;
+}
+
+/* Return a candidate list with the rows of candidate list s (all rows
+ * if s is NULL) for which the predicate is true. */
+BAT *
+BATmaskselect(const char *expr, int nargs, BAT **b, const ValRecord *v,
+	      BAT *s)
+{
+	struct maskop ops[MASK_MAXOPS];
+	struct maskpred pred;
+	struct canditer ci;
+	const uint32_t *tw, *nw;
+	BAT *bn, *b0;
+	BUN cnt, ncand, i = 0, r = 0;
+	oid hseq;
+	oid *restrict dst;
+
+	b0 = mask_init(&pred, ops, expr, nargs, b, v, __func__);
+	if (b0 == NULL)
+		return NULL;
+	hseq = b0->hseqbase;
+	cnt = BATcount(b0);
+	ncand = canditer_init(&ci, b0, s);
+	bn = COLnew(0, TYPE_oid, ncand < MASK_VECSIZE ? ncand : MASK_VECSIZE, TRANSIENT);
+	if (bn == NULL) {
+		GDKfree(pred.scratch);
+		return NULL;
+	}
+	dst = (oid *) Tloc(bn, 0);
+
+	while (i < ncand) {
+		/* the next vector starts at the next candidate; with a
+		 * dense candidate list, all of its rows are candidates */
+		BUN lo = canditer_idx(&ci, i) - hseq;
+		BUN n = cnt - lo < MASK_VECSIZE ? cnt - lo : MASK_VECSIZE;
+
+		if (ci.tpe == cand_dense && ncand - i < n)
+			n = ncand - i;
+		mask_eval(&pred, lo, n, &tw, &nw);
+		if (BATcapacity(bn) - r < n) {
+			BATsetcount(bn, r);
+			if (BATextend(bn, BATcapacity(bn) + MAX(BATcapacity(bn), n)) != GDK_SUCCEED) {
+				BBPreclaim(bn);
+				GDKfree(pred.scratch);
+				return NULL;
+			}
+			dst = (oid *) Tloc(bn, 0);
+		}
+		if (ci.tpe == cand_dense) {
+			for (BUN w = 0; w * 32 < n; w++) {
+				uint32_t m = tw[w];
+				if (n - w * 32 < 32)
+					m &= ((uint32_t) 1 << (n - w * 32)) - 1;
+				for (BUN j = w * 32; m; j++, m >>= 1)
+					if (m & 1)
+						dst[r++] = hseq + lo + j;
+			}
+			i += n;
+		} else {
+			oid o;
+			while (i < ncand && (o = canditer_idx(&ci, i) - hseq) < lo + n) {
+				o -= lo;
+				if (tw[o / 32] & ((uint32_t) 1 << (o % 32)))
+					dst[r++] = hseq + lo + o;
+				i++;
+			}
+		}
+	}
+	GDKfree(pred.scratch);
+
+	BATsetcount(bn, r);
+	bn->tsorted = true;
+	bn->trevsorted = r <= 1;
+	bn->tkey = true;
+	bn->tnil = false;
+	bn->tnonil = true;
+	return virtualize(bn);
+}
+
+#define MASKIFTHENELSELOOP(TYPE)					\
+	do {								\
+		const TYPE *restrict c1 = (const TYPE *) col1;		\
+		const TYPE *restrict c2 = (const TYPE *) col2;		\
+		TYPE *restrict d = (TYPE *) Tloc(bn, lo);		\
+		const TYPE nv = * (const TYPE *) nil;			\
+									\
+		for (i = 0; i < n; i++) {				\
+			const uint32_t m = (uint32_t) 1 << (i % 32);	\
+			if (nw[i / 32] & m) {				\
+				d[i] = nv;				\
+				nils++;					\
+			} else {					\
+				d[i] = tw[i / 32] & m ? c1[(lo + i) * incr1] : c2[(lo + i) * incr2]; \
+			}						\
+		}							\
+	} while (0)
+
+/* Return a BAT with for each row the value of b1 (or c1 if b1 is NULL)
+ * if the predicate is true, of b2 (or c2) if it is false, and nil if
+ * it is nil. */
+BAT *
+BATmaskifthenelse(const char *expr, int nargs, BAT **b, const ValRecord *v,
+		  BAT *b1, const ValRecord *c1, BAT *b2, const ValRecord *c2)
+{
+	struct maskop ops[MASK_MAXOPS];
+	struct maskpred pred;
+	const uint32_t *tw, *nw;
+	BAT *bn, *b0;
+	BUN cnt, i, nils = 0;
+	int tpe = b1 ? b1->ttype : c1->vtype;
+	const void *col1, *col2, *nil = ATOMnilptr(tpe);
+	const char *heap1 = NULL, *heap2 = NULL;
+	int incr1 = b1 != NULL, incr2 = b2 != NULL;
+	int width1 = 0, width2 = 0;
+
+	if (ATOMtype(tpe) != ATOMtype(b2 ? b2->ttype : c2->vtype)) {
+		GDKerror("%s: \"then\" and \"else\" BATs have different types.\n", __func__);
+		return NULL;
+	}
+	if ((b1 && b1->ttype == TYPE_void) || (b2 && b2->ttype == TYPE_void)) {
+		GDKerror("%s: type %s not supported.\n", __func__, ATOMname(TYPE_void));
+		return NULL;
+	}
+	b0 = mask_init(&pred, ops, expr, nargs, b, v, __func__);
+	if (b0 == NULL)
+		return NULL;
+	cnt = BATcount(b0);
+	if ((b1 && checkbats(b0, b1, __func__) != GDK_SUCCEED) ||
+	    (b2 && checkbats(b0, b2, __func__) != GDK_SUCCEED)) {
+		GDKfree(pred.scratch);
+		return NULL;
+	}
+	if (b1) {
+		col1 = Tloc(b1, 0);
+		heap1 = b1->tvheap ? b1->tvheap->base : NULL;
+		width1 = b1->twidth;
+	} else {
+		col1 = VALptr(c1);
+	}
+	if (b2) {
+		col2 = Tloc(b2, 0);
+		heap2 = b2->tvheap ? b2->tvheap->base : NULL;
+		width2 = b2->twidth;
+	} else {
+		col2 = VALptr(c2);
+	}
+
+	bn = COLnew(b0->hseqbase, ATOMtype(tpe), cnt, TRANSIENT);
+	if (bn == NULL) {
+		GDKfree(pred.scratch);
+		return NULL;
+	}
+
+	for (BUN lo = 0; lo < cnt; lo += MASK_VECSIZE) {
+		BUN n = cnt - lo < MASK_VECSIZE ? cnt - lo : MASK_VECSIZE;
+
+		mask_eval(&pred, lo, n, &tw, &nw);
+		if (bn->tvarsized) {
+			for (i = 0; i < n; i++) {
+				const uint32_t m = (uint32_t) 1 << (i % 32);
+				const void *p;
+				if (nw[i / 32] & m) {
+					p = nil;
+					nils++;
+				} else if (tw[i / 32] & m) {
+					p = heap1 ? heap1 + VarHeapVal(col1, lo + i, width1) : col1;
+				} else {
+					p = heap2 ? heap2 + VarHeapVal(col2, lo + i, width2) : col2;
+				}
+				tfastins_nocheckVAR(bn, lo + i, p, Tsize(bn));
+			}
+			continue;
+		}
+		switch (bn->twidth) {
+		case 1:
+			MASKIFTHENELSELOOP(bte);
+			break;
+		case 2:
+			MASKIFTHENELSELOOP(sht);
+			break;
+		case 4:
+			MASKIFTHENELSELOOP(int);
+			break;
+		case 8:
+			MASKIFTHENELSELOOP(lng);
+			break;
+#ifdef HAVE_HGE
+		case 16:
+			MASKIFTHENELSELOOP(hge);
+			break;
+#endif
+		default: {
+			const size_t width = bn->twidth;
+			char *d = (char *) Tloc(bn, lo);
+			for (i = 0; i < n; i++) {
+				const uint32_t m = (uint32_t) 1 << (i % 32);
+				const void *p;
+				if (nw[i / 32] & m) {
+					p = nil;
+					nils++;
+				} else if (tw[i / 32] & m) {
+					p = (const char *) col1 + (lo + i) * incr1 * width;
+				} else {
+					p = (const char *) col2 + (lo + i) * incr2 * width;
+				}
+				memcpy(d + i * width, p, width);
+			}
+			break;
+		}
+		}
+	}
+	GDKfree(pred.scratch);
+
+	BATsetcount(bn, cnt);
+	bn->theap.dirty = true;
+	bn->tsorted = cnt <= 1 || nils == cnt;
+	bn->trevsorted = cnt <= 1 || nils == cnt;
+	bn->tkey = cnt <= 1;
+	bn->tnil = nils != 0;
+	bn->tnonil = nils == 0 &&
+		(b1 ? b1->tnonil : !VALisnil(c1)) &&
+		(b2 ? b2->tnonil : !VALisnil(c2));
+	return bn;
+  bunins_failed:
+	GDKfree(pred.scratch);
+	BBPreclaim(bn);
+	return NULL;
+}
+
 /* ---------------------------------------------------------------------- */
 /* type conversion (cast) */
 
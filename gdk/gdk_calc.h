@@ -44,6 +44,7 @@ gdk_export BAT *BATcalccstdiv(const ValRecord *v, BAT *b, BAT *s, int tp, bool a
 gdk_export BAT *BATcalcmod(BAT *b1, BAT *b2, BAT *s, int tp, bool abort_on_error);
 gdk_export BAT *BATcalcmodcst(BAT *b, const ValRecord *v, BAT *s, int tp, bool abort_on_error);
 gdk_export BAT *BATcalccstmod(const ValRecord *v, BAT *b, BAT *s, int tp, bool abort_on_error);
+gdk_export BAT *BATcalcfused(const char *expr, int nargs, BAT **b, const ValRecord *v, int tp, bool abort_on_error);
 gdk_export BAT *BATcalcxor(BAT *b1, BAT *b2, BAT *s);
 gdk_export BAT *BATcalcxorcst(BAT *b, const ValRecord *v, BAT *s);
 gdk_export BAT *BATcalccstxor(const ValRecord *v, BAT *b, BAT *s);
@@ -89,6 +90,8 @@ gdk_export BAT *BATcalcifthenelse(BAT *b, BAT *b1, BAT *b2);
 gdk_export BAT *BATcalcifthenelsecst(BAT *b, BAT *b1, const ValRecord *c2);
 gdk_export BAT *BATcalcifthencstelse(BAT *b, const ValRecord *c1, BAT *b2);
 gdk_export BAT *BATcalcifthencstelsecst(BAT *b, const ValRecord *c1, const ValRecord *c2);
+gdk_export BAT *BATmaskselect(const char *expr, int nargs, BAT **b, const ValRecord *v, BAT *s);
+gdk_export BAT *BATmaskifthenelse(const char *expr, int nargs, BAT **b, const ValRecord *v, BAT *b1, const ValRecord *c1, BAT *b2, const ValRecord *c2);
 
 gdk_export gdk_return VARcalcnot(ValPtr ret, const ValRecord *v);
 gdk_export gdk_return VARcalcnegate(ValPtr ret, const ValRecord *v);
@@ -879,7 +879,8 @@ BATnegcands(BAT *dense_cands, BAT *odels)
 {
 	const char *nme;
 	Heap *dels;
-	BUN lo, hi;
+	BUN lo, hi, l, h, m, lo2;
+	oid seq, end;
 
 	assert(BATtdense(dense_cands));
 	assert(dense_cands->ttype == TYPE_void);
@@ -888,11 +889,48 @@ BATnegcands(BAT *dense_cands, BAT *odels)
 	if (BATcount(odels) == 0)
 		return GDK_SUCCEED;
 
-	lo = SORTfndfirst(odels, &dense_cands->tseqbase);
-	hi = SORTfndfirst(odels, &(oid) {dense_cands->tseqbase + BATcount(dense_cands)});
+	seq = dense_cands->tseqbase;
+	end = seq + BATcount(dense_cands);
+	lo = SORTfndfirst(odels, &seq);
+	hi = SORTfndfirst(odels, &end);
 	if (lo == hi)
 		return GDK_SUCCEED;
 
+	/* Deleted runs at the start or the end of the range need not
+	 * be stored as exceptions, we shrink the range instead.  This
+	 * way, e.g. deleting the oldest rows of a table still results
+	 * in a dense candidate list.  Since the deletes are sorted and
+	 * unique, the leading run is the longest prefix for which
+	 * odels[x] - seq == x - lo and the trailing run the longest
+	 * suffix for which end - odels[x] == hi - x, so both can be
+	 * found with a binary search. */
+	l = lo;
+	h = hi;
+	while (l < h) {
+		m = l + (h - l) / 2;
+		if (BUNtoid(odels, m) - seq == m - lo)
+			l = m + 1;
+		else
+			h = m;
+	}
+	lo2 = l;
+	h = hi;
+	while (lo2 < h) {
+		m = lo2 + (h - lo2) / 2;
+		if (end - BUNtoid(odels, m) == hi - m)
+			h = m;
+		else
+			lo2 = m + 1;
+	}
+	if (l > lo || h < hi) {
+		BATtseqbase(dense_cands, seq + (l - lo));
+		BATsetcount(dense_cands, BATcount(dense_cands) - (l - lo) - (hi - h));
+		lo = l;
+		hi = h;
+		if (lo == hi)
+			return GDK_SUCCEED;
+	}
+
 	nme = BBP_physical(dense_cands->batCacheid);
 	if ((dels = (Heap*)GDKzalloc(sizeof(Heap))) == NULL ||
 	    (dels->farmid = BBPselectfarm(dense_cands->batRole, dense_cands->ttype, varheap)) < 0){
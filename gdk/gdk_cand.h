@@ -62,6 +62,45 @@ canditer_next_except(struct canditer *ci)
 	}
 	return o;
 }
+/* return the length (at most n) of the next run of consecutive
+ * candidates and set *first to the first candidate of that run; the
+ * iterator is advanced past the run; return 0 if there are no more
+ * candidates */
+static inline BUN
+canditer_next_run(struct canditer *ci, oid *first, BUN n)
+{
+	BUN len;
+
+	if (n > ci->ncand - ci->next)
+		n = ci->ncand - ci->next;
+	if (n == 0)
+		return 0;
+	switch (ci->tpe) {
+	case cand_dense:
+		*first = ci->seq + ci->next;
+		ci->next += n;
+		return n;
+	case cand_materialized:
+		*first = ci->oids[ci->next];
+		for (len = 1; len < n; len++)
+			if (ci->oids[ci->next + len] != *first + len)
+				break;
+		ci->next += len;
+		return len;
+	case cand_except:
+		break;
+	}
+	oid o = ci->seq + ci->add + ci->next;
+	while (ci->add < ci->noids && o == ci->oids[ci->add]) {
+		ci->add++;
+		o++;
+	}
+	*first = o;
+	if (ci->add < ci->noids && ci->oids[ci->add] - o < n)
+		n = ci->oids[ci->add] - o;
+	ci->next += n;
+	return n;
+}
 #define canditer_search_dense(ci, o, next) ((o) < (ci)->seq ? next ? 0 : BUN_NONE : (o) >= (ci)->seq + (ci)->ncand ? next ? (ci)->ncand : BUN_NONE : (o) - (ci)->seq)
 
 
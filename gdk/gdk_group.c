@@ -40,7 +40,7 @@
  * is always created.  In other words, the groups argument may not be
  * NULL, but the extents and histo arguments may be NULL.
  *
- * There are six different implementations of the grouping code.
+ * There are seven different implementations of the grouping code.
  *
  * If it can be trivially determined that all groups are singletons,
  * we can produce the outputs trivially.
@@ -58,7 +58,11 @@
  *
  * If a hash table already exists on b, we can make use of it.
  *
- * Otherwise we build a partial hash table on the fly.
+ * Otherwise we build a partial hash table on the fly, unless that
+ * table does not fit in the memory budget we get from the memory
+ * broker: then we partition b (and g) on the hash value into
+ * transient BATs, group each partition separately, and renumber the
+ * groups so that the result is the same as with a single hash table.
  *
  * A decision should be made on the order in which grouping occurs.
  * Let |b| have << different values than |g| then the linked lists
@@ -549,9 +553,157 @@ pop(oid x)
 	)
 
 
+/* don't bother partitioning if the hash table is smaller than this */
+#define GRP_SPILLSIZE	((size_t) 1 << 24)
+#define GRP_MAXPARTS	256
+
+/* Reserve memory for the partial hash table for grouping cnt values
+ * of b; return the number of partitions to use if we didn't get
+ * enough, 0 if we can go ahead with a single hash table. */
+static int
+GRPspillparts(BAT *b, BUN cnt, size_t *reserved)
+{
+	BUN mask = MAX(HASHmask(cnt), 1 << 16);
+	size_t need = (BUNlast(b) + mask) * sizeof(BUN);
+	int nparts = 2;
+
+	*reserved = GDKmemreserve(need, 0);
+	if (*reserved >= need || need < GRP_SPILLSIZE ||
+	    b->ttype == TYPE_void)
+		return 0;
+	while (nparts < GRP_MAXPARTS && need / nparts > *reserved)
+		nparts <<= 1;
+	return nparts;
+}
+
+/* Group the candidates ci of b (and the groups grps aligned with
+ * them) in nparts partitions.  The group ids are written into gn,
+ * and, if requested, the extents and histogram are returned in new
+ * BATs in *enp and *hnp (replacing what was there).  Group ids are
+ * renumbered in order of first occurrence, which is what the other
+ * implementations produce. */
+static gdk_return
+GRPpartitioned(BAT *b, struct canditer *ci, const oid *grps, int nparts,
+	       BAT *gn, BAT **enp, BAT **hnp, oid *ngrpp)
+{
+	BAT *vals[GRP_MAXPARTS], *idxs[GRP_MAXPARTS], *gids[GRP_MAXPARTS];
+	BAT *firsts, *histo = NULL, *sorted = NULL, *order = NULL, *map = NULL;
+	BAT *en = NULL, *hn = NULL, *pg = NULL, *pe = NULL, *ph = NULL;
+	oid *restrict ngrps = (oid *) Tloc(gn, 0);
+	oid ngrp = 0;
+	BUN cnt = ci->ncand;
+	int i = 0;
+
+	if (HASHpartition(b, ci, grps, nparts, false, vals, idxs,
+			  grps ? gids : NULL) != GDK_SUCCEED)
+		return GDK_FAIL;
+	firsts = COLnew(0, TYPE_oid, 0, TRANSIENT);
+	if (firsts == NULL)
+		goto bunins_failed;
+	if (hnp && (histo = COLnew(0, TYPE_lng, 0, TRANSIENT)) == NULL)
+		goto bunins_failed;
+	for (i = 0; i < nparts; i++) {
+		const oid *restrict idx = (const oid *) Tloc(idxs[i], 0);
+		BUN n = BATcount(vals[i]), ne;
+
+		if (n > 0) {
+			if (BATgroup_internal(&pg, &pe, hnp ? &ph : NULL,
+					      vals[i], NULL,
+					      grps ? gids[i] : NULL,
+					      NULL, NULL, false, false) != GDK_SUCCEED)
+				goto bunins_failed;
+			for (BUN k = 0; k < n; k++)
+				ngrps[idx[k]] = ngrp + BUNtoid(pg, k);
+			ne = BATcount(pe);
+			for (BUN k = 0; k < ne; k++)
+				bunfastappTYPE(oid, firsts, &idx[BUNtoid(pe, k)]);
+			if (ph) {
+				for (BUN k = 0; k < ne; k++)
+					bunfastappTYPE(lng, histo, Tloc(ph, k));
+				BBPunfix(ph->batCacheid);
+				ph = NULL;
+			}
+			ngrp += ne;
+			BBPunfix(pg->batCacheid);
+			BBPunfix(pe->batCacheid);
+			pg = pe = NULL;
+		}
+		BBPunfix(vals[i]->batCacheid);
+		BBPunfix(idxs[i]->batCacheid);
+		vals[i] = idxs[i] = NULL;
+		if (grps) {
+			BBPunfix(gids[i]->batCacheid);
+			gids[i] = NULL;
+		}
+	}
+	/* number the groups in order of first occurrence */
+	firsts->tsorted = firsts->trevsorted = ngrp <= 1;
+	firsts->tkey = true;
+	firsts->tnonil = true;
+	firsts->tnil = false;
+	if (BATsort(&sorted, &order, NULL, firsts, NULL, NULL, false, false, false) != GDK_SUCCEED ||
+	    (map = COLnew(0, TYPE_oid, ngrp, TRANSIENT)) == NULL)
+		goto bunins_failed;
+	oid *restrict m = (oid *) Tloc(map, 0);
+	for (oid k = 0; k < ngrp; k++)
+		m[BUNtoid(order, k)] = k;
+	gn->tsorted = true;
+	for (BUN r = 0; r < cnt; r++) {
+		ngrps[r] = m[ngrps[r]];
+		if (r > 0 && ngrps[r] < ngrps[r - 1])
+			gn->tsorted = false;
+	}
+	if (enp) {
+		if ((en = COLnew(0, TYPE_oid, ngrp, TRANSIENT)) == NULL)
+			goto bunins_failed;
+		for (oid k = 0; k < ngrp; k++)
+			((oid *) Tloc(en, 0))[k] = canditer_idx(ci, BUNtoid(sorted, k));
+	}
+	if (hnp) {
+		if ((hn = COLnew(0, TYPE_lng, ngrp, TRANSIENT)) == NULL)
+			goto bunins_failed;
+		for (oid k = 0; k < ngrp; k++)
+			((lng *) Tloc(hn, 0))[k] = ((lng *) Tloc(histo, 0))[BUNtoid(order, k)];
+	}
+	BBPunfix(firsts->batCacheid);
+	BBPreclaim(histo);
+	BBPunfix(sorted->batCacheid);
+	BBPunfix(order->batCacheid);
+	BBPunfix(map->batCacheid);
+	if (enp) {
+		BBPreclaim(*enp);
+		*enp = en;
+	}
+	if (hnp) {
+		BBPreclaim(*hnp);
+		*hnp = hn;
+	}
+	*ngrpp = ngrp;
+	return GDK_SUCCEED;
+
+  bunins_failed:
+	for (; i < nparts; i++) {
+		BBPreclaim(vals[i]);
+		BBPreclaim(idxs[i]);
+		if (grps)
+			BBPreclaim(gids[i]);
+	}
+	BBPreclaim(firsts);
+	BBPreclaim(histo);
+	BBPreclaim(sorted);
+	BBPreclaim(order);
+	BBPreclaim(map);
+	BBPreclaim(en);
+	BBPreclaim(pg);
+	BBPreclaim(pe);
+	BBPreclaim(ph);
+	return GDK_FAIL;
+}
+
 gdk_return
 BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
-		  BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted)
+		  BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted,
+		  bool spill)
 {
 	BAT *gn = NULL, *en = NULL, *hn = NULL;
 	int t;
@@ -572,6 +724,8 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 	struct canditer ci;
 	oid maxgrp = oid_nil;	/* maximum value of g BAT (if subgrouping) */
 	PROPrec *prop;
+	size_t reserved = 0;	/* budget from the memory broker */
+	int nparts;
 
 	if (b == NULL) {
 		GDKerror("BATgroup: b must exist\n");
@@ -1043,6 +1197,27 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 			GRP_use_existing_hash_table_any();
 			break;
 		}
+	} else if (spill &&
+		   (nparts = GRPspillparts(b, cnt, &reserved)) > 0) {
+		/* the partial hash table doesn't fit in our memory
+		 * budget, group the input in partitions */
+		ALGODEBUG fprintf(stderr, "#BATgroup(b=%s#" BUNFMT "[%s],"
+				  "s=%s#" BUNFMT ","
+				  "g=%s#" BUNFMT ","
+				  "e=%s#" BUNFMT ","
+				  "h=%s#" BUNFMT ",subsorted=%d): "
+				  "partitioned in %d (budget %zu)\n",
+				  BATgetId(b), BATcount(b), ATOMname(b->ttype),
+				  s ? BATgetId(s) : "NULL", s ? BATcount(s) : 0,
+				  g ? BATgetId(g) : "NULL", g ? BATcount(g) : 0,
+				  e ? BATgetId(e) : "NULL", e ? BATcount(e) : 0,
+				  h ? BATgetId(h) : "NULL", h ? BATcount(h) : 0,
+				  subsorted, nparts, reserved);
+		canditer_reset(&ci);
+		if (GRPpartitioned(b, &ci, grps, nparts, gn,
+				   extents ? &en : NULL, histo ? &hn : NULL,
+				   &ngrp) != GDK_SUCCEED)
+			goto error;
 	} else {
 		bool gc = g != NULL && (BATordered(g) || BATordered_rev(g));
 		const char *nme;
@@ -1207,8 +1382,10 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 	ngrp--;	     /* max value is one less than number of values */
 	BATsetprop(gn, GDK_MAX_VALUE, TYPE_oid, &ngrp);
 	*groups = gn;
+	GDKmemrelease(reserved);
 	return GDK_SUCCEED;
   error:
+	GDKmemrelease(reserved);
 	if (hs != NULL && hs != b->thash) {
 		HEAPfree(&hs->heap, true);
 		GDKfree(hs);
@@ -1226,5 +1403,5 @@ gdk_return
 BATgroup(BAT **groups, BAT **extents, BAT **histo,
 	 BAT *b, BAT *s, BAT *g, BAT *e, BAT *h)
 {
-	return BATgroup_internal(groups, extents, histo, b, s, g, e, h, false);
+	return BATgroup_internal(groups, extents, histo, b, s, g, e, h, false, true);
 }
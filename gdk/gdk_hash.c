@@ -616,6 +616,101 @@ HASHprobe(const Hash *h, const void *v)
 	}
 }
 
+/*
+ * Operators that would need a hash table that does not fit in their
+ * memory budget (see GDKmemreserve) can instead split their input
+ * into partitions on (a different part of) the hash value and process
+ * the partitions one at a time.  HASHpartition distributes the values
+ * of b selected by ci over nparts (a power of two, at least 2) new
+ * transient BATs: vals[i] gets the values, idxs[i] the index of each
+ * value in the candidate list, and, if grps is not NULL, gids[i] the
+ * group ids (grps is aligned with the candidate list and is included
+ * in the hash).  With skipnil, nil values are left out.  Since the
+ * partitions are ordinary transient BATs, their heaps are files in
+ * the transient farm as soon as memory is short.
+ */
+gdk_return
+HASHpartition(BAT *b, struct canditer *ci, const oid *grps, int nparts,
+	      bool skipnil, BAT **vals, BAT **idxs, BAT **gids)
+{
+	BATiter bi = bat_iterator(b);
+	int tt = b->ttype;
+	BUN (*hash)(const void *) = BATatoms[tt].atomHash;
+	int (*cmp)(const void *, const void *) = ATOMcompare(tt);
+	const void *nil = ATOMnilptr(tt);
+	int bits = 0;
+	BUN cap;
+	int i;
+
+	assert(tt != TYPE_void);
+	assert(nparts >= 2 && (nparts & (nparts - 1)) == 0);
+	while ((1 << bits) < nparts)
+		bits++;
+	cap = ci->ncand / nparts + ci->ncand / nparts / 8 + 16;
+	for (i = 0; i < nparts; i++)
+		vals[i] = idxs[i] = NULL;
+	if (gids)
+		for (i = 0; i < nparts; i++)
+			gids[i] = NULL;
+	for (i = 0; i < nparts; i++) {
+		if ((vals[i] = COLnew(0, tt, cap, TRANSIENT)) == NULL ||
+		    (idxs[i] = COLnew(0, TYPE_oid, cap, TRANSIENT)) == NULL ||
+		    (gids && (gids[i] = COLnew(0, TYPE_oid, cap, TRANSIENT)) == NULL))
+			goto bunins_failed;
+	}
+	for (BUN r = 0; r < ci->ncand; r++) {
+		oid o = canditer_next(ci);
+		const void *v = BUNtail(bi, o - b->hseqbase);
+		if (skipnil && cmp(v, nil) == 0)
+			continue;
+		ulng h = (ulng) hash(v);
+		if (grps)
+			h ^= (ulng) grps[r] * 0x9E3779B1;
+		/* use the high bits of a multiplicative hash, so
+		 * that the partition does not correlate with the
+		 * bucket the value ends up in later */
+		i = (int) ((h * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+		if (vals[i]->tvarsized)
+			bunfastappVAR(vals[i], v);
+		else
+			bunfastapp(vals[i], v);
+		bunfastappTYPE(oid, idxs[i], &(oid){r});
+		if (gids)
+			bunfastappTYPE(oid, gids[i], &grps[r]);
+	}
+	for (i = 0; i < nparts; i++) {
+		BUN n = BATcount(vals[i]);
+
+		vals[i]->tsorted = vals[i]->trevsorted = n <= 1;
+		vals[i]->tkey = n <= 1;
+		vals[i]->tnonil = skipnil;
+		vals[i]->tnil = false;
+		idxs[i]->tsorted = idxs[i]->tkey = true;
+		idxs[i]->trevsorted = n <= 1;
+		idxs[i]->tnonil = true;
+		idxs[i]->tnil = false;
+		if (gids) {
+			gids[i]->tsorted = gids[i]->trevsorted = n <= 1;
+			gids[i]->tkey = n <= 1;
+			gids[i]->tnonil = true;
+			gids[i]->tnil = false;
+		}
+	}
+	return GDK_SUCCEED;
+
+  bunins_failed:
+	for (i = 0; i < nparts; i++) {
+		BBPreclaim(vals[i]);
+		BBPreclaim(idxs[i]);
+		vals[i] = idxs[i] = NULL;
+		if (gids) {
+			BBPreclaim(gids[i]);
+			gids[i] = NULL;
+		}
+	}
+	return GDK_FAIL;
+}
+
 BUN
 HASHlist(Hash *h, BUN i)
 {
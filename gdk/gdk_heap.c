@@ -85,6 +85,50 @@ decompose_filename(str nme)
 	return ext;
 }
 
+/* With gdk_hugepages set, we ask the kernel to back malloced heaps of
+ * at least HUGEPAGE_MINSIZE with transparent huge pages, which cuts
+ * down on TLB misses when scanning them.  (Memory mapped heaps are
+ * backed by files in the farm, for which huge pages are not
+ * available.) */
+#define HUGEPAGE_MINSIZE	((size_t) 1 << 22)
+
+static ATOMIC_TYPE GDK_huge_cursize = ATOMIC_VAR_INIT(0);
+
+static void
+HEAPhuge(Heap *h)
+{
+#ifdef MADV_HUGEPAGE
+	if (GDK_hugepages && h->storage == STORE_MEM &&
+	    h->size >= HUGEPAGE_MINSIZE) {
+		uintptr_t pg = (uintptr_t) MT_pagesize();
+		uintptr_t b = ((uintptr_t) h->base + pg - 1) & ~(pg - 1);
+		uintptr_t e = ((uintptr_t) h->base + h->size) & ~(pg - 1);
+
+		if (madvise((void *) b, e - b, MADV_HUGEPAGE) == 0) {
+			h->hugepages = true;
+			(void) ATOMIC_ADD(&GDK_huge_cursize, h->size);
+		}
+	}
+#else
+	(void) h;
+#endif
+}
+
+static void
+HEAPunhuge(Heap *h)
+{
+	if (h->hugepages) {
+		(void) ATOMIC_SUB(&GDK_huge_cursize, h->size);
+		h->hugepages = false;
+	}
+}
+
+size_t
+GDKhuge_cursize(void)
+{
+	return (size_t) ATOMIC_GET(&GDK_huge_cursize);
+}
+
 /*
  * @- HEAPalloc
  *
@@ -92,6 +136,8 @@ decompose_filename(str nme)
  * though, come from memory mapped files that we create with a large
  * seek. This is fast, and leads to files-with-holes on Unixes (on
  * Windows, it actually always performs I/O which is not nice).
+ * Small heaps are rounded up to a size class and taken from the heap
+ * pool (see GDKpoolmalloc).
  */
 gdk_return
 HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
@@ -99,6 +145,7 @@ HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 	h->base = NULL;
 	h->size = 1;
 	h->copied = false;
+	h->hugepages = false;
 	if (itemsize)
 		h->size = MAX(1, nitems) * itemsize;
 	h->free = 0;
@@ -110,11 +157,14 @@ HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 		return GDK_FAIL;
 	}
 	if (GDKinmemory() ||
-	    (GDKmem_cursize() + h->size < GDK_mem_maxsize &&
+	    (h->size < GDKmemavail() &&
 	     h->size < (h->farmid == 0 ? GDK_mmap_minsize_persistent : GDK_mmap_minsize_transient))) {
 		h->storage = STORE_MEM;
-		h->base = GDKmalloc(h->size);
+		h->size = GDKpoolsize(h->size);
+		h->base = GDKpoolmalloc(h->size);
 		HEAPDEBUG fprintf(stderr, "#HEAPalloc %zu %p\n", h->size, h->base);
+		if (h->base)
+			HEAPhuge(h);
 	}
 	if (!GDKinmemory() && h->base == NULL) {
 		char *nme;
@@ -198,21 +248,30 @@ HEAPextend(Heap *h, size_t size, bool mayshare)
 	} else {
 		/* extend a malloced heap, possibly switching over to
 		 * file-mapped storage */
+		HEAPunhuge(h);
 		Heap bak = *h;
-		bool exceeds_swap = size + GDKmem_cursize() >= GDK_mem_maxsize;
+		bool exceeds_swap = size >= GDKmemavail();
 		bool must_mmap = !GDKinmemory() && (exceeds_swap || h->newstorage != STORE_MEM || size >= (h->farmid == 0 ? GDK_mmap_minsize_persistent : GDK_mmap_minsize_transient));
 
+		/* the string dedup table stays with h */
+		bak.dedup = NULL;
+
 		h->size = size;
 
 		/* try GDKrealloc if the heap size stays within
 		 * reasonable limits */
 		if (!must_mmap) {
+			/* stay in a size class, so that the heap can
+			 * go back to the pool */
+			size = GDKpoolsize(size);
 			h->newstorage = h->storage = STORE_MEM;
 			h->base = GDKrealloc(h->base, size);
 			HEAPDEBUG fprintf(stderr, "#HEAPextend: extending malloced heap %zu %zu %p %p\n", size, h->size, bak.base, h->base);
 			h->size = size;
-			if (h->base)
+			if (h->base) {
+				HEAPhuge(h);
 				return GDK_SUCCEED; /* success */
+			}
 			/* bak.base is still valid and may get restored */
 			failure = "h->storage == STORE_MEM && !must_map && !h->base";
 		}
@@ -286,6 +345,7 @@ HEAPextend(Heap *h, size_t size, bool mayshare)
 			}
 		}
 	  failed:
+		bak.dedup = h->dedup;
 		*h = bak;
 	}
 	GDKerror("HEAPextend: failed to extend to %zu for %s%s%s: %s\n",
@@ -301,6 +361,7 @@ HEAPshrink(Heap *h, size_t size)
 	assert(size >= h->free);
 	assert(size <= h->size);
 	if (h->storage == STORE_MEM) {
+		HEAPunhuge(h);
 		p = GDKrealloc(h->base, size);
 		HEAPDEBUG fprintf(stderr, "#HEAPshrink: shrinking malloced "
 				  "heap %zu %zu %p "
@@ -337,6 +398,8 @@ HEAPshrink(Heap *h, size_t size)
 	if (p) {
 		h->size = size;
 		h->base = p;
+		if (h->storage == STORE_MEM)
+			HEAPhuge(h);
 		return GDK_SUCCEED;
 	}
 	return GDK_FAIL;
@@ -547,12 +610,14 @@ HEAPcopy(Heap *dst, Heap *src)
 void
 HEAPfree(Heap *h, bool rmheap)
 {
+	strDedupDestroy(h);
+	HEAPunhuge(h);
 	if (h->base) {
 		if (h->storage == STORE_MEM) {	/* plain memory */
 			HEAPDEBUG fprintf(stderr, "#HEAPfree %zu"
 					  " %p\n",
 					  h->size, h->base);
-			GDKfree(h->base);
+			GDKpoolfree(h->base, h->size);
 		} else if (h->storage == STORE_CMEM) {
 			//heap is stored in regular C memory rather than GDK memory,so we call free()
 			free(h->base);
@@ -603,8 +668,35 @@ HEAPload_intern(Heap *h, const char *nme, const char *ext, const char *suffix, b
 	size_t minsize;
 	int ret = 0;
 	char *srcpath, *dstpath, *tmp;
+	long_str extension;
+	struct stat st;
 	int t0;
 
+	/* a compressed segment is read into memory as a whole; an
+	 * X.new file takes precedence, so if there is one, it was
+	 * saved after the segment, unless it is itself a segment that
+	 * was saved while X was memory mapped (see HEAPsavesegment) */
+	strconcat_len(extension, sizeof(extension), ext, suffix, NULL);
+	if ((srcpath = GDKfilepath(h->farmid, BATDIR, nme, extension)) == NULL)
+		return GDK_FAIL;
+	ret = stat(srcpath, &st);
+	GDKfree(srcpath);
+	if (ret < 0 ? GDKissegment(h->farmid, nme, ext) :
+	    GDKissegment(h->farmid, nme, extension)) {
+		if (ret == 0 &&
+		    GDKmove(h->farmid, BATDIR, nme, extension, BATDIR, nme, ext) != GDK_SUCCEED)
+			return GDK_FAIL;
+		h->storage = h->newstorage = STORE_MEM;
+		if (trunc && h->free > 0)
+			h->size = h->free;
+		h->base = GDKloadsegment(h->farmid, nme, ext, h->free, &h->size);
+		if (h->base == NULL)
+			return GDK_FAIL;
+		h->compressed = true;
+		return GDK_SUCCEED;
+	}
+	ret = 0;
+
 	h->storage = h->newstorage = h->size < GDK_mmap_minsize_persistent ? STORE_MEM : STORE_MMAP;
 
 	minsize = (h->size + GDK_mmap_pagesize - 1) & ~(GDK_mmap_pagesize - 1);
@@ -721,6 +813,37 @@ HEAPsave(Heap *h, const char *nme, const char *ext)
 	return HEAPsave_intern(h, nme, ext, ".new");
 }
 
+/* Save the heap as a compressed segment (see GDKsavesegment).  The
+ * heap itself is left alone.  A memory mapped heap may be in use by
+ * views and other threads, so the file it is mapped from must stay:
+ * its segment is written to X.new instead, which takes the place of X
+ * when the heap is next loaded.  If the segment cannot be written or
+ * doesn't gain anything, the heap is saved normally. */
+gdk_return
+HEAPsavesegment(Heap *h, const char *nme, const char *ext)
+{
+	long_str extension;
+	bool saved = false;
+
+	if (h->base == NULL) {
+		GDKerror("HEAPsavesegment: no heap to save\n");
+		return GDK_FAIL;
+	}
+	strconcat_len(extension, sizeof(extension), ext, ".new", NULL);
+	if (GDKsavesegment(h->farmid, nme,
+			   h->storage == STORE_MEM ? ext : extension,
+			   h->base, h->free, &saved) != GDK_SUCCEED ||
+	    !saved) {
+		GDKclrerr();
+		return HEAPsave(h, nme, ext);
+	}
+	HEAPDEBUG fprintf(stderr, "#HEAPsavesegment(%s.%s,storage=%d,free=%zu,size=%zu)\n", nme, ext, (int) h->storage, h->free, h->size);
+	if (h->storage != STORE_MEM)
+		return GDK_SUCCEED;
+	/* a left-over X.new would take precedence over the segment */
+	return GDKunlink(h->farmid, BATDIR, nme, extension);
+}
+
 /*
  * @- HEAPdelete
  * Delete any saved heap file. For memory mapped files, also try to
@@ -761,6 +884,30 @@ HEAPwarm(Heap *h)
 	return bogus_result;
 }
 
+/* Pass an access hint for the range [off, off + len) of a memory
+ * mapped heap on to the OS.  Malloced heaps are left alone (for
+ * anonymous memory, MADV_DONTNEED throws away the content), and
+ * MMAP_DONTNEED is only passed for shared maps, since it would
+ * discard the changes in a copy-on-write map.  MMAP_WILLNEED makes
+ * the kernel start reading the range in the background; we don't ask
+ * that for more than we have room for, since it would only push out
+ * the pages we read first. */
+void
+HEAPadvise(Heap *h, size_t off, size_t len, int advice)
+{
+	if (h->base == NULL || h->storage == STORE_MEM || off >= h->size)
+		return;
+	if (advice == MMAP_DONTNEED && h->storage != STORE_MMAP)
+		return;
+	if (len > h->size - off)
+		len = h->size - off;
+	if (advice == MMAP_WILLNEED && len > GDKmemavail())
+		return;
+	HEAPDEBUG fprintf(stderr, "#HEAPadvise(%s,%zu,%zu,%d)\n",
+			  h->filename, off, len, advice);
+	(void) MT_madvise(h->base + off, len, advice);
+}
+
 
 /* Return the (virtual) size of the heap. */
 size_t
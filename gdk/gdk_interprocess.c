@@ -326,6 +326,7 @@ GDKbatread(char *src, BAT **bat, str *colname)
 	if (b->tvheap != NULL) {
 		//[VHEAP]
 		b->tvheap = (Heap *) (src + position);
+		b->tvheap->dedup = NULL;
 		position += align(sizeof(Heap));
 		//[VHEAPDATA]
 		b->tvheap->base = (void *) (src + position);
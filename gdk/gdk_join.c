@@ -13,7 +13,9 @@
 
 #include <sys/time.h>
 
-#define GDK_JOIN_PROFILE
+/* define GDK_JOIN_PROFILE to print the time taken by BATjoin and to
+ * append it to doppio.log in the current directory */
+#undef GDK_JOIN_PROFILE
 
 #ifdef GDK_JOIN_PROFILE
 double get_time(void);
@@ -2770,6 +2772,130 @@ hashjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr,
 	return GDK_FAIL;
 }
 
+/* don't bother partitioning if the hash table is smaller than this */
+#define GRACE_MINSIZE	((size_t) 1 << 24)
+#define GRACE_MAXPARTS	256
+
+/* Grace hash join, used instead of hashjoin when the hash table on r
+ * doesn't fit in the memory budget: both sides are partitioned on
+ * the hash value of the join attribute into transient BATs (see
+ * HASHpartition), and the pairs of partitions are joined one at a
+ * time, each with a hash table that is nparts times smaller.  The
+ * result is sorted on the left oid, like that of hashjoin. */
+static gdk_return
+gracejoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r,
+	  struct canditer *restrict lci, struct canditer *restrict rci,
+	  bool nil_matches, int nparts, lng t0, bool swapped)
+{
+	BAT *lv[GRACE_MAXPARTS], *li[GRACE_MAXPARTS];
+	BAT *rv[GRACE_MAXPARTS], *ri[GRACE_MAXPARTS];
+	BAT *r1 = NULL, *r2 = NULL, *j1 = NULL, *j2 = NULL;
+	BAT *s1 = NULL, *o1 = NULL;
+	int i = 0;
+
+	assert(ATOMtype(l->ttype) == ATOMtype(r->ttype));
+	*r1p = NULL;
+	if (r2p)
+		*r2p = NULL;
+	if (HASHpartition(l, lci, NULL, nparts, !nil_matches, lv, li, NULL) != GDK_SUCCEED)
+		return GDK_FAIL;
+	if (HASHpartition(r, rci, NULL, nparts, !nil_matches, rv, ri, NULL) != GDK_SUCCEED) {
+		for (i = 0; i < nparts; i++) {
+			BBPreclaim(lv[i]);
+			BBPreclaim(li[i]);
+		}
+		return GDK_FAIL;
+	}
+	if ((r1 = COLnew(0, TYPE_oid, 0, TRANSIENT)) == NULL ||
+	    (r2p && (r2 = COLnew(0, TYPE_oid, 0, TRANSIENT)) == NULL))
+		goto bunins_failed;
+	for (i = 0; i < nparts; i++) {
+		if (BATcount(lv[i]) > 0 && BATcount(rv[i]) > 0) {
+			struct canditer plci, prci;
+			const oid *restrict lidx = (const oid *) Tloc(li[i], 0);
+			const oid *restrict ridx = (const oid *) Tloc(ri[i], 0);
+
+			canditer_init(&plci, lv[i], NULL);
+			canditer_init(&prci, rv[i], NULL);
+			if (hashjoin(&j1, r2p ? &j2 : NULL, lv[i], rv[i],
+				     NULL, NULL, &plci, &prci,
+				     nil_matches, false, false, false, false,
+				     BUN_NONE, t0, swapped, false,
+				     "partition") != GDK_SUCCEED)
+				goto bunins_failed;
+			for (BUN k = 0, n = BATcount(j1); k < n; k++) {
+				oid o = canditer_idx(lci, lidx[BUNtoid(j1, k)]);
+				bunfastappTYPE(oid, r1, &o);
+				if (r2) {
+					o = canditer_idx(rci, ridx[BUNtoid(j2, k)]);
+					bunfastappTYPE(oid, r2, &o);
+				}
+			}
+			BBPunfix(j1->batCacheid);
+			j1 = NULL;
+			if (j2) {
+				BBPunfix(j2->batCacheid);
+				j2 = NULL;
+			}
+		}
+		BBPunfix(lv[i]->batCacheid);
+		BBPunfix(li[i]->batCacheid);
+		BBPunfix(rv[i]->batCacheid);
+		BBPunfix(ri[i]->batCacheid);
+	}
+	r1->tsorted = r1->trevsorted = BATcount(r1) <= 1;
+	r1->tkey = BATcount(r1) <= 1;
+	r1->tnonil = true;
+	r1->tnil = false;
+	if (r2) {
+		r2->tsorted = r2->trevsorted = BATcount(r2) <= 1;
+		r2->tkey = BATcount(r2) <= 1;
+		r2->tnonil = true;
+		r2->tnil = false;
+	}
+	/* restore the order on the left oid, keeping the order of the
+	 * matches within each left value */
+	if (BATsort(&s1, r2 ? &o1 : NULL, NULL, r1, NULL, NULL, false, false, true) != GDK_SUCCEED)
+		goto bunins_failed;
+	BBPunfix(r1->batCacheid);
+	r1 = s1;
+	if (r2) {
+		s1 = BATproject(o1, r2);
+		BBPunfix(o1->batCacheid);
+		BBPunfix(r2->batCacheid);
+		if (s1 == NULL) {
+			BBPunfix(r1->batCacheid);
+			return GDK_FAIL;
+		}
+		r2 = s1;
+	}
+	*r1p = r1;
+	if (r2p)
+		*r2p = r2;
+	ALGODEBUG fprintf(stderr, "#%s: %s(l=" ALGOBATFMT ","
+			  "r=" ALGOBATFMT ",nil_matches=%d,nparts=%d)%s "
+			  "-> (" ALGOBATFMT "," ALGOOPTBATFMT ") " LLFMT "us\n",
+			  MT_thread_getname(), __func__,
+			  ALGOBATPAR(l), ALGOBATPAR(r),
+			  nil_matches, nparts, swapped ? " swapped" : "",
+			  ALGOBATPAR(r1), ALGOOPTBATPAR(r2),
+			  GDKusec() - t0);
+	return GDK_SUCCEED;
+
+  bunins_failed:
+	for (; i < nparts; i++) {
+		BBPreclaim(lv[i]);
+		BBPreclaim(li[i]);
+		BBPreclaim(rv[i]);
+		BBPreclaim(ri[i]);
+	}
+	BBPreclaim(j1);
+	BBPreclaim(j2);
+	BBPreclaim(r1);
+	BBPreclaim(r2);
+	return GDK_FAIL;
+}
+
 #define MASK_EQ		1
 #define MASK_LT		2
 #define MASK_GT		4
@@ -3460,7 +3586,7 @@ leftjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr,
 		       || BATordered_rev(l)
 		       || BATtdense(r)
 		       || lcnt < 1024
-		       || BATcount(r) * (Tsize(r) + (r->tvheap ? r->tvheap->size : 0) + 2 * sizeof(BUN)) > GDK_mem_maxsize / (GDKnr_threads ? GDKnr_threads : 1))) {
+		       || BATcount(r) * (Tsize(r) + (r->tvheap ? r->tvheap->size : 0) + 2 * sizeof(BUN)) > GDKmemavail())) {
 		return mergejoin(r1p, r2p, l, r, sl, sr, &lci, &rci,
 				 nil_matches, nil_on_miss, semi, only_misses,
 				 not_in, estimate, t0, false, func);
@@ -3642,7 +3768,7 @@ BATjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches
 	/* some statistics to help us decide */
 	lsize = (BUN) (BATcount(l) * (Tsize(l)) + (l->tvheap ? l->tvheap->size : 0) + 2 * sizeof(BUN));
 	rsize = (BUN) (BATcount(r) * (Tsize(r)) + (r->tvheap ? r->tvheap->size : 0) + 2 * sizeof(BUN));
-	mem_size = GDK_mem_maxsize / (GDKnr_threads ? GDKnr_threads : 1);
+	mem_size = GDKmemavail();
 
 	if (lcnt == 1 || (BATordered(l) && BATordered_rev(l)) || (l->ttype == TYPE_void && is_oid_nil(l->tseqbase))) {
 		/* single value to join, use select */
@@ -3769,8 +3895,34 @@ BATjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches
 	start = get_time();
 #endif
 
+	/* tell the memory broker about the hash table we are about to
+	 * build, so that concurrent operators plan with what is left;
+	 * if we can't get enough, join in partitions instead */
+	size_t reserved = 0;
+	int nparts = 0;
+	if (!(swap ? lhash : rhash)) {
+		BAT *b = swap ? l : r;
+		size_t need = (swap ? lcnt : rcnt) * (Tsize(b) + 2 * sizeof(BUN));
+
+		reserved = GDKmemreserve(need, 0);
+		if (reserved < need && need >= GRACE_MINSIZE &&
+		    l->ttype != TYPE_void && r->ttype != TYPE_void) {
+			nparts = 2;
+			while (nparts < GRACE_MAXPARTS &&
+			       need / nparts > reserved)
+				nparts <<= 1;
+		}
+	}
+
 	gdk_return temp;
-	if (swap) {
+	if (nparts > 0) {
+		if (swap)
+			temp = gracejoin(r2p, r1p, r, l, &rci, &lci,
+					 nil_matches, nparts, t0, true);
+		else
+			temp = gracejoin(r1p, r2p, l, r, &lci, &rci,
+					 nil_matches, nparts, t0, false);
+	} else if (swap) {
 		assert(r2p);
 		temp = hashjoin(r2p, r1p, r, l, sr, sl, &rci, &lci,
 				nil_matches, false, false, false, false,
@@ -3780,19 +3932,17 @@ BATjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches
 				nil_matches, false, false, false, false,
 				estimate, t0, false, prhash, reason);
 	}
+	GDKmemrelease(reserved);
 
 #ifdef GDK_JOIN_PROFILE
 	if (start != 0.0) {
 		end = get_time();
 		printf("Total time inside MonetDB hashjoin: %.10f\n", end - start); fflush(stdout);
-		if (BATcount(l) < BATcount(r)) {
-			fprintf(doppiolog, "monet-join-> total-time: %.10f, small-rel: %ld, large-rel: %ld\n", end - start, BATcount(l), BATcount(r) ); fflush(stdout);
-		}
-		else {
-			fprintf(doppiolog, "monet-join-> total-time: %.10f, small-rel: %ld, large-rel: %ld\n", end - start, BATcount(r), BATcount(l) ); fflush(stdout);
-		}
+		if (doppiolog != NULL)
+			fprintf(doppiolog, "monet-join-> total-time: %.10f, small-rel: %ld, large-rel: %ld\n", end - start, (long) MIN(BATcount(l), BATcount(r)), (long) MAX(BATcount(l), BATcount(r)));
 	}
-	fclose(doppiolog);
+	if (doppiolog)
+		fclose(doppiolog);
 #endif
 
 	return temp;
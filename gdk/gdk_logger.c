@@ -653,27 +653,28 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name, int tpe, oid i
 	return res;
 }
 
-static gdk_return
-la_bat_updates(logger *lg, logaction *la)
+/* the bat the updates in la are to be applied to, or 0 if they are
+ * to be skipped */
+static log_bid
+la_bat_updates_bid(logger *lg, logaction *la)
 {
 	log_bid bid = logger_find_bat(lg, la->name, la->tpe, la->cid);
-	BAT *b;
 
 	if (bid == 0)
-		return GDK_SUCCEED; /* ignore bats no longer in the catalog */
+		return 0; /* ignore bats no longer in the catalog */
 
 	/* do we need to skip these old updates */
 	if (avoid_snapshot(lg, bid))
-		return GDK_SUCCEED;
+		return 0;
+	return bid;
+}
 
-	b = BATdescriptor(bid);
-	if (b == NULL)
-		return GDK_FAIL;
+static gdk_return
+la_bat_updates_apply(BAT *b, logaction *la)
+{
 	if (la->type == LOG_INSERT) {
-		if (BATappend(b, la->b, NULL, true) != GDK_SUCCEED) {
-			logbat_destroy(b);
+		if (BATappend(b, la->b, NULL, true) != GDK_SUCCEED)
 			return GDK_FAIL;
-		}
 	} else if (la->type == LOG_UPDATE) {
 		BATiter vi = bat_iterator(la->b);
 		BUN p, q;
@@ -692,28 +693,38 @@ la_bat_updates(logger *lg, logaction *la)
 					const void *tv = ATOMnilptr(b->ttype);
 
 					while (b->hseqbase + b->batCount < h) {
-						if (BUNappend(b, tv, true) != GDK_SUCCEED) {
-							logbat_destroy(b);
+						if (BUNappend(b, tv, true) != GDK_SUCCEED)
 							return GDK_FAIL;
-						}
 					}
 				}
-				if (BUNappend(b, t, true) != GDK_SUCCEED) {
-					logbat_destroy(b);
+				if (BUNappend(b, t, true) != GDK_SUCCEED)
 					return GDK_FAIL;
-				}
 			} else {
-				if (BUNreplace(b, h, t, true) != GDK_SUCCEED) {
-					logbat_destroy(b);
+				if (BUNreplace(b, h, t, true) != GDK_SUCCEED)
 					return GDK_FAIL;
-				}
 			}
 		}
 	}
-	logbat_destroy(b);
 	return GDK_SUCCEED;
 }
 
+static gdk_return
+la_bat_updates(logger *lg, logaction *la)
+{
+	log_bid bid = la_bat_updates_bid(lg, la);
+	BAT *b;
+	gdk_return ret;
+
+	if (bid == 0)
+		return GDK_SUCCEED;
+	b = BATdescriptor(bid);
+	if (b == NULL)
+		return GDK_FAIL;
+	ret = la_bat_updates_apply(b, la);
+	logbat_destroy(b);
+	return ret;
+}
+
 static log_return
 log_read_destroy(logger *lg, trans *tr, char *name, char tpe, oid id)
 {
@@ -1014,8 +1025,145 @@ tr_abort(logger *lg, trans *tr)
 	return tr_destroy(tr);
 }
 
+/* When replaying the log, the inserts and updates of committed
+ * transactions are not applied right away, but collected in a batch.
+ * The batch is applied when it gets large, before a transaction that
+ * changes the catalog (create, use, destroy, clear) is applied, and
+ * at the end of the log.  The batch is grouped by BAT, and the groups
+ * are applied by a number of threads; the changes to each BAT are
+ * still applied in log order.  Which BAT the changes go to, or
+ * whether they are skipped, is decided when the transaction commits,
+ * just as when they are applied directly. */
+#define REPLAY_MAXACTIONS	65536
+#define REPLAY_MAXSIZE		((size_t) 64 << 20)
+/* don't bother with threads for less than this */
+#define REPLAY_MINPARALLEL	((size_t) 1 << 20)
+
+typedef struct replayaction {
+	log_bid bid;		/* bat to apply the changes to */
+	int seq;		/* position in the log */
+	logaction la;
+} replayaction;
+
+typedef struct replay {
+	replayaction *acts;
+	int nr, sz;
+	size_t size;		/* bytes of changes in the batch */
+	int *groups;		/* start of each group of acts (and end) */
+	int ngroups;
+} replay;
+
+static int
+replay_cmp(const void *a, const void *b)
+{
+	const replayaction *x = a, *y = b;
+
+	if (x->bid != y->bid)
+		return x->bid < y->bid ? -1 : 1;
+	return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/* apply the changes of group g to their bat */
+static gdk_return
+replay_group(void *arg, int g)
+{
+	replay *rp = arg;
+	int i = rp->groups[g], e = rp->groups[g + 1];
+	BAT *b = BATdescriptor(rp->acts[i].bid);
+	gdk_return ret = GDK_SUCCEED;
+
+	if (b == NULL)
+		return GDK_FAIL;
+	for (; i < e && ret == GDK_SUCCEED; i++)
+		ret = la_bat_updates_apply(b, &rp->acts[i].la);
+	logbat_destroy(b);
+	return ret;
+}
+
+/* apply and clear the batch */
+static gdk_return
+replay_flush(logger *lg, replay *rp)
+{
+	int nthreads = 1, i;
+	gdk_return ret = GDK_SUCCEED;
+
+	if (rp->nr == 0)
+		return GDK_SUCCEED;
+	qsort(rp->acts, rp->nr, sizeof(replayaction), replay_cmp);
+	if ((rp->groups = GDKmalloc((rp->nr + 1) * sizeof(int))) == NULL) {
+		ret = GDK_FAIL;
+		goto bailout;
+	}
+	rp->ngroups = 0;
+	for (i = 0; i < rp->nr; i++)
+		if (i == 0 || rp->acts[i].bid != rp->acts[i - 1].bid)
+			rp->groups[rp->ngroups++] = i;
+	rp->groups[rp->ngroups] = rp->nr;
+
+	if (rp->size >= REPLAY_MINPARALLEL)
+		nthreads = MIN(GDKnr_threads, rp->ngroups);
+	if (lg->debug & 1)
+		fprintf(stderr, "#replay_flush %d changes to %d bats using up to %d threads\n", rp->nr, rp->ngroups, nthreads);
+	ret = GDKparallel("logreplay", nthreads, rp->ngroups, 1,
+			  replay_group, rp);
+	GDKfree(rp->groups);
+	rp->groups = NULL;
+
+  bailout:
+	for (i = 0; i < rp->nr; i++)
+		la_destroy(&rp->acts[i].la);
+	rp->nr = 0;
+	rp->size = 0;
+	return ret;
+}
+
+/* add the inserts or updates in la to the batch; the batch takes
+ * over the resources of la */
+static gdk_return
+replay_add(logger *lg, replay *rp, logaction *la)
+{
+	log_bid bid = la_bat_updates_bid(lg, la);
+
+	if (bid == 0) {
+		la_destroy(la);
+		return GDK_SUCCEED;
+	}
+	if (rp->nr == rp->sz) {
+		int sz = rp->sz ? rp->sz * 2 : 1024;
+		replayaction *acts = GDKrealloc(rp->acts, sz * sizeof(replayaction));
+		if (acts == NULL) {
+			la_destroy(la);
+			return GDK_FAIL;
+		}
+		rp->acts = acts;
+		rp->sz = sz;
+	}
+	rp->acts[rp->nr] = (replayaction) {
+		.bid = bid,
+		.seq = rp->nr,
+		.la = *la,
+	};
+	rp->nr++;
+	if (la->b) {
+		rp->size += (size_t) BATcount(la->b) << la->b->tshift;
+		if (la->b->tvheap)
+			rp->size += la->b->tvheap->free;
+	}
+	if (rp->nr >= REPLAY_MAXACTIONS || rp->size >= REPLAY_MAXSIZE)
+		return replay_flush(lg, rp);
+	return GDK_SUCCEED;
+}
+
+static void
+replay_destroy(replay *rp)
+{
+	for (int i = 0; i < rp->nr; i++)
+		la_destroy(&rp->acts[i].la);
+	GDKfree(rp->acts);
+}
+
 static trans *
-tr_commit(logger *lg, trans *tr)
+tr_commit(logger *lg, trans *tr, replay *rp)
 {
 	int i;
 
@@ -1023,13 +1171,29 @@ tr_commit(logger *lg, trans *tr)
 		fprintf(stderr, "#tr_commit\n");
 
 	for (i = 0; i < tr->nr; i++) {
-		if (la_apply(lg, &tr->changes[i]) != GDK_SUCCEED) {
+		gdk_return ret;
+
+		if (tr->changes[i].type == LOG_INSERT ||
+		    tr->changes[i].type == LOG_UPDATE) {
+			ret = replay_add(lg, rp, &tr->changes[i]);
+			lg->changes += (ret == GDK_SUCCEED);
+		} else {
+			/* catalog changes see all earlier changes */
+			ret = replay_flush(lg, rp);
+			if (ret == GDK_SUCCEED)
+				ret = la_apply(lg, &tr->changes[i]);
+			la_destroy(&tr->changes[i]);
+		}
+		if (ret != GDK_SUCCEED) {
+			/* the changes up to i have been taken care of */
+			tr->nr -= i + 1;
+			memmove(tr->changes, tr->changes + i + 1,
+				tr->nr * sizeof(logaction));
 			do {
 				tr = tr_abort(lg, tr);
 			} while (tr != NULL);
 			return (trans *) -1;
 		}
-		la_destroy(&tr->changes[i]);
 	}
 	return tr_destroy(tr);
 }
@@ -1077,12 +1241,38 @@ logger_open(logger *lg)
 	return GDK_SUCCEED;
 }
 
+/* sync all transactions flushed so far; call with synclock held */
+static gdk_return
+log_fsync(logger *lg)
+{
+	ATOMIC_BASE_TYPE upto = ATOMIC_GET(&lg->flushed);
+
+	if (lg->syncerr)
+		return GDK_FAIL;
+	if (ATOMIC_GET(&lg->synced) >= upto)
+		return GDK_SUCCEED;
+	if (!(GDKdebug & NOSYNCMASK) && mnstr_fsync(lg->log)) {
+		fprintf(stderr, "!ERROR: log_fsync: sync failed\n");
+		lg->syncerr = true;
+		return GDK_FAIL;
+	}
+	ATOMIC_SET(&lg->synced, upto);
+	return GDK_SUCCEED;
+}
+
 static void
 logger_close(logger *lg)
 {
-	if (!lg->inmemory)
+	if (!lg->inmemory) {
+		/* transactions waiting in log_tsync must not lose
+		 * their log */
+		MT_lock_set(&lg->synclock);
+		(void) log_fsync(lg);
 		close_stream(lg->log);
-	lg->log = NULL;
+		lg->log = NULL;
+		MT_lock_unset(&lg->synclock);
+	} else
+		lg->log = NULL;
 }
 
 static gdk_return
@@ -1095,6 +1285,7 @@ logger_readlog(logger *lg, char *filename, bool *filemissing)
 	struct stat sb;
 	int dbg = GDKdebug;
 	int fd;
+	replay rp = {0};
 
 	assert(!lg->inmemory);
 	GDKdebug &= ~(CHECKMASK|PROPMASK);
@@ -1211,7 +1402,7 @@ logger_readlog(logger *lg, char *filename, bool *filemissing)
 			else if (l.tid != l.nr)	/* abort record */
 				tr = tr_abort(lg, tr);
 			else
-				tr = tr_commit(lg, tr);
+				tr = tr_commit(lg, tr, &rp);
 			break;
 		case LOG_SEQ:
 			err = log_read_seq(lg, &l);
@@ -1296,6 +1487,10 @@ logger_readlog(logger *lg, char *filename, bool *filemissing)
 			break;
 		}
 	}
+	/* apply what is left of the committed changes */
+	if (err != LOG_ERR && replay_flush(lg, &rp) != GDK_SUCCEED)
+		err = LOG_ERR;
+	replay_destroy(&rp);
 	logger_close(lg);
 
 	/* remaining transactions are not committed, ie abort */
@@ -2463,6 +2658,12 @@ logger_new(int debug, const char *fn, const char *logdir, int version, preversio
 	lg->postfuncp = postfuncp;
 	lg->log = NULL;
 	lg->end = 0;
+	lg->group_commit = false;
+	lg->syncerr = false;
+	lg->commit_delay = 0;
+	ATOMIC_INIT(&lg->flushed, 0);
+	ATOMIC_INIT(&lg->synced, 0);
+	MT_lock_init(&lg->synclock, "logger_sync");
 	lg->catalog_bid = NULL;
 	lg->catalog_nme = NULL;
 	lg->catalog_tpe = NULL;
@@ -2549,6 +2750,9 @@ logger_destroy(logger *lg)
 	GDKfree(lg->fn);
 	GDKfree(lg->dir);
 	logger_close(lg);
+	ATOMIC_DESTROY(&lg->flushed);
+	ATOMIC_DESTROY(&lg->synced);
+	MT_lock_destroy(&lg->synclock);
 	GDKfree(lg);
 }
 
@@ -2725,6 +2929,15 @@ logger_with_ids(logger *lg)
 	lg->with_ids = true;
 }
 
+/* Switch the logger to group commit (see log_tsync).  The first
+ * committer to sync waits delay milliseconds for others to join. */
+void
+logger_group_commit(logger *lg, int delay)
+{
+	lg->group_commit = true;
+	lg->commit_delay = delay > 0 ? delay : 0;
+}
+
 /* Clean-up write-ahead log files already persisted in the BATs, leaving only the most recent one.
  * Only the bak- files are deleted for the preserved WAL files.
  */
@@ -3038,6 +3251,7 @@ pre_allocate(logger *lg)
 	if (p == -1)
 		return GDK_FAIL;
 	if (p > LOG_LARGE) {
+		logger_close(lg);
 		lg->id++;
 		return logger_open(lg);
 	}
@@ -3054,6 +3268,13 @@ pre_allocate(logger *lg)
 	return GDK_SUCCEED;
 }
 
+/* End the current transaction in the log.  With group commit the log
+ * is only flushed here, not synced: the transaction is not durable
+ * until log_tsync returns, so every caller of log_tend (in the SQL
+ * layer, every caller of sql_trans_commit on a transaction of gtrans)
+ * must call log_tsync before it reports the commit as done, preferably
+ * after releasing its locks so that concurrent commits share one
+ * sync. */
 gdk_return
 log_tend(logger *lg)
 {
@@ -3098,14 +3319,46 @@ log_tend(logger *lg)
 	if (res != GDK_SUCCEED ||
 	    log_write_format(lg, &l) != GDK_SUCCEED ||
 	    mnstr_flush(lg->log) ||
-	    (!(GDKdebug & NOSYNCMASK) && mnstr_fsync(lg->log)) ||
-	    pre_allocate(lg) != GDK_SUCCEED) {
+	    (!lg->group_commit &&
+	     !(GDKdebug & NOSYNCMASK) && mnstr_fsync(lg->log))) {
+		fprintf(stderr, "!ERROR: log_tend: write failed\n");
+		return GDK_FAIL;
+	}
+	if (lg->group_commit)
+		(void) ATOMIC_INC(&lg->flushed);
+	if (pre_allocate(lg) != GDK_SUCCEED) {
 		fprintf(stderr, "!ERROR: log_tend: write failed\n");
 		return GDK_FAIL;
 	}
 	return GDK_SUCCEED;
 }
 
+/* With group commit, wait until the transactions that ended so far
+ * are synced to disk.  The first thread to get here syncs the log
+ * for everybody; threads that arrive while it is busy queue up on
+ * synclock and usually find their transaction synced when they get
+ * the lock. */
+gdk_return
+log_tsync(logger *lg)
+{
+	ATOMIC_BASE_TYPE target;
+	gdk_return res = GDK_SUCCEED;
+
+	if (LOG_DISABLED(lg) || lg->inmemory || !lg->group_commit)
+		return GDK_SUCCEED;
+	target = ATOMIC_GET(&lg->flushed);
+	if (ATOMIC_GET(&lg->synced) >= target)
+		return GDK_SUCCEED;
+	MT_lock_set(&lg->synclock);
+	if (ATOMIC_GET(&lg->synced) < target || lg->syncerr) {
+		if (lg->commit_delay > 0 && !lg->syncerr)
+			MT_sleep_ms(lg->commit_delay);
+		res = log_fsync(lg);
+	}
+	MT_lock_unset(&lg->synclock);
+	return res;
+}
+
 gdk_return
 log_abort(logger *lg)
 {
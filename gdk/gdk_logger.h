@@ -80,6 +80,17 @@ typedef struct logger {
 				   commit). */
 	void *buf;
 	size_t bufsize;
+	/* group commit: with group_commit set, log_tend only flushes
+	 * the log and the committer calls log_tsync (preferably after
+	 * releasing its locks) to wait until the log is synced; one
+	 * fsync then serves all transactions that ended in the mean
+	 * time */
+	bool group_commit;
+	bool syncerr;		/* syncing the log failed */
+	int commit_delay;	/* ms to wait for others before syncing */
+	ATOMIC_TYPE flushed;	/* transactions flushed to the log */
+	ATOMIC_TYPE synced;	/* transactions synced to disk */
+	MT_Lock synclock;	/* held while syncing the log */
 } logger;
 
 #define BATSIZE 0
@@ -112,6 +123,7 @@ gdk_export gdk_return logger_exit(logger *lg);
 gdk_export gdk_return logger_restart(logger *lg);
 gdk_export gdk_return logger_cleanup(logger *lg);
 gdk_export void logger_with_ids(logger *lg);
+gdk_export void logger_group_commit(logger *lg, int delay);
 gdk_export lng logger_changes(logger *lg);
 gdk_export int logger_sequence(logger *lg, int seq, lng *id);
 
@@ -124,6 +136,7 @@ gdk_export gdk_return log_delta(logger *lg, BAT *uid, BAT *uval, const char *n,
 
 gdk_export gdk_return log_tstart(logger *lg);	/* TODO return transaction id */
 gdk_export gdk_return log_tend(logger *lg);
+gdk_export gdk_return log_tsync(logger *lg);
 gdk_export gdk_return log_abort(logger *lg);
 
 gdk_export gdk_return log_sequence(logger *lg, int seq, lng id);
@@ -388,6 +388,27 @@ MT_munmap(void *p, size_t len)
 	return ret;
 }
 
+/* give the OS advice (one of the MMAP_NORMAL, MMAP_RANDOM,
+ * MMAP_SEQUENTIAL, MMAP_WILLNEED, MMAP_DONTNEED values) about the
+ * use of the pages in the range [p, p + len); the range is extended
+ * to page boundaries */
+int
+MT_madvise(void *p, size_t len, int advice)
+{
+	uintptr_t pg = (uintptr_t) MT_pagesize();
+	uintptr_t b = (uintptr_t) p & ~(pg - 1);
+	uintptr_t e = ((uintptr_t) p + len + pg - 1) & ~(pg - 1);
+	int ret;
+
+	if (len == 0)
+		return 0;
+	ret = posix_madvise((void *) b, (size_t) (e - b), advice);
+#ifdef MMAP_DEBUG
+	fprintf(stderr, "#madvise(%p,%zu,%d) = %d\n", (void *) b, (size_t) (e - b), advice, ret);
+#endif
+	return ret;
+}
+
 /* expand or shrink a memory map (ala realloc).
  * the address returned may be different from the address going in.
  * in case of failure, the old address is still mapped and NULL is returned.
@@ -836,6 +857,16 @@ MT_munmap(void *p, size_t dummy)
 	return 0;
 }
 
+int
+MT_madvise(void *p, size_t len, int advice)
+{
+	/* the access pattern is given to CreateFile in MT_mmap */
+	(void) p;
+	(void) len;
+	(void) advice;
+	return 0;
+}
+
 void *
 MT_mremap(const char *path, int mode, void *old_address, size_t old_size, size_t *new_size)
 {
@@ -125,6 +125,7 @@ gdk_export size_t MT_getrss(void);
 
 gdk_export void *MT_mmap(const char *path, int mode, size_t len);
 gdk_export int MT_munmap(void *p, size_t len);
+gdk_export int MT_madvise(void *p, size_t len, int advice);
 
 gdk_export bool MT_path_absolute(const char *path);
 
@@ -64,7 +64,7 @@ __hidden PROPrec *BATgetprop(BAT *b, enum prop_t idx)
 	__attribute__((__visibility__("hidden")));
 __hidden PROPrec * BATgetprop_nolock(BAT *b, enum prop_t idx)
 	__attribute__((__visibility__("hidden")));
-__hidden gdk_return BATgroup_internal(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted)
+__hidden gdk_return BATgroup_internal(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted, bool spill)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
 __hidden Hash *BAThash_impl(BAT *b, BAT *s, const char *ext)
@@ -87,6 +87,9 @@ __hidden void BATsetprop_nolock(BAT *b, enum prop_t idx, int type, const void *v
 __hidden gdk_return BBPcacheit(BAT *bn, bool lock)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden gdk_return BBPcheckbat(BAT *b)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
 void BBPdump(void)		/* never called: for debugging only */
 	__attribute__((__cold__));
 __hidden void BBPexit(void)
@@ -139,8 +142,12 @@ __hidden FILE *GDKfilelocate(int farmid, const char *nme, const char *mode, cons
 	__attribute__((__visibility__("hidden")));
 __hidden FILE *GDKfileopen(int farmid, const char *dir, const char *name, const char *extension, const char *mode)
 	__attribute__((__visibility__("hidden")));
+__hidden bool GDKissegment(int farmid, const char *nme, const char *ext)
+	__attribute__((__visibility__("hidden")));
 __hidden char *GDKload(int farmid, const char *nme, const char *ext, size_t size, size_t *maxsize, storage_t mode)
 	__attribute__((__visibility__("hidden")));
+__hidden char *GDKloadsegment(int farmid, const char *nme, const char *ext, size_t size, size_t *maxsize)
+	__attribute__((__visibility__("hidden")));
 __hidden void GDKlog(_In_z_ _Printf_format_string_ FILE * fl, const char *format, ...)
 	__attribute__((__format__(__printf__, 2, 3)))
 	__attribute__((__visibility__("hidden")));
@@ -152,12 +159,24 @@ __hidden void *GDKmremap(const char *path, int mode, void *old_address, size_t o
 __hidden gdk_return GDKmunmap(void *addr, size_t len)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden gdk_return GDKparallel(const char *name, int nthreads, int n, int chunk, gdk_return (*func)(void *, int), void *arg)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
+__hidden void GDKpoolfree(void *s, size_t size)
+	__attribute__((__visibility__("hidden")));
+__hidden void *GDKpoolmalloc(size_t size)
+	__attribute__((__visibility__("hidden")));
+__hidden size_t GDKpoolsize(size_t size)
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return GDKremovedir(int farmid, const char *nme)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
 __hidden gdk_return GDKsave(int farmid, const char *nme, const char *ext, void *buf, size_t size, storage_t mode, bool dosync)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden gdk_return GDKsavesegment(int farmid, const char *nme, const char *ext, const void *buf, size_t size, bool *saved)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return GDKssort_rev(void *restrict h, void *restrict t, const void *restrict base, size_t n, int hs, int ts, int tpe)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -179,6 +198,11 @@ __hidden BUN HASHmask(BUN cnt)
 	__attribute__((__visibility__("hidden")));
 __hidden gdk_return HASHnew(Hash *h, int tpe, BUN size, BUN mask, BUN count)
 	__attribute__((__visibility__("hidden")));
+__hidden gdk_return HASHpartition(BAT *b, struct canditer *ci, const oid *grps, int nparts, bool skipnil, BAT **vals, BAT **idxs, BAT **gids)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
+__hidden void HEAPadvise(Heap *h, size_t off, size_t len, int advice)
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return HEAPalloc(Heap *h, size_t nitems, size_t itemsize)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -197,6 +221,9 @@ __hidden void HEAP_recover(Heap *, const var_t *, BUN)
 __hidden gdk_return HEAPsave(Heap *h, const char *nme, const char *ext)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden gdk_return HEAPsavesegment(Heap *h, const char *nme, const char *ext)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return HEAPshrink(Heap *h, size_t size)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -231,6 +258,10 @@ __hidden int strCmp(const char *l, const char *r)
 	__attribute__((__visibility__("hidden")));
 __hidden int strCmpNoNil(const unsigned char *l, const unsigned char *r)
 	__attribute__((__visibility__("hidden")));
+__hidden void strDedupDestroy(Heap *h)
+	__attribute__((__visibility__("hidden")));
+__hidden var_t strDedupLocate(Heap *h, const char *v)
+	__attribute__((__visibility__("hidden")));
 __hidden void strHeap(Heap *d, size_t cap)
 	__attribute__((__visibility__("hidden")));
 __hidden var_t strLocate(Heap *h, const char *v)
@@ -335,6 +366,8 @@ extern bbplock_t GDKbbpLock[BBP_THREADMASK + 1];
 extern size_t GDK_mmap_minsize_persistent; /* size after which we use memory mapped files for persistent heaps */
 extern size_t GDK_mmap_minsize_transient; /* size after which we use memory mapped files for transient heaps */
 extern size_t GDK_mmap_pagesize; /* mmap granularity */
+extern bool GDK_hugepages; /* advise huge pages for large heaps */
+extern bool GDK_lazy_checkbats; /* check BAT files when first loaded */
 extern MT_Lock GDKnameLock;
 extern MT_Lock GDKthreadLock;
 extern MT_Lock GDKtmLock;
@@ -366,6 +399,10 @@ extern MT_Lock GDKtmLock;
 #define GDKtrimLock(y)	GDKbbpLock[y].trim
 #define GDKcacheLock(y)	GDKbbpLock[y].cache
 #define BBP_free(y)	GDKbbpLock[y].free
+/* the reference counts themselves (BBP_refs and BBP_lrefs only read
+ * them) */
+#define BBP_refcnt(i)	(&BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].refs)
+#define BBP_lrefcnt(i)	(&BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].lrefs)
 
 /* extra space in front of strings in string heaps when hashash is set
  * if at least (2*SIZEOF_BUN), also store length (heaps are then
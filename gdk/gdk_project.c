@@ -32,15 +32,20 @@ project_##TYPE(BAT *bn, BAT *l, struct canditer *restrict ci, BAT *r, bool nilch
 	rseq = r->hseqbase;						\
 	rend = rseq + BATcount(r);					\
 	if (ci) {							\
-		for (lo = 0, hi = ci->ncand; lo < hi; lo++) {		\
-			oid o = canditer_next(ci);			\
-			if (o < rseq || o >= rend) {			\
+		oid o;							\
+		BUN n;							\
+		lo = 0;							\
+		while ((n = canditer_next_run(ci, &o, ci->ncand)) > 0) { \
+			if (o < rseq || o + n > rend) {			\
 				GDKerror("BATproject: does not match always\n"); \
 				return GDK_FAIL;			\
 			}						\
-			v = rt[o - rseq];				\
-			bt[lo] = v;					\
-			hasnil |= is_##TYPE##_nil(v);			\
+			const TYPE *restrict src = rt + (o - rseq);	\
+			for (hi = lo + n; lo < hi; lo++) {		\
+				v = *src++;				\
+				bt[lo] = v;				\
+				hasnil |= is_##TYPE##_nil(v);		\
+			}						\
 		}							\
 	} else {							\
 		const oid *restrict o = (const oid *) Tloc(l, 0);	\
@@ -96,13 +101,17 @@ project_void(BAT *bn, BAT *l, struct canditer *restrict ci, BAT *r)
 	bn->tnonil = true;
 	bn->tnil = false;
 	if (ci) {
-		for (lo = 0, hi = ci->ncand; lo < hi; lo++) {
-			oid o = canditer_next(ci);
-			if (o < rseq || o >= rend) {
+		oid o;
+		BUN n;
+		lo = 0;
+		while ((n = canditer_next_run(ci, &o, ci->ncand)) > 0) {
+			if (o < rseq || o + n > rend) {
 				GDKerror("BATproject: does not match always\n");
 				return GDK_FAIL;
 			}
-			bt[lo] = o - rseq + r->tseqbase;
+			o = o - rseq + r->tseqbase;
+			for (hi = lo + n; lo < hi; lo++)
+				bt[lo] = o++;
 		}
 	} else {
 		const oid *o = (const oid *) Tloc(l, 0);
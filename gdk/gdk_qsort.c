@@ -16,6 +16,11 @@ struct qsort_t {
 	int (*cmp)(const void *, const void *);
 	const char *base;
 	const void *nil;
+	/* for strings: the first four bytes of each string, see
+	 * strPFX below */
+	uint32_t *pfx;
+	const char *hbase;
+	unsigned int hshift;
 };
 
 #define glue(a, b, c)		a ## b ## c
@@ -161,6 +166,54 @@ struct qsort_t {
 #define varnil(i)		((*buf->cmp)(varOFF(i), buf->nil) == 0)
 #define varswap(i, j)		anyswap(i, j)
 
+/* Strings are sorted using a separate array with the first four bytes
+ * of each string as a big-endian integer (padded with zeros), which is
+ * kept in the same order as h.  Comparing those integers gives the
+ * same result as comparing the strings, so the string itself only
+ * needs to be looked at when the prefixes are equal.  The array is
+ * indexed relative to the start of the whole h array, since h moves
+ * during the sort. */
+#define STRPFXNIL		((uint32_t) 0x80000000)	/* str_nil */
+#define strPFX(i)		buf->pfx[((size_t) (h - buf->hbase) >> buf->hshift) + (i)]
+#define strCMP(i, j)		strpfxcmp(strPFX(i), strPFX(j), varOFF(i), varOFF(j))
+#define strltf(i, j)		(strCMP(i, j) < 0)
+#define strlef(i, j)		(strCMP(i, j) <= 0)
+#define strltl(i, j)		(!strnil(i) && (strnil(j) || strCMP(i, j) < 0))
+#define strlel(i, j)		(strnil(j) || (!strnil(i) && strCMP(i, j) <= 0))
+#define strltl_rev(i, j)	(strCMP(i, j) > 0)
+#define strlel_rev(i, j)	(strCMP(i, j) >= 0)
+#define strltf_rev(i, j)	(!strnil(j) && (strnil(i) || strCMP(i, j) > 0))
+#define strlef_rev(i, j)	(strnil(i) || (!strnil(j) && strCMP(i, j) >= 0))
+#define streq(i, j)		(strCMP(i, j) == 0)
+#define strnil(i)		(strPFX(i) == STRPFXNIL)
+#define strswap(i, j)							\
+	do {								\
+		uint32_t _p = strPFX(i);				\
+		strPFX(i) = strPFX(j);					\
+		strPFX(j) = _p;						\
+		anyswap(i, j);						\
+	} while (0)
+
+/* compare two strings with prefixes a and b like strCmp does,
+ * i.e. with nil as smallest value */
+static inline int
+strpfxcmp(uint32_t a, uint32_t b, const char *x, const char *y)
+{
+	if (a == b) {
+		/* if the prefix contains the terminating NUL byte
+		 * (and that includes nil), the strings are equal */
+		if ((a & 0xFF) == 0)
+			return 0;
+		return strCmpNoNil((const unsigned char *) x + 4,
+				   (const unsigned char *) y + 4);
+	}
+	if (a == STRPFXNIL)
+		return -1;
+	if (b == STRPFXNIL)
+		return 1;
+	return a < b ? -1 : 1;
+}
+
 #define LE(i, j, TPE, SUFF)	CONCAT3(TPE, le, SUFF)(i, j)
 #define LT(i, j, TPE, SUFF)	CONCAT3(TPE, lt, SUFF)(i, j)
 #define EQ(i, j, TPE)		CONCAT2(TPE, eq)(i, j)
@@ -195,6 +248,9 @@ struct qsort_t {
 		SWAP1((i) * buf->hs, (j) * buf->hs, h, n * buf->hs);	\
 		if (t)							\
 			SWAP1((i) * buf->ts, (j) * buf->ts, t, n * buf->ts); \
+		if (buf->pfx)						\
+			SWAP1((i) * sizeof(uint32_t), (j) * sizeof(uint32_t), \
+			      ((char *) &strPFX(0)), n * sizeof(uint32_t)); \
 	} while (0)
 
 /* From here we define and redefine tokens and include the
@@ -325,6 +381,21 @@ struct qsort_t {
 #undef SUFF
 #undef TPE
 
+#define TPE str
+#define SUFF f
+#include "gdk_qsort_impl.h"
+#undef SUFF
+#define SUFF l
+#include "gdk_qsort_impl.h"
+#undef SUFF
+#define SUFF l_rev
+#include "gdk_qsort_impl.h"
+#undef SUFF
+#define SUFF f_rev
+#include "gdk_qsort_impl.h"
+#undef SUFF
+#undef TPE
+
 #define TPE var
 #define SUFF f
 #include "gdk_qsort_impl.h"
@@ -340,6 +411,34 @@ struct qsort_t {
 #undef SUFF
 #undef TPE
 
+/* fill in the string prefixes; returns false if there is no memory
+ * for them, in which case the strings are sorted the generic way */
+static bool
+strpfxinit(struct qsort_t *buf, const char *h, size_t n)
+{
+	uint32_t *pfx;
+
+	if ((pfx = GDKmalloc(n * sizeof(uint32_t))) == NULL) {
+		/* GDKqsort doesn't fail */
+		GDKclrerr();
+		return false;
+	}
+	for (size_t i = 0; i < n; i++) {
+		const unsigned char *s = (const unsigned char *) varOFF(i);
+		uint32_t p = 0;
+		int k;
+
+		for (k = 0; k < 4 && s[k]; k++)
+			p = (p << 8) | s[k];
+		pfx[i] = p << (8 * (4 - k));
+	}
+	buf->pfx = pfx;
+	buf->hbase = h;
+	for (buf->hshift = 0; (1U << buf->hshift) < buf->hs; buf->hshift++)
+		;
+	return true;
+}
+
 /* the interface functions */
 void
 GDKqsort(void *restrict h, void *restrict t, const void *restrict base,
@@ -360,8 +459,27 @@ GDKqsort(void *restrict h, void *restrict t, const void *restrict base,
 	buf.cmp = ATOMcompare(tpe);
 	buf.base = base;
 	buf.nil = ATOMnilptr(tpe);
+	buf.pfx = NULL;
 	assert(ATOMvarsized(tpe) ? base != NULL : base == NULL);
 
+	if (ATOMstorage(tpe) == TYPE_str &&
+	    buf.cmp == (int (*)(const void *, const void *)) strCmp &&
+	    strpfxinit(&buf, h, n)) {
+		if (reverse) {
+			if (nilslast)
+				GDKqsort_impl_strl_rev(&buf, h, t, n);
+			else
+				GDKqsort_impl_strf_rev(&buf, h, t, n);
+		} else {
+			if (nilslast)
+				GDKqsort_impl_strl(&buf, h, t, n);
+			else
+				GDKqsort_impl_strf(&buf, h, t, n);
+		}
+		GDKfree(buf.pfx);
+		return;
+	}
+
 	tpe = ATOMbasetype(tpe);
 
 	if (reverse) {
@@ -323,7 +323,7 @@ hashselect(BAT *b, struct canditer *restrict ci, BAT *bn,
 /* scan select without imprints */
 
 /* core scan select loop with & without candidates */
-#define scanloop(NAME,canditer_next,TEST)				\
+#define scanloop(NAME,canditer_next,TEST,TYPE)				\
 	do {								\
 		*algo = #NAME " " #TEST " (" #canditer_next ")";	\
 		if (BATcapacity(bn) < maximum) {			\
@@ -339,12 +339,15 @@ hashselect(BAT *b, struct canditer *restrict ci, BAT *bn,
 				}					\
 			}						\
 		} else {						\
-			for (p = 0; p < ci->ncand; p++) {		\
-				o = canditer_next(ci);			\
-				v = src[o-hseq];			\
-				assert(cnt < BATcapacity(bn));		\
-				dst[cnt] = o;				\
-				cnt += (TEST) != 0;			\
+			/* process runs of consecutive candidates */	\
+			while ((p = canditer_next_run(ci, &o, ci->ncand)) > 0) { \
+				const TYPE *restrict run = src + (o - hseq); \
+				for (BUN q = 0; q < p; q++) {		\
+					v = run[q];			\
+					assert(cnt < BATcapacity(bn));	\
+					dst[cnt] = o + q;		\
+					cnt += (TEST) != 0;		\
+				}					\
 			}						\
 		}							\
 	} while (false)
@@ -403,7 +406,7 @@ hashselect(BAT *b, struct canditer *restrict ci, BAT *bn,
 		if (use_imprints) {				\
 			bitswitch(canditer_next, TEST, TYPE);	\
 		} else {					\
-			scanloop(NAME, canditer_next, TEST);	\
+			scanloop(NAME, canditer_next, TEST, TYPE); \
 		}						\
 	} while (false)
 
@@ -452,9 +455,9 @@ NAME##_##TYPE(BAT *b, struct canditer *restrict ci, BAT *bn,		\
 	if (equi) {							\
 		assert(!use_imprints);					\
 		if (lnil)						\
-			scanloop(NAME, canditer_next, is_##TYPE##_nil(v)); \
+			scanloop(NAME, canditer_next, is_##TYPE##_nil(v), TYPE); \
 		else							\
-			scanloop(NAME, canditer_next, v == vl);		\
+			scanloop(NAME, canditer_next, v == vl, TYPE);	\
 	} else if (anti) {						\
 		if (b->tnonil) {					\
 			choose(NAME, canditer_next, (v <= vl || v >= vh), TYPE); \
@@ -1528,7 +1531,7 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 	hash = equi &&
 		((!b->batTransient &&
 		  ATOMsize(b->ttype) >= sizeof(BUN) / 4 &&
-		  BATcount(b) * (ATOMsize(b->ttype) + 2 * sizeof(BUN)) < GDK_mem_maxsize / 2) ||
+		  BATcount(b) * (ATOMsize(b->ttype) + 2 * sizeof(BUN)) < GDKmemavail() / 2) ||
 		 BATcheckhash(b));
 	if (equi && !hash && parent != 0) {
 		/* use parent hash if it already exists and if either
@@ -1615,6 +1618,11 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 			 (parent != 0 &&
 			  (tmp = BBPquickdesc(parent, false)) != NULL &&
 			  !tmp->batTransient));
+		/* a full scan of a memory mapped column is I/O
+		 * latency bound when the column is not cached: have
+		 * the OS read ahead while we start scanning */
+		if (!use_imprints && ci.ncand == BATcount(b))
+			BATadvise(b, MMAP_WILLNEED);
 		bn = scanselect(b, &ci, bn, tl, th, li, hi, equi, anti,
 				lval, hval, lnil, maximum, use_imprints, &algo);
 	}
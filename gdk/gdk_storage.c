@@ -31,6 +31,12 @@
 #ifdef HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
 
 #ifndef O_CLOEXEC
 #define O_CLOEXEC 0
@@ -598,6 +604,356 @@ GDKload(int farmid, const char *nme, const char *ext, size_t size, size_t *maxsi
 	return ret;
 }
 
+/*
+ * @+ Compressed segments
+ *
+ * The heaps of a BAT that was marked for compression with BATcompress
+ * (the SQL layer does this for tables that are made read only) are
+ * saved as a compressed segment instead of as a raw image of the
+ * heap.  A segment starts with a header, followed by the heap cut up
+ * into blocks of SEGBLOCKSIZE bytes, each of which is compressed
+ * independently (LZ4 if available, otherwise zlib) and carries a
+ * CRC-32 checksum of its uncompressed contents, so that corruption is
+ * detected when the segment is read.  Blocks that do not compress are
+ * stored as is.  The header records the codec of the compressed
+ * blocks, so that a server built without that library can refuse to
+ * load the segment with a clear message.
+ *
+ * Segments are never memory mapped: the first access of the BAT reads
+ * and decompresses the whole segment into malloced memory.  A segment
+ * is only written if it is smaller than the raw heap, otherwise the
+ * heap is saved as usual.
+ */
+#define SEGMAGIC	"MDBSEG1"	/* including the NUL: 8 bytes */
+#define SEGVERSION	1
+#define SEGBLOCKSIZE	((size_t) 1 << 20)
+
+enum segcodec {
+	SEGRAW = 0,
+	SEGLZ4 = 1,
+	SEGZLIB = 2,
+};
+
+struct seghdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t blksize;	/* uncompressed size of a block */
+	uint64_t size;		/* uncompressed size of the heap */
+	uint64_t nblocks;
+	uint32_t codec;		/* enum segcodec of the compressed blocks */
+	uint32_t crc;		/* checksum of the preceding fields */
+};
+
+struct segblk {
+	uint32_t codec;		/* enum segcodec */
+	uint32_t clen;		/* number of bytes following */
+	uint32_t crc;		/* checksum of the uncompressed data */
+	uint32_t unused;
+};
+
+/* CRC-32 (the one used by zlib, so both variants produce the same
+ * checksums); len is at most SEGBLOCKSIZE */
+static uint32_t
+segcrc(const void *buf, size_t len)
+{
+#ifdef HAVE_LIBZ
+	return (uint32_t) crc32(0L, (const Bytef *) buf, (uInt) len);
+#else
+	const unsigned char *p = buf;
+	uint32_t crc = 0xFFFFFFFF;
+
+	while (len-- > 0) {
+		crc ^= *p++;
+		for (int i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+	return ~crc;
+#endif
+}
+
+static bool
+segread(int fd, void *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = read(fd, buf, (unsigned) MIN(1 << 30, len));
+		if (n <= 0)
+			return false;
+		buf = (char *) buf + n;
+		len -= (size_t) n;
+	}
+	return true;
+}
+
+static bool
+segheader(int fd, struct seghdr *hdr)
+{
+	return segread(fd, hdr, sizeof(*hdr)) &&
+		memcmp(hdr->magic, SEGMAGIC, sizeof(hdr->magic)) == 0 &&
+		hdr->version == SEGVERSION &&
+		hdr->crc == segcrc(hdr, offsetof(struct seghdr, crc)) &&
+		hdr->blksize > 0 &&
+		hdr->nblocks == (hdr->size + hdr->blksize - 1) / hdr->blksize;
+}
+
+/* can this server decompress blocks compressed with codec? */
+static bool
+segcodecavailable(uint32_t codec)
+{
+	switch (codec) {
+#ifdef HAVE_LIBLZ4
+	case SEGLZ4:
+		return true;
+#endif
+#ifdef HAVE_LIBZ
+	case SEGZLIB:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+#if defined(HAVE_LIBLZ4) || defined(HAVE_LIBZ)
+static bool
+segwrite(int fd, const void *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = write(fd, buf, (unsigned) MIN(1 << 30, len));
+		if (n < 0)
+			return false;
+		buf = (const char *) buf + n;
+		len -= (size_t) n;
+	}
+	return true;
+}
+
+/* compress len bytes from src into dst, which has room for len bytes;
+ * return the compressed size, or 0 if the block is to be stored as
+ * is */
+static size_t
+segcompress(const char *src, size_t len, char *dst, uint32_t *codec)
+{
+#ifdef HAVE_LIBLZ4
+	int n = LZ4_compress_default(src, dst, (int) len, (int) len);
+	if (n > 0 && (size_t) n < len) {
+		*codec = SEGLZ4;
+		return (size_t) n;
+	}
+#else
+	uLongf n = (uLongf) len;
+	if (compress2((Bytef *) dst, &n, (const Bytef *) src, (uLong) len, Z_BEST_SPEED) == Z_OK &&
+	    n < len) {
+		*codec = SEGZLIB;
+		return (size_t) n;
+	}
+#endif
+	*codec = SEGRAW;
+	return 0;
+}
+#endif
+
+static bool
+segdecompress(uint32_t codec, const char *src, size_t clen, char *dst, size_t len)
+{
+	switch (codec) {
+#ifdef HAVE_LIBLZ4
+	case SEGLZ4:
+		return LZ4_decompress_safe(src, dst, (int) clen, (int) len) == (int) len;
+#endif
+#ifdef HAVE_LIBZ
+	case SEGZLIB: {
+		uLongf n = (uLongf) len;
+		return uncompress((Bytef *) dst, &n, (const Bytef *) src, (uLong) clen) == Z_OK && n == len;
+	}
+#endif
+	default:
+		(void) src;
+		(void) clen;
+		(void) dst;
+		(void) len;
+		return false;
+	}
+}
+
+/* Write size bytes from buf as a compressed segment to the file
+ * nme.ext.  The segment is written to a temporary file first which
+ * then replaces nme.ext, so that a crash leaves either the old file
+ * or the complete segment.  If the segment would not be smaller than
+ * the raw data, nothing is written and *saved is set to false. */
+gdk_return
+GDKsavesegment(int farmid, const char *nme, const char *ext, const void *buf, size_t size, bool *saved)
+{
+	*saved = false;
+#if !defined(HAVE_LIBLZ4) && !defined(HAVE_LIBZ)
+	/* no compression library, always save the raw heap */
+	(void) farmid;
+	(void) nme;
+	(void) ext;
+	(void) buf;
+	(void) size;
+	return GDK_SUCCEED;
+#else
+	struct seghdr hdr = {
+		.magic = SEGMAGIC,
+		.version = SEGVERSION,
+		.blksize = (uint32_t) SEGBLOCKSIZE,
+		.size = (uint64_t) size,
+		.nblocks = (uint64_t) ((size + SEGBLOCKSIZE - 1) / SEGBLOCKSIZE),
+#ifdef HAVE_LIBLZ4
+		.codec = SEGLZ4,
+#else
+		.codec = SEGZLIB,
+#endif
+	};
+	size_t written = sizeof(hdr);
+	char *cbuf;
+	int fd;
+	bool ok;
+
+	assert(!GDKinmemory());
+	if (size <= SEGBLOCKSIZE / 16)
+		return GDK_SUCCEED; /* not worth the trouble */
+	hdr.crc = segcrc(&hdr, offsetof(struct seghdr, crc));
+	if ((cbuf = GDKmalloc(SEGBLOCKSIZE)) == NULL)
+		return GDK_FAIL;
+	if ((fd = GDKfdlocate(farmid, nme, "wb", "tmp")) < 0) {
+		GDKfree(cbuf);
+		GDKsyserror("GDKsavesegment: cannot create %s.tmp\n", nme);
+		return GDK_FAIL;
+	}
+	ok = segwrite(fd, &hdr, sizeof(hdr));
+	for (size_t off = 0; ok && off < size; off += SEGBLOCKSIZE) {
+		const char *src = (const char *) buf + off;
+		size_t len = MIN(SEGBLOCKSIZE, size - off);
+		struct segblk blk = {
+			.crc = segcrc(src, len),
+		};
+		size_t clen = segcompress(src, len, cbuf, &blk.codec);
+
+		blk.clen = (uint32_t) (clen ? clen : len);
+		written += sizeof(blk) + blk.clen;
+		if (written >= size)
+			break;	/* doesn't pay */
+		ok = segwrite(fd, &blk, sizeof(blk)) &&
+			segwrite(fd, clen ? cbuf : src, blk.clen);
+	}
+	GDKfree(cbuf);
+	if (!ok)
+		GDKsyserror("GDKsavesegment: error writing %s.tmp\n", nme);
+	else if (written < size &&
+		 !(GDKdebug & NOSYNCMASK)
+#if defined(NATIVE_WIN32)
+		 && _commit(fd) < 0
+#elif defined(HAVE_FDATASYNC)
+		 && fdatasync(fd) < 0
+#elif defined(HAVE_FSYNC)
+		 && fsync(fd) < 0
+#else
+		 && 0
+#endif
+		) {
+		GDKsyserror("GDKsavesegment: error syncing %s.tmp\n", nme);
+		ok = false;
+	}
+	if (close(fd) < 0)
+		ok = false;
+	if (!ok || written >= size) {
+		if (GDKunlink(farmid, BATDIR, nme, "tmp") != GDK_SUCCEED)
+			ok = false;
+		return ok ? GDK_SUCCEED : GDK_FAIL;
+	}
+	if (GDKmove(farmid, BATDIR, nme, "tmp", BATDIR, nme, ext) != GDK_SUCCEED)
+		return GDK_FAIL;
+	IODEBUG fprintf(stderr, "#GDKsavesegment: name=%s, ext=%s, %zu -> %zu bytes\n", nme, ext, size, written);
+	*saved = true;
+	return GDK_SUCCEED;
+#endif
+}
+
+/* Is the file nme.ext a compressed segment? */
+bool
+GDKissegment(int farmid, const char *nme, const char *ext)
+{
+	struct seghdr hdr;
+	int fd;
+	bool ret;
+
+	if ((fd = GDKfdlocate(farmid, nme, "rb", ext)) < 0)
+		return false;
+	ret = segheader(fd, &hdr);
+	close(fd);
+	return ret;
+}
+
+/* Read the compressed segment nme.ext into newly allocated memory of
+ * at least *maxsize bytes, verifying the checksums of all blocks.
+ * The segment must contain at least size bytes. */
+char *
+GDKloadsegment(int farmid, const char *nme, const char *ext, size_t size, size_t *maxsize)
+{
+	struct seghdr hdr;
+	char *ret = NULL, *cbuf = NULL;
+	int fd;
+
+	assert(!GDKinmemory());
+	IODEBUG fprintf(stderr, "#GDKloadsegment: name=%s, ext=%s\n", nme, ext);
+	if ((fd = GDKfdlocate(farmid, nme, "rb", ext)) < 0) {
+		GDKerror("GDKloadsegment: cannot open: name=%s, ext=%s\n", nme, ext);
+		return NULL;
+	}
+	if (!segheader(fd, &hdr) || hdr.size < size ||
+	    hdr.blksize > SEGBLOCKSIZE) {
+		GDKerror("GDKloadsegment: bad segment header: name=%s, ext=%s\n", nme, ext);
+		close(fd);
+		return NULL;
+	}
+	if (!segcodecavailable(hdr.codec)) {
+		GDKerror("GDKloadsegment: segment compressed with %s, which this server was built without: name=%s, ext=%s\n",
+			 hdr.codec == SEGLZ4 ? "LZ4" :
+			 hdr.codec == SEGZLIB ? "zlib" : "an unknown codec",
+			 nme, ext);
+		close(fd);
+		return NULL;
+	}
+	if (*maxsize < hdr.size)
+		*maxsize = (size_t) hdr.size;
+	if ((ret = GDKmalloc(*maxsize)) == NULL ||
+	    (cbuf = GDKmalloc(hdr.blksize)) == NULL) {
+		GDKfree(ret);
+		close(fd);
+		return NULL;
+	}
+	for (size_t off = 0; off < hdr.size; off += hdr.blksize) {
+		size_t len = (size_t) MIN(hdr.blksize, hdr.size - off);
+		struct segblk blk;
+		bool ok;
+
+		ok = segread(fd, &blk, sizeof(blk)) && blk.clen <= len &&
+			(blk.codec == SEGRAW || blk.codec == hdr.codec);
+		if (ok && blk.codec == SEGRAW)
+			ok = blk.clen == len && segread(fd, ret + off, len);
+		else if (ok)
+			ok = segread(fd, cbuf, blk.clen) &&
+				segdecompress(blk.codec, cbuf, blk.clen, ret + off, len);
+		if (!ok || blk.crc != segcrc(ret + off, len)) {
+			GDKerror("GDKloadsegment: corrupt block at offset %zu: name=%s, ext=%s\n", off, nme, ext);
+			GDKfree(cbuf);
+			GDKfree(ret);
+			close(fd);
+			return NULL;
+		}
+	}
+	GDKfree(cbuf);
+	close(fd);
+#ifndef NDEBUG
+	/* just to make valgrind happy, we initialize the whole
+	 * thing */
+	if (*maxsize > hdr.size)
+		memset(ret + hdr.size, 0, *maxsize - (size_t) hdr.size);
+#endif
+	return ret;
+}
+
 /*
  * @+ BAT disk storage
  *
@@ -789,13 +1145,17 @@ BATsave(BAT *bd)
 	nme = BBP_physical(b->batCacheid);
 	if (!b->batCopiedtodisk || b->batDirtydesc || b->theap.dirty)
 		if (err == GDK_SUCCEED && b->ttype)
-			err = HEAPsave(&b->theap, nme, "tail");
+			err = b->theap.compressed ?
+				HEAPsavesegment(&b->theap, nme, "tail") :
+				HEAPsave(&b->theap, nme, "tail");
 	if (b->tvheap
 	    && (!b->batCopiedtodisk || b->batDirtydesc || b->tvheap->dirty)
 	    && b->ttype
 	    && b->tvarsized
 	    && err == GDK_SUCCEED)
-		err = HEAPsave(b->tvheap, nme, "theap");
+		err = b->tvheap->compressed ?
+			HEAPsavesegment(b->tvheap, nme, "theap") :
+			HEAPsave(b->tvheap, nme, "theap");
 
 	if (err == GDK_SUCCEED) {
 		bd->batCopiedtodisk = true;
@@ -824,6 +1184,9 @@ BATload_intern(bat bid, bool lock)
 	if (b == NULL) {
 		return NULL;
 	}
+	/* not checked by BBPinit */
+	if (GDK_lazy_checkbats && BBPcheckbat(b) != GDK_SUCCEED)
+		return NULL;
 
 	/* LOAD bun heap */
 	if (b->ttype != TYPE_void) {
@@ -38,6 +38,15 @@
  * string heap, and allocating space for collision lists in the first
  * 64KiB of the string heap.  After the first 64KiB no extra space is
  * allocated for lists, so hash collisions cannot be resolved.
+ *
+ * To still catch most duplicates in large heaps (think of the same
+ * few log messages being inserted over and over again), strPut also
+ * maintains a separate, set-associative table of (hash, offset)
+ * pairs once the heap has outgrown 64KiB.  This table lives next to
+ * the heap in memory (Heap.dedup).  It grows with the number of
+ * strings up to a memory budget that is shared by the tables of all
+ * heaps, after which entries of full sets get replaced.  The table is not saved: when the heap is loaded
+ * again, it is seeded from the first 64KiB and refilled by strPut.
  */
 
 /* some of these macros are duplicates from gdk_atoms.c */
@@ -187,6 +196,223 @@ strCleanHash(Heap *h, bool rebuild)
 	h->cleanhash = false;
 }
 
+/* number of entries per set of the dedup table */
+#define STRDEDUP_WAYS		4
+/* initial number of sets */
+#define STRDEDUP_MINSETS	((BUN) 1 << 10)
+/* the tables of all heaps together never grow beyond this many bytes,
+ * nor beyond 1/64th of the memory we are allowed to use */
+#define STRDEDUP_MAXSIZE	((size_t) 1 << 28)
+
+/* total size of all dedup tables; tables of the initial size are
+ * always allowed, only growing them is subject to the budget */
+static ATOMIC_TYPE strdedup_size = ATOMIC_VAR_INIT(0);
+
+struct strdedup {
+	size_t free;		/* h->free when last maintained */
+	BUN mask;		/* number of sets - 1 */
+	BUN count;		/* number of occupied entries */
+	unsigned victim;	/* way to replace in the next full set */
+	struct strdedupent {
+		BUN hash;	/* full string hash value */
+		var_t off;	/* offset of string, 0 if empty */
+	} ent[];		/* (mask + 1) * STRDEDUP_WAYS entries */
+};
+
+#define STRDEDUPSIZE(nsets)	(offsetof(struct strdedup, ent) + (nsets) * STRDEDUP_WAYS * sizeof(struct strdedupent))
+
+static void
+strDedupFree(struct strdedup *d)
+{
+	if (d) {
+		(void) ATOMIC_SUB(&strdedup_size, STRDEDUPSIZE(d->mask + 1));
+		GDKfree(d);
+	}
+}
+
+void
+strDedupDestroy(Heap *h)
+{
+	strDedupFree(h->dedup);
+	h->dedup = NULL;
+}
+
+/* enter the string at offset off into set hash & mask; in a full set
+ * we replace the ways in turn (rather than the least recently used
+ * one, which would make a set that is cycled through by one string
+ * too many miss all the time) */
+static inline void
+strDedupEnter(struct strdedup *d, BUN hash, var_t off)
+{
+	struct strdedupent *e = d->ent + (hash & d->mask) * STRDEDUP_WAYS;
+	int j;
+
+	for (j = 0; j < STRDEDUP_WAYS; j++) {
+		if (e[j].off == 0) {
+			d->count++;
+			break;
+		}
+	}
+	if (j == STRDEDUP_WAYS)
+		j = d->victim++ % STRDEDUP_WAYS;
+	e[j] = (struct strdedupent) {.hash = hash, .off = off};
+}
+
+static struct strdedup *
+strDedupNew(BUN nsets)
+{
+	const size_t size = STRDEDUPSIZE(nsets);
+	struct strdedup *d;
+
+	if (nsets > STRDEDUP_MINSETS) {
+		size_t budget = MIN(STRDEDUP_MAXSIZE, GDK_mem_maxsize / 64);
+		ATOMIC_BASE_TYPE total = ATOMIC_GET(&strdedup_size);
+
+		do {
+			if (total + size > budget)
+				return NULL;
+		} while (!ATOMIC_CAS(&strdedup_size, &total, total + size));
+	} else {
+		(void) ATOMIC_ADD(&strdedup_size, size);
+	}
+	if ((d = GDKzalloc(size)) == NULL) {
+		/* not having the table only costs space, so this is
+		 * not an error */
+		(void) ATOMIC_SUB(&strdedup_size, size);
+		GDKclrerr();
+		return NULL;
+	}
+	d->mask = nsets - 1;
+	return d;
+}
+
+/* Create the dedup table of a heap that just outgrew GDK_ELIMLIMIT,
+ * or that was loaded from disk.  The strings in the fully double
+ * eliminated first part of the heap can be found by walking the
+ * heap, the rest will be entered as they are encountered.
+ *
+ * The walk (like the one in strCleanHash) relies on the layout that
+ * strPut creates in that part of the heap: strings follow each other
+ * without gaps, each one starting at the first GDK_VARALIGN boundary
+ * that leaves room for the stridx_t link and, with hashash, the hash
+ * value in front of it.  Since an entry that is not the start of a
+ * string could be handed out as the offset of a (suffix of a)
+ * string, stop at the first string that doesn't end inside the
+ * heap. */
+static struct strdedup *
+strDedupCreate(Heap *h)
+{
+	struct strdedup *d;
+	const size_t extralen = h->hashash ? EXTRALEN : 0;
+	const size_t end = MIN(h->free, GDK_ELIMLIMIT);
+	size_t pad, pos, len;
+	const char *s;
+	BUN strhash;
+
+	if ((d = strDedupNew(STRDEDUP_MINSETS)) == NULL)
+		return NULL;
+	pos = GDK_STRHASHSIZE;
+	while (pos < end) {
+		pad = GDK_VARALIGN - (pos & (GDK_VARALIGN - 1));
+		if (pad < sizeof(stridx_t))
+			pad += GDK_VARALIGN;
+		pos += pad + extralen;
+		if (pos >= h->free)
+			break;
+		s = h->base + pos;
+		len = strnlen(s, h->free - pos);
+		if (len == h->free - pos) {
+			assert(0);	/* not laid out by strPut */
+			break;
+		}
+		if (h->hashash)
+			strhash = ((const BUN *) s)[-1];
+		else
+			GDK_STRHASH(s, strhash);
+		strDedupEnter(d, strhash, (var_t) pos);
+		pos += len + 1;
+	}
+	d->free = h->free;
+	return d;
+}
+
+/* double the number of sets if the table is getting full and the
+ * budget allows it */
+static struct strdedup *
+strDedupGrow(struct strdedup *d)
+{
+	BUN nsets = (d->mask + 1) * 2;
+	struct strdedup *n;
+
+	if ((n = strDedupNew(nsets)) == NULL)
+		return d;
+	for (BUN i = 0; i <= d->mask; i++) {
+		const struct strdedupent *e = d->ent + i * STRDEDUP_WAYS;
+		for (int j = 0; j < STRDEDUP_WAYS && e[j].off != 0; j++)
+			strDedupEnter(n, e[j].hash, e[j].off);
+	}
+	n->free = d->free;
+	strDedupFree(d);
+	return n;
+}
+
+/* find string v with hash value strhash in the dedup table of a
+ * large string heap, return its offset, or 0 if not found */
+static var_t
+strDedupLookup(Heap *h, const char *v, BUN strhash)
+{
+	struct strdedup *d = h->dedup;
+	struct strdedupent *e;
+
+	if (d == NULL || d->free > h->free) {
+		/* no table yet, or the heap was truncated behind our
+		 * back, so start afresh */
+		strDedupDestroy(h);
+		if ((d = h->dedup = strDedupCreate(h)) == NULL)
+			return 0;
+	}
+	e = d->ent + (strhash & d->mask) * STRDEDUP_WAYS;
+	for (int j = 0; j < STRDEDUP_WAYS && e[j].off != 0; j++) {
+		if (e[j].hash == strhash &&
+		    (!h->hashash ||
+		     ((const BUN *) (h->base + e[j].off))[-1] == strhash) &&
+		    GDK_STRCMP(v, h->base + e[j].off) == 0)
+			return e[j].off;
+	}
+	return 0;
+}
+
+/* like strLocate, but for large string heaps: return the offset of
+ * v if it is known to be in the heap, or 0 */
+var_t
+strDedupLocate(Heap *h, const char *v)
+{
+	BUN strhash;
+
+	assert(GDK_ELIMBASE(h->free) != 0);
+	GDK_STRHASH(v, strhash);
+	return strDedupLookup(h, v, strhash);
+}
+
+/* enter a newly inserted string of a large heap */
+static void
+strDedupInsert(Heap *h, BUN strhash, var_t off)
+{
+	struct strdedup *d = h->dedup;
+
+	if (d == NULL)
+		return;
+	/* grow before we would have to replace an entry, unless the
+	 * table is still mostly empty (i.e. the hash values are just
+	 * unlucky), and in any case when it is getting full */
+	if ((d->ent[(strhash & d->mask) * STRDEDUP_WAYS + STRDEDUP_WAYS - 1].off != 0 &&
+	     d->count >= (d->mask + 1) * STRDEDUP_WAYS / 4) ||
+	    d->count >= (d->mask + 1) * STRDEDUP_WAYS / 4 * 3)
+		d = h->dedup = strDedupGrow(d);
+	strDedupEnter(d, strhash, off);
+	d->free = h->free;
+}
+
 /*
  * The strPut routine. The routine strLocate can be used to identify
  * the location of a string in the heap if it exists. Otherwise it
@@ -256,6 +482,12 @@ strPut(Heap *h, var_t *dst, const char *v)
 			}
 		}
 	}
+	if (elimbase != 0 &&
+	    (pos = strDedupLookup(h, v, strhash)) != 0) {
+		/* large string heap, but we have seen the string
+		 * before */
+		return *dst = (var_t) pos;
+	}
 	/* the string was not found in the heap, we need to enter it */
 
 	if (v[0] != '\200' || v[1] != '\0') {
@@ -363,6 +595,8 @@ strPut(Heap *h, var_t *dst, const char *v)
 		 * value */
 		pos -= sizeof(stridx_t);
 		*(stridx_t *) (h->base + pos) = *bucket;
+	} else {
+		strDedupInsert(h, strhash, *dst);
 	}
 	*bucket = (stridx_t) pos;	/* set bucket to the new string */
 
@@ -51,6 +51,11 @@
 ATOMIC_TYPE GDKlockcnt = ATOMIC_VAR_INIT(0);
 ATOMIC_TYPE GDKlockcontentioncnt = ATOMIC_VAR_INIT(0);
 ATOMIC_TYPE GDKlocksleepcnt = ATOMIC_VAR_INIT(0);
+/* BAT reference count changes without (fast) and with (slow) the
+ * swap lock, and retries of the former due to concurrent changes */
+ATOMIC_TYPE GDKbbpfastcnt = ATOMIC_VAR_INIT(0);
+ATOMIC_TYPE GDKbbpslowcnt = ATOMIC_VAR_INIT(0);
+ATOMIC_TYPE GDKbbpretrycnt = ATOMIC_VAR_INIT(0);
 MT_Lock *volatile GDKlocklist = 0;
 ATOMIC_FLAG GDKlocklistlock = ATOMIC_FLAG_INIT;
 
@@ -137,6 +142,9 @@ GDKlockstatistics(int what)
 			ATOMIC_SET(&l->contention, 0);
 			ATOMIC_SET(&l->sleep, 0);
 		}
+		ATOMIC_SET(&GDKbbpfastcnt, 0);
+		ATOMIC_SET(&GDKbbpslowcnt, 0);
+		ATOMIC_SET(&GDKbbpretrycnt, 0);
 		ATOMIC_CLEAR(&GDKlocklistlock);
 		return;
 	}
@@ -160,6 +168,9 @@ GDKlockstatistics(int what)
 	fprintf(stderr, "#total lock count %zu\n", (size_t) ATOMIC_GET(&GDKlockcnt));
 	fprintf(stderr, "#lock contention  %zu\n", (size_t) ATOMIC_GET(&GDKlockcontentioncnt));
 	fprintf(stderr, "#lock sleep count %zu\n", (size_t) ATOMIC_GET(&GDKlocksleepcnt));
+	fprintf(stderr, "#BAT refs unlocked %zu\n", (size_t) ATOMIC_GET(&GDKbbpfastcnt));
+	fprintf(stderr, "#BAT refs locked   %zu\n", (size_t) ATOMIC_GET(&GDKbbpslowcnt));
+	fprintf(stderr, "#BAT refs retried  %zu\n", (size_t) ATOMIC_GET(&GDKbbpretrycnt));
 	ATOMIC_CLEAR(&GDKlocklistlock);
 }
 
@@ -492,6 +492,9 @@ gdk_export ATOMIC_FLAG GDKlocklistlock;
 gdk_export ATOMIC_TYPE GDKlockcnt;
 gdk_export ATOMIC_TYPE GDKlockcontentioncnt;
 gdk_export ATOMIC_TYPE GDKlocksleepcnt;
+gdk_export ATOMIC_TYPE GDKbbpfastcnt;
+gdk_export ATOMIC_TYPE GDKbbpslowcnt;
+gdk_export ATOMIC_TYPE GDKbbpretrycnt;
 #endif
 
 /*
@@ -284,6 +284,8 @@ BATSIGinit(void)
 size_t GDK_mmap_minsize_persistent = MMAP_MINSIZE_PERSISTENT;
 size_t GDK_mmap_minsize_transient = MMAP_MINSIZE_TRANSIENT;
 size_t GDK_mmap_pagesize = MMAP_PAGESIZE; /* mmap granularity */
+bool GDK_hugepages = false;	/* advise huge pages for large heaps */
+bool GDK_lazy_checkbats = false; /* check BAT files when first loaded */
 size_t GDK_mem_maxsize = GDK_VM_MAXSIZE;
 size_t GDK_vm_maxsize = GDK_VM_MAXSIZE;
 
@@ -680,6 +682,10 @@ GDKinit(opt *set, int setlen)
 
 	/* Mserver by default takes 80% of all memory as a default */
 	GDK_mem_maxsize = (size_t) ((double) MT_npages() * (double) MT_pagesize() * 0.815);
+	/* needed by BBPinit, so can't wait for the other options */
+	if ((p = mo_find_option(set, setlen, "gdk_lazy_checkbats")) != NULL)
+		GDK_lazy_checkbats = strcasecmp(p, "yes") == 0 ||
+			strcasecmp(p, "true") == 0;
 	if (BBPinit() != GDK_SUCCEED)
 		return GDK_FAIL;
 
@@ -726,6 +732,9 @@ GDKinit(opt *set, int setlen)
 			GDK_mmap_minsize_persistent = (size_t) strtoll(n[i].value, NULL, 10);
 		} else if (strcmp("gdk_mmap_minsize_transient", n[i].name) == 0) {
 			GDK_mmap_minsize_transient = (size_t) strtoll(n[i].value, NULL, 10);
+		} else if (strcmp("gdk_hugepages", n[i].name) == 0) {
+			GDK_hugepages = strcasecmp(n[i].value, "yes") == 0 ||
+				strcasecmp(n[i].value, "true") == 0;
 		} else if (strcmp("gdk_mmap_pagesize", n[i].name) == 0) {
 			GDK_mmap_pagesize = (size_t) strtoll(n[i].value, NULL, 10);
 			if (GDK_mmap_pagesize < 1 << 12 ||
@@ -860,6 +869,8 @@ GDKprepareExit(void)
 	join_detached_threads();
 }
 
+static void GDKpoolclear(void);
+
 void
 GDKreset(int status)
 {
@@ -928,9 +939,12 @@ GDKreset(int status)
 		GDK_mmap_minsize_persistent = MMAP_MINSIZE_PERSISTENT;
 		GDK_mmap_minsize_transient = MMAP_MINSIZE_TRANSIENT;
 		GDK_mmap_pagesize = MMAP_PAGESIZE;
+		GDK_hugepages = false;
+		GDK_lazy_checkbats = false;
 		GDK_mem_maxsize = (size_t) ((double) MT_npages() * (double) MT_pagesize() * 0.815);
 		GDK_vm_maxsize = GDK_VM_MAXSIZE;
 		GDKatomcnt = TYPE_str + 1;
+		GDKpoolclear();
 
 		if (GDK_mem_maxsize / 16 < GDK_mmap_minsize_transient) {
 			GDK_mmap_minsize_transient = GDK_mem_maxsize / 16;
@@ -1568,6 +1582,83 @@ THRcreate(void (*f) (void *), void *arg, enum MT_thr_detach d, const char *name)
 	return pid;
 }
 
+/* Run func(arg, i) for all i in [0, n) on up to nthreads threads, the
+ * calling thread being one of them.  The items are handed out chunk
+ * at a time from a shared counter, so if not all threads can be
+ * started, the ones we have (and we) do the rest.  Once an item has
+ * failed, no new items are started. */
+struct GDKparallel {
+	gdk_return (*func)(void *, int); /* handle a single item */
+	void *arg;
+	int n;			/* number of items */
+	int chunk;		/* number of items handed out at a time */
+	ATOMIC_TYPE next;	/* start of next chunk of items */
+	ATOMIC_TYPE failed;	/* whether an item failed */
+};
+
+static void
+GDKparallel_worker(void *arg)
+{
+	struct GDKparallel *w = arg;
+	int i, e;
+
+	while (ATOMIC_GET(&w->failed) == 0 &&
+	       (i = (int) ATOMIC_ADD(&w->next, w->chunk)) < w->n) {
+		for (e = MIN(i + w->chunk, w->n); i < e; i++) {
+			if ((*w->func)(w->arg, i) != GDK_SUCCEED) {
+				ATOMIC_SET(&w->failed, 1);
+				break;
+			}
+		}
+	}
+}
+
+gdk_return
+GDKparallel(const char *name, int nthreads, int n, int chunk,
+	    gdk_return (*func)(void *, int), void *arg)
+{
+	struct GDKparallel w = {
+		.func = func,
+		.arg = arg,
+		.n = n,
+		.chunk = chunk,
+	};
+	MT_Id tid0, *tids = &tid0;
+	gdk_return ret;
+
+	assert(chunk > 0);
+	nthreads = MIN(nthreads, (n + chunk - 1) / chunk);
+	if (nthreads > 1) {
+		if ((tids = GDKmalloc(nthreads * sizeof(MT_Id))) == NULL) {
+			GDKclrerr();
+			tids = &tid0;
+			nthreads = 1;
+		}
+	}
+	ATOMIC_INIT(&w.next, 0);
+	ATOMIC_INIT(&w.failed, 0);
+	for (int i = 1; i < nthreads; i++) {
+		char tname[24];
+		snprintf(tname, sizeof(tname), "%s%d", name, i);
+		if ((tids[i] = THRcreate(GDKparallel_worker, &w, MT_THR_JOINABLE, tname)) == 0) {
+			GDKclrerr();
+			nthreads = i;
+			break;
+		}
+	}
+	GDKparallel_worker(&w);
+	for (int i = 1; i < nthreads; i++)
+		MT_join_thread(tids[i]);
+	if (tids != &tid0)
+		GDKfree(tids);
+	ret = ATOMIC_GET(&w.failed) ? GDK_FAIL : GDK_SUCCEED;
+	ATOMIC_DESTROY(&w.next);
+	ATOMIC_DESTROY(&w.failed);
+	return ret;
+}
+
+static void GDKmemrelease_thread(Thread t, size_t size);
+
 void
 THRdel(Thread t)
 {
@@ -1577,6 +1668,8 @@ THRdel(Thread t)
 			 (size_t) ATOMIC_GET(&t->pid),
 			 (int) ATOMIC_GET(&GDKnrofthreads));
 
+	if (t->memreserved > 0)
+		GDKmemrelease_thread(t, t->memreserved);
 	GDKfree(t->name);
 	t->name = NULL;
 	for (int i = 0; i < THREADDATA; i++)
@@ -1702,6 +1795,121 @@ GDKvm_cursize(void)
 	return (size_t) ATOMIC_GET(&GDK_vm_cursize) + GDKmem_cursize();
 }
 
+/* Memory broker
+ *
+ * Operators that are about to build sizable auxiliary structures
+ * (hash tables, sort buffers, partitions) ask the broker for a budget
+ * with GDKmemreserve and give it back with GDKmemrelease.  The broker
+ * hands out the memory that is not yet in use (or reserved) in fair
+ * shares over the threads that currently hold a reservation, so that
+ * the budget shrinks automatically when more work runs concurrently
+ * and grows again when it finishes.  Reservations are tracked per
+ * thread; a thread that exits returns whatever it still holds.
+ *
+ * Reserved memory is usually in use by the time the heap allocators
+ * look at GDKmem_cursize, so the two are not added up: the larger of
+ * the two is taken as the amount of memory that is spoken for.
+ *
+ * GDKmemavail is called on every heap allocation, so the counters are
+ * kept in atomics and no lock is taken anywhere in the broker: a
+ * reservation is admitted with a compare-and-swap on the total, which
+ * is retried (and the admission decision redone) when another thread
+ * changed the total in the meantime.  The per-thread amount is only
+ * ever touched by the thread itself. */
+static ATOMIC_TYPE GDKmem_reserved = ATOMIC_VAR_INIT(0); /* total outstanding reservations */
+static ATOMIC_TYPE GDKmem_holders = ATOMIC_VAR_INIT(0); /* threads with a reservation */
+
+static size_t
+GDKmem_free(size_t reserved)
+{
+	size_t used = GDKmem_cursize();
+
+	if (used < reserved)
+		used = reserved;
+	return used < GDK_mem_maxsize ? GDK_mem_maxsize - used : 0;
+}
+
+/* Reserve between min and want bytes; return the amount granted,
+ * which is 0 if not even min is available.  A thread that is the only
+ * one holding a reservation always gets at least min, so that there
+ * is always some work that can proceed. */
+size_t
+GDKmemreserve(size_t want, size_t min)
+{
+	Thread t = GDK_find_self();
+	ATOMIC_BASE_TYPE reserved;
+	size_t free, share, grant;
+	int others;
+
+	if (min > want)
+		min = want;
+	if (want == 0)
+		return 0;
+	others = (int) ATOMIC_GET(&GDKmem_holders) - (t && t->memreserved > 0);
+	if (others < 0)
+		others = 0;
+	reserved = ATOMIC_GET(&GDKmem_reserved);
+	do {
+		free = GDKmem_free((size_t) reserved);
+		share = free / (size_t) (others + 1);
+		grant = MIN(want, MAX(share, min));
+		if (grant == 0 || (grant > free && others > 0)) {
+			ALGODEBUG fprintf(stderr, "#GDKmemreserve(%zu,%zu): denied, free %zu, holders %d\n", want, min, free, others);
+			return 0;
+		}
+	} while (!ATOMIC_CAS(&GDKmem_reserved, &reserved, reserved + grant));
+	if (t) {
+		if (t->memreserved == 0)
+			(void) ATOMIC_INC(&GDKmem_holders);
+		t->memreserved += grant;
+	}
+	ALGODEBUG fprintf(stderr, "#GDKmemreserve(%zu,%zu): granted %zu, free %zu, holders %d\n", want, min, grant, free, others + 1);
+	return grant;
+}
+
+static void
+GDKmemrelease_thread(Thread t, size_t size)
+{
+	ATOMIC_BASE_TYPE reserved;
+
+	if (t) {
+		if (size > t->memreserved)
+			size = t->memreserved;
+		t->memreserved -= size;
+		if (size > 0 && t->memreserved == 0)
+			(void) ATOMIC_DEC(&GDKmem_holders);
+	}
+	/* reservations made without a thread record are not tracked
+	 * per thread, so clamp rather than trust the caller */
+	reserved = ATOMIC_GET(&GDKmem_reserved);
+	while (!ATOMIC_CAS(&GDKmem_reserved, &reserved, reserved - MIN((ATOMIC_BASE_TYPE) size, reserved)))
+		;
+}
+
+/* Give back size bytes of an earlier reservation. */
+void
+GDKmemrelease(size_t size)
+{
+	if (size > 0)
+		GDKmemrelease_thread(GDK_find_self(), size);
+}
+
+/* The amount of memory the calling thread can count on: its own
+ * reservation plus its fair share of what is still free.  Without any
+ * outstanding reservations this is simply the memory not in use.  The
+ * counters are read without a lock; the result is an estimate anyway. */
+size_t
+GDKmemavail(void)
+{
+	Thread t = GDK_find_self();
+	size_t own = t ? t->memreserved : 0;
+	int others = (int) ATOMIC_GET(&GDKmem_holders) - (own > 0);
+
+	if (others < 0)
+		others = 0;
+	return own + GDKmem_free((size_t) ATOMIC_GET(&GDKmem_reserved)) / (size_t) (others + 1);
+}
+
 #define heapinc(_memdelta)						\
 	(void) ATOMIC_ADD(&GDK_mallocedbytes_estimate, _memdelta)
 #define heapdec(_memdelta)						\
@@ -2036,6 +2244,134 @@ GDKstrndup(const char *s, size_t size)
 
 #endif	/* STATIC_CODE_ANALYSIS */
 
+/* Heap pool
+ *
+ * Malloced heaps of up to 1 MiB are allocated in power-of-two size
+ * classes, and when freed, kept on a free list per size class for
+ * reuse, up to a total of 1/64th of GDK_mem_maxsize (at most 64 MiB).
+ * Queries that create many small intermediates then rarely need to
+ * go to malloc, and the pool carries over from one query to the
+ * next.  Pooled blocks are ordinary GDKmalloc'ed memory, so they can
+ * be reallocated or freed with GDKfree like any other heap memory.
+ * In debug builds, blocks that go into the pool are checked and
+ * overwritten with the same pattern as GDKfree uses. */
+#define POOL_MINSHIFT	12	/* 4 KiB */
+#define POOL_MAXSHIFT	20	/* 1 MiB */
+#define POOL_MAXSIZE	((size_t) 64 << 20)
+
+static MT_Lock GDKpoollock = MT_LOCK_INITIALIZER("GDKpoollock");
+static void *GDKpool[POOL_MAXSHIFT - POOL_MINSHIFT + 1];
+static size_t GDKpool_size;	/* bytes kept in the pool */
+
+/* the size class for a heap of the given size */
+size_t
+GDKpoolsize(size_t size)
+{
+	size_t s = (size_t) 1 << POOL_MINSHIFT;
+
+	if (size > (size_t) 1 << POOL_MAXSHIFT)
+		return size;
+	while (s < size)
+		s <<= 1;
+	return s;
+}
+
+/* the free list index for size, or -1 if size is not a size class */
+static int
+GDKpoolclass(size_t size)
+{
+	int c = 0;
+
+	if (size < (size_t) 1 << POOL_MINSHIFT ||
+	    size > (size_t) 1 << POOL_MAXSHIFT ||
+	    (size & (size - 1)) != 0)
+		return -1;
+	while (((size_t) 1 << (POOL_MINSHIFT + c)) < size)
+		c++;
+	return c;
+}
+
+void *
+GDKpoolmalloc(size_t size)
+{
+	int c = GDKpoolclass(size);
+	void *s = NULL;
+
+	if (c >= 0) {
+		MT_lock_set(&GDKpoollock);
+		if ((s = GDKpool[c]) != NULL) {
+			GDKpool[c] = * (void **) s;
+			GDKpool_size -= size;
+		}
+		MT_lock_unset(&GDKpoollock);
+	}
+	return s ? s : GDKmalloc(size);
+}
+
+/* free a heap of the given size, keeping it for reuse if it is a
+ * block of exactly a size class */
+void
+GDKpoolfree(void *s, size_t size)
+{
+	int c = GDKpoolclass(size);
+
+	if (s == NULL)
+		return;
+#ifdef STATIC_CODE_ANALYSIS
+	c = -1;
+#else
+	if (c >= 0 &&
+	    ((size_t *) s)[-1] != size + MALLOC_EXTRA_SPACE + DEBUG_SPACE)
+		c = -1;
+#ifndef NDEBUG
+	if (c >= 0 && ((size_t *) s)[-2] != size)
+		c = -1;
+	if (c >= 0) {
+		/* a pooled block doesn't go through GDKfree, so do its
+		 * checks here: no out-of-bounds writes, and overwrite
+		 * the memory with the pattern that helps us recognize
+		 * access to already freed memory */
+		for (size_t i = size; i < size + DEBUG_SPACE; i++)
+			assert(((char *) s)[i] == '\xBD');
+		DEADBEEFCHK memset(s, '\xDB', size);
+	}
+#endif
+#endif
+	if (c >= 0) {
+		MT_lock_set(&GDKpoollock);
+		if (GDKpool_size + size <= MIN(POOL_MAXSIZE, GDK_mem_maxsize / 64)) {
+			* (void **) s = GDKpool[c];
+			GDKpool[c] = s;
+			GDKpool_size += size;
+			s = NULL;
+		}
+		MT_lock_unset(&GDKpoollock);
+	}
+	GDKfree(s);
+}
+
+static void
+GDKpoolclear(void)
+{
+	MT_lock_set(&GDKpoollock);
+	for (int c = 0; c <= POOL_MAXSHIFT - POOL_MINSHIFT; c++) {
+		while (GDKpool[c]) {
+			void *s = GDKpool[c];
+			GDKpool[c] = * (void **) s;
+			GDKfree(s);
+		}
+	}
+	GDKpool_size = 0;
+	MT_lock_unset(&GDKpoollock);
+}
+
+size_t
+GDKpool_cursize(void)
+{
+	/* heap memory that is kept for reuse */
+	return GDKpool_size;
+}
+
 void
 GDKsetmallocsuccesscount(lng count)
 {
@@ -76,6 +76,7 @@ mal_export lng OPTdebug;
 #define OPTsupport			((lng)1 << 31)
 #define OPTvolcano			((lng)1 << 32)
 #define OPTwlc				((lng)1 << 33)
+#define OPTfuse				((lng)1 << 34)
 
 mal_export lng MALdebug;
 
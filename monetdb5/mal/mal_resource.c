@@ -12,14 +12,14 @@
 #include "mal_resource.h"
 #include "mal_private.h"
 
-/* MEMORY admission does not seem to have a major impact so far. */
-static lng memorypool = 0;      /* memory claimed by concurrent threads */
+/* The memory itself is handed out by the GDK memory broker
+ * (GDKmemreserve), which also sees the budgets claimed by the
+ * operators; here we only count the admitted instructions. */
 static int memoryclaims = 0;
 
 void
 mal_resource_reset(void)
 {
-	memorypool = 0;
 	memoryclaims = 0;
 }
 /*
@@ -39,9 +39,10 @@ mal_resource_reset(void)
  * physical memory we pre-allocate for the claims.
  *
  * Instructions are eligible to be executed when the
- * total footprint of all concurrent executions stays below
- * the high-watermark or it is the single expensive
- * instruction being started.
+ * memory broker can grant their footprint, i.e. when it fits in
+ * their share of the memory that is neither in use nor reserved
+ * by other instructions and operators, or when it is the single
+ * expensive instruction being started.
  *
  * When we run out of memory, the instruction is delayed.
  * How long depends on the other instructions to free up
@@ -142,40 +143,36 @@ MALadmission(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, lng argcla
 			fprintf(stderr, "#DFLOWadmit memoryclaim reset ");
 		memoryclaims = 0;
 	}
-	if ( memorypool <= 0 && memoryclaims == 0){
-		PARDEBUG
-			fprintf(stderr, "#DFLOWadmit memorypool reset ");
-		memorypool = (lng) MEMORY_THRESHOLD;
-	}
 
 	/* the argument claim is based on the input for an instruction */
 	if (argclaim > 0) {
-		if ( memoryclaims == 0 || memorypool > argclaim ) {
-			/* If we are low on memory resources, limit the user if he exceeds his memory budget 
-			 * but make sure there is at least one thread active */
-			if ( cntxt->memorylimit) {
-				mbytes = (lng) cntxt->memorylimit * LL_CONSTANT(1048576);
-				if (argclaim + stk->memory > mbytes){
-					MT_lock_unset(&admissionLock);
-					PARDEBUG
-						fprintf(stderr, "#Delayed due to lack of session memory " LLFMT " requested "LLFMT"\n", 
-								stk->memory, argclaim);
-					return -1;
-				}
+		/* If we are low on memory resources, limit the user if he exceeds his memory budget 
+		 * but make sure there is at least one thread active */
+		if ( cntxt->memorylimit) {
+			mbytes = (lng) cntxt->memorylimit * LL_CONSTANT(1048576);
+			if (argclaim + stk->memory > mbytes){
+				MT_lock_unset(&admissionLock);
+				PARDEBUG
+					fprintf(stderr, "#Delayed due to lack of session memory " LLFMT " requested "LLFMT"\n", 
+							stk->memory, argclaim);
+				return -1;
 			}
-			memorypool -= argclaim;
+		}
+		/* the broker grants all or nothing, and always grants
+		 * when nobody else holds a reservation */
+		if (GDKmemreserve((size_t) argclaim, (size_t) argclaim) > 0) {
 			stk->memory += argclaim;
 			memoryclaims++;
 			PARDEBUG
-				fprintf(stderr, "#DFLOWadmit %3d thread %d pool " LLFMT "claims " LLFMT "\n",
-						 memoryclaims, THRgettid(), memorypool, argclaim);
+				fprintf(stderr, "#DFLOWadmit %3d thread %d avail %zu claims " LLFMT "\n",
+						 memoryclaims, THRgettid(), GDKmemavail(), argclaim);
 			stk->workers++;
 			MT_lock_unset(&admissionLock);
 			return 0;
 		}
 		PARDEBUG
-			fprintf(stderr, "#Delayed due to lack of memory " LLFMT " requested " LLFMT " memoryclaims %d\n", 
-				memorypool, argclaim, memoryclaims);
+			fprintf(stderr, "#Delayed due to lack of memory %zu requested " LLFMT " memoryclaims %d\n", 
+				GDKmemavail(), argclaim, memoryclaims);
 		MT_lock_unset(&admissionLock);
 		return -1;
 	}
@@ -187,13 +184,13 @@ MALadmission(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, lng argcla
 		stk->memory -= argclaim;
 	}
 	/* release memory claimed before */
-	memorypool -= argclaim;
+	GDKmemrelease((size_t) -argclaim);
 	memoryclaims--;
 	stk->workers--;
 
 	PARDEBUG
-		fprintf(stderr, "#DFLOWadmit %3d thread %d pool " LLFMT " claims " LLFMT "\n",
-				 memoryclaims, THRgettid(), memorypool, argclaim);
+		fprintf(stderr, "#DFLOWadmit %3d thread %d avail %zu claims " LLFMT "\n",
+				 memoryclaims, THRgettid(), GDKmemavail(), argclaim);
 	MT_lock_unset(&admissionLock);
 	return 0;
 }
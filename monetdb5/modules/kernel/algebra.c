@@ -320,6 +320,61 @@ ALGselect2nil(bat *result, const bat *bid, const bat *sid, const void *low, cons
 	return MAL_SUCCEED;
 }
 
+/* selection on a predicate that was fused by the fuse optimizer: the
+ * first argument is the candidate list (or nil), the second the
+ * predicate in postfix notation, the remaining arguments are the
+ * operands of the predicate */
+str
+ALGmaskselect(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *result = getArgReference_bat(stk, pci, 0);
+	bat sid = *getArgReference_bat(stk, pci, 1);
+	const char *expr = *getArgReference_str(stk, pci, 2);
+	int nargs = pci->argc - 3;
+	BAT **b, *s = NULL, *bn;
+	ValRecord *v;
+	int i;
+	bool missing;
+
+	(void) cntxt;
+
+	if (!is_bat_nil(sid) && (s = BATdescriptor(sid)) == NULL)
+		throw(MAL, "algebra.maskselect", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	b = GDKzalloc(nargs * sizeof(BAT *));
+	v = GDKzalloc(nargs * sizeof(ValRecord));
+	if (b == NULL || v == NULL) {
+		GDKfree(b);
+		GDKfree(v);
+		if (s)
+			BBPunfix(s->batCacheid);
+		throw(MAL, "algebra.maskselect", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < nargs; i++) {
+		if (isaBatType(getArgType(mb, pci, i + 3))) {
+			if ((b[i] = BATdescriptor(*getArgReference_bat(stk, pci, i + 3))) == NULL)
+				break;
+		} else {
+			v[i] = stk->stk[getArg(pci, i + 3)];
+		}
+	}
+	missing = i < nargs;
+	bn = missing ? NULL : BATmaskselect(expr, nargs, b, v, s);
+	while (--i >= 0)
+		if (b[i])
+			BBPunfix(b[i]->batCacheid);
+	if (s)
+		BBPunfix(s->batCacheid);
+	GDKfree(b);
+	GDKfree(v);
+	if (missing)
+		throw(MAL, "algebra.maskselect", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if (bn == NULL)
+		throw(MAL, "algebra.maskselect", GDK_EXCEPTION);
+	*result = bn->batCacheid;
+	BBPkeepref(bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
 str
 ALGselect1(bat *result, const bat *bid, const void *low, const void *high, const bit *li, const bit *hi, const bit *anti)
 {
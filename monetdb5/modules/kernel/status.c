@@ -218,6 +218,14 @@ SYSmemStatistics(bat *ret, bat *ret2)
 	if (BUNappend(bn, "memincr", false) != GDK_SUCCEED ||
 		BUNappend(b, &i, false) != GDK_SUCCEED)
 		goto bailout;
+	i = (lng) GDKpool_cursize();
+	if (BUNappend(bn, "heappool", false) != GDK_SUCCEED ||
+		BUNappend(b, &i, false) != GDK_SUCCEED)
+		goto bailout;
+	i = (lng) GDKhuge_cursize();
+	if (BUNappend(bn, "hugepages", false) != GDK_SUCCEED ||
+		BUNappend(b, &i, false) != GDK_SUCCEED)
+		goto bailout;
 	if (pseudo(ret,ret2,bn,b))
 		goto bailout;
 	return MAL_SUCCEED;
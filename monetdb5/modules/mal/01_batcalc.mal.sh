@@ -705,3 +705,26 @@ address CMDifthen
 comment "If-then-else operation to assemble a conditional result";
 
 EOF
+
+cat <<EOF
+pattern fuse(e:str, a:any...) :bat[:any]
+address CMDbatFUSE
+comment "Evaluate a fused chain of arithmetic operations over the operands A in a single pass; the expression E is in postfix notation and refers to the operands by number";
+
+pattern maskifthenelse(b1:bat[:any_1], b2:bat[:any_1], e:str, a:any...) :bat[:any_1]
+address CMDbatMASKIFTHEN
+comment "If-then-else operation on a fused predicate: the predicate E is in postfix notation and refers to the operands A by number";
+
+pattern maskifthenelse(v1:any_1, b2:bat[:any_1], e:str, a:any...) :bat[:any_1]
+address CMDbatMASKIFTHEN
+comment "If-then-else operation on a fused predicate: the predicate E is in postfix notation and refers to the operands A by number";
+
+pattern maskifthenelse(b1:bat[:any_1], v2:any_1, e:str, a:any...) :bat[:any_1]
+address CMDbatMASKIFTHEN
+comment "If-then-else operation on a fused predicate: the predicate E is in postfix notation and refers to the operands A by number";
+
+pattern maskifthenelse(v1:any_1, v2:any_1, e:str, a:any...) :bat[:any_1]
+address CMDbatMASKIFTHEN
+comment "If-then-else operation on a fused predicate: the predicate E is in postfix notation and refers to the operands A by number";
+
+EOF
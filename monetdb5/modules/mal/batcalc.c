@@ -698,6 +698,143 @@ CMDbatMODsignal(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 						 calcmodtype, 1, "batcalc.%");
 }
 
+/* collect the operands of a fused expression, which start at argument
+ * first: b[i] is the BAT, or NULL in which case v[i] is the value */
+static str
+fuseoperands(MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, int first,
+			 BAT ***bp, ValRecord **vp, const char *func)
+{
+	int nargs = pci->argc - first;
+	BAT **b;
+	ValRecord *v;
+	int i;
+
+	b = GDKzalloc(nargs * sizeof(BAT *));
+	v = GDKzalloc(nargs * sizeof(ValRecord));
+	if (b == NULL || v == NULL) {
+		GDKfree(b);
+		GDKfree(v);
+		throw(MAL, func, SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < nargs; i++) {
+		if (isaBatType(getArgType(mb, pci, i + first))) {
+			bat *bid = getArgReference_bat(stk, pci, i + first);
+			if ((b[i] = BATdescriptor(*bid)) == NULL)
+				break;
+		} else {
+			v[i] = stk->stk[getArg(pci, i + first)];
+		}
+	}
+	if (i < nargs) {
+		while (--i >= 0)
+			if (b[i])
+				BBPunfix(b[i]->batCacheid);
+		GDKfree(b);
+		GDKfree(v);
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	*bp = b;
+	*vp = v;
+	return MAL_SUCCEED;
+}
+
+static void
+fusefree(BAT **b, ValRecord *v, int nargs)
+{
+	for (int i = 0; i < nargs; i++)
+		if (b[i])
+			BBPunfix(b[i]->batCacheid);
+	GDKfree(b);
+	GDKfree(v);
+}
+
+mal_export str CMDbatFUSE(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+
+/* evaluate a chain of arithmetic operations that was fused by the
+ * fuse optimizer: the first argument is the expression in postfix
+ * notation, the remaining arguments are the operands */
+str
+CMDbatFUSE(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	const char *expr = *getArgReference_str(stk, pci, 1);
+	int nargs = pci->argc - 2;
+	int tp = getBatType(getArgType(mb, pci, 0));
+	BAT **b, *bn;
+	ValRecord *v;
+	bat *bid;
+	int i;
+	str msg;
+
+	(void) cntxt;
+
+	if ((msg = fuseoperands(mb, stk, pci, 2, &b, &v, "batcalc.fuse")) != MAL_SUCCEED)
+		return msg;
+	if (tp == TYPE_any) {
+		/* result type not resolved: use that of the operands */
+		for (i = 0; i < nargs; i++)
+			if (b[i]) {
+				tp = b[i]->ttype;
+				break;
+			}
+	}
+	bn = BATcalcfused(expr, nargs, b, v, tp, true);
+	fusefree(b, v, nargs);
+	if (bn == NULL)
+		return mythrow(MAL, "batcalc.fuse", OPERATION_FAILED);
+	bid = getArgReference_bat(stk, pci, 0);
+	BBPkeepref(*bid = bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
+mal_export str CMDbatMASKIFTHEN(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+
+/* if-then-else on a predicate that was fused by the fuse optimizer:
+ * the first two arguments are the "then" and "else" values, the third
+ * the predicate in postfix notation, the remaining arguments are the
+ * operands of the predicate */
+str
+CMDbatMASKIFTHEN(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	const char *expr = *getArgReference_str(stk, pci, 3);
+	int nargs = pci->argc - 4;
+	BAT **b, *b1 = NULL, *b2 = NULL, *bn;
+	ValRecord *v;
+	bat *bid;
+	str msg;
+
+	(void) cntxt;
+
+	if (isaBatType(getArgType(mb, pci, 1)) &&
+		(b1 = BATdescriptor(*getArgReference_bat(stk, pci, 1))) == NULL)
+		throw(MAL, "batcalc.maskifthenelse", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if (isaBatType(getArgType(mb, pci, 2)) &&
+		(b2 = BATdescriptor(*getArgReference_bat(stk, pci, 2))) == NULL) {
+		if (b1)
+			BBPunfix(b1->batCacheid);
+		throw(MAL, "batcalc.maskifthenelse", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if ((msg = fuseoperands(mb, stk, pci, 4, &b, &v, "batcalc.maskifthenelse")) != MAL_SUCCEED) {
+		if (b1)
+			BBPunfix(b1->batCacheid);
+		if (b2)
+			BBPunfix(b2->batCacheid);
+		return msg;
+	}
+	bn = BATmaskifthenelse(expr, nargs, b, v,
+						   b1, &stk->stk[getArg(pci, 1)],
+						   b2, &stk->stk[getArg(pci, 2)]);
+	fusefree(b, v, nargs);
+	if (b1)
+		BBPunfix(b1->batCacheid);
+	if (b2)
+		BBPunfix(b2->batCacheid);
+	if (bn == NULL)
+		return mythrow(MAL, "batcalc.maskifthenelse", OPERATION_FAILED);
+	bid = getArgReference_bat(stk, pci, 0);
+	BBPkeepref(*bid = bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
 mal_export str CMDbatXOR(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 
 str
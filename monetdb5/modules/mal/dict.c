@@ -0,0 +1,505 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * Dictionary encoded columns
+ *
+ * A column with few distinct values is represented by a sorted
+ * dictionary u of its distinct values and a column o of small integer
+ * codes (bte, sht or int, depending on the size of the dictionary)
+ * that index into u.  Because u is sorted, the order of the codes is
+ * the order of the values, so that selects and joins can be done on
+ * the codes, and grouping can be done directly on o with group.group.
+ * The values themselves are only needed when the result is exported,
+ * at which point dict.decompress maps the codes back.
+ *
+ *	(o, u) := dict.compress(b);
+ *	c := dict.thetaselect(o, s, u, val, op);
+ *	c := dict.select(o, s, u, low, high, li, hi, anti);
+ *	(l, r) := dict.join(lo, lu, ro, ru, sl, sr, nil_matches, estimate);
+ *	b := dict.decompress(o, u);
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "dict.h"
+
+/* the type of the codes for a dictionary with cnt entries */
+static int
+DICTcodetype(BUN cnt)
+{
+	if (cnt <= (BUN) GDK_bte_max + 1)
+		return TYPE_bte;
+	if (cnt <= (BUN) GDK_sht_max + 1)
+		return TYPE_sht;
+	if (cnt <= (BUN) GDK_int_max + 1)
+		return TYPE_int;
+	return TYPE_void;
+}
+
+static inline BUN
+DICTcode(const void *codes, int tpe, BUN p)
+{
+	switch (tpe) {
+	case TYPE_bte:
+		return (BUN) ((const bte *) codes)[p];
+	case TYPE_sht:
+		return (BUN) ((const sht *) codes)[p];
+	default:
+		return (BUN) ((const int *) codes)[p];
+	}
+}
+
+static bool
+DICTiscodes(BAT *o)
+{
+	return o->ttype == TYPE_bte || o->ttype == TYPE_sht || o->ttype == TYPE_int;
+}
+
+#define DICTencode(TYPE)						\
+	do {								\
+		TYPE *restrict op = (TYPE *) Tloc(o, 0);		\
+		for (i = 0; i < cnt; i++)				\
+			op[i] = (TYPE) rank[gids ? gids[i] : g->tseqbase + i]; \
+	} while (0)
+
+str
+DICTcompress(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *ores = getArgReference_bat(stk, pci, 0);
+	bat *ures = getArgReference_bat(stk, pci, 1);
+	bat bid = *getArgReference_bat(stk, pci, 2);
+	BAT *b, *g = NULL, *e = NULL, *u = NULL, *us = NULL, *ord = NULL;
+	BAT *o = NULL, *d = NULL;
+	oid *rank = NULL;
+	const oid *gids;
+	BUN i, ngrp, cnt;
+	BATiter ui;
+	int tpe;
+
+	(void) cntxt;
+	(void) mb;
+	if ((b = BATdescriptor(bid)) == NULL)
+		throw(MAL, "dict.compress", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	cnt = BATcount(b);
+	if (BATgroup(&g, &e, NULL, b, NULL, NULL, NULL, NULL) != GDK_SUCCEED)
+		goto bailout;
+	ngrp = BATcount(e);
+	if ((tpe = DICTcodetype(ngrp)) == TYPE_void) {
+		BBPunfix(b->batCacheid);
+		BBPunfix(g->batCacheid);
+		BBPunfix(e->batCacheid);
+		throw(MAL, "dict.compress", SQLSTATE(42000) "Too many distinct values for a dictionary");
+	}
+	if ((u = BATproject(e, b)) == NULL ||
+	    BATsort(&us, &ord, NULL, u, NULL, NULL, false, false, false) != GDK_SUCCEED)
+		goto bailout;
+
+	/* the dictionary gets its own compact heap, it should not
+	 * share the (possibly much larger) vheap of b */
+	if ((d = COLnew(0, b->ttype, ngrp, TRANSIENT)) == NULL)
+		goto bailout;
+	ui = bat_iterator(us);
+	for (i = 0; i < ngrp; i++)
+		if (BUNappend(d, BUNtail(ui, i), false) != GDK_SUCCEED)
+			goto bailout;
+	d->tsorted = true;
+	d->trevsorted = ngrp <= 1;
+	d->tkey = true;
+
+	/* rank[g] is the code of group g, i.e. the position of its
+	 * value in the dictionary */
+	if ((rank = GDKmalloc(ngrp * sizeof(oid))) == NULL)
+		goto bailout;
+	for (i = 0; i < ngrp; i++)
+		rank[BUNtoid(ord, i) - u->hseqbase] = (oid) i;
+
+	if ((o = COLnew(b->hseqbase, tpe, cnt, TRANSIENT)) == NULL)
+		goto bailout;
+	gids = g->ttype == TYPE_void ? NULL : (const oid *) Tloc(g, 0);
+	switch (tpe) {
+	case TYPE_bte:
+		DICTencode(bte);
+		break;
+	case TYPE_sht:
+		DICTencode(sht);
+		break;
+	default:
+		DICTencode(int);
+		break;
+	}
+	BATsetcount(o, cnt);
+	/* the encoding preserves the order */
+	o->tsorted = b->tsorted;
+	o->trevsorted = b->trevsorted;
+	o->tkey = b->tkey;
+	o->tnil = false;
+	o->tnonil = true;
+
+	GDKfree(rank);
+	BBPunfix(b->batCacheid);
+	BBPunfix(g->batCacheid);
+	BBPunfix(e->batCacheid);
+	BBPunfix(u->batCacheid);
+	BBPunfix(us->batCacheid);
+	BBPunfix(ord->batCacheid);
+	BBPkeepref(*ores = o->batCacheid);
+	BBPkeepref(*ures = d->batCacheid);
+	return MAL_SUCCEED;
+
+  bailout:
+	GDKfree(rank);
+	BBPunfix(b->batCacheid);
+	BBPreclaim(g);
+	BBPreclaim(e);
+	BBPreclaim(u);
+	BBPreclaim(us);
+	BBPreclaim(ord);
+	BBPreclaim(d);
+	BBPreclaim(o);
+	throw(MAL, "dict.compress", GDK_EXCEPTION);
+}
+
+str
+DICTdecompress(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	bat oid_ = *getArgReference_bat(stk, pci, 1);
+	bat uid = *getArgReference_bat(stk, pci, 2);
+	BAT *o, *u, *c, *bn;
+	const void *codes;
+	oid *restrict op;
+	BUN i, cnt;
+
+	(void) cntxt;
+	(void) mb;
+	if ((o = BATdescriptor(oid_)) == NULL)
+		throw(MAL, "dict.decompress", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((u = BATdescriptor(uid)) == NULL) {
+		BBPunfix(o->batCacheid);
+		throw(MAL, "dict.decompress", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if (!DICTiscodes(o)) {
+		BBPunfix(o->batCacheid);
+		BBPunfix(u->batCacheid);
+		throw(MAL, "dict.decompress", SEMANTIC_TYPE_MISMATCH);
+	}
+	cnt = BATcount(o);
+	if ((c = COLnew(o->hseqbase, TYPE_oid, cnt, TRANSIENT)) == NULL) {
+		BBPunfix(o->batCacheid);
+		BBPunfix(u->batCacheid);
+		throw(MAL, "dict.decompress", GDK_EXCEPTION);
+	}
+	codes = Tloc(o, 0);
+	op = (oid *) Tloc(c, 0);
+	for (i = 0; i < cnt; i++)
+		op[i] = u->hseqbase + DICTcode(codes, o->ttype, i);
+	BATsetcount(c, cnt);
+	c->tsorted = o->tsorted;
+	c->trevsorted = o->trevsorted;
+	c->tkey = o->tkey;
+	c->tnil = false;
+	c->tnonil = true;
+	bn = BATproject(c, u);
+	BBPunfix(c->batCacheid);
+	BBPunfix(o->batCacheid);
+	BBPunfix(u->batCacheid);
+	if (bn == NULL)
+		throw(MAL, "dict.decompress", GDK_EXCEPTION);
+	BBPkeepref(*res = bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
+#define DICTscan(TYPE)							\
+	do {								\
+		const TYPE *restrict codes = (const TYPE *) Tloc(o, 0);	\
+		oid x;							\
+		BUN n;							\
+		while ((n = canditer_next_run(&ci, &x, ci.ncand)) > 0) { \
+			for (oid e = x + n; x < e; x++) {		\
+				dst[cnt] = x;				\
+				cnt += tab[codes[x - o->hseqbase]];	\
+			}						\
+		}							\
+	} while (0)
+
+/* Return the rows of o (restricted to the candidates in s) whose code
+ * occurs in r, the result of a select on the dictionary u. */
+static BAT *
+DICTselectcodes(BAT *o, BAT *s, BAT *u, BAT *r)
+{
+	BUN n = BATcount(r), cnt = 0;
+	oid first, last;
+	struct canditer ci;
+	bte *tab;
+	oid *restrict dst;
+	BAT *bn;
+
+	if (n == 0)
+		return BATdense(0, 0, 0);
+	first = BUNtoid(r, 0) - u->hseqbase;
+	last = BUNtoid(r, n - 1) - u->hseqbase;
+	if (last - first + 1 == n) {
+		/* a contiguous range of codes: a range select on the
+		 * codes can use everything BATselect has to offer */
+		union {
+			bte b;
+			sht s;
+			int i;
+		} lo, hi;
+
+		switch (o->ttype) {
+		case TYPE_bte:
+			lo.b = (bte) first;
+			hi.b = (bte) last;
+			break;
+		case TYPE_sht:
+			lo.s = (sht) first;
+			hi.s = (sht) last;
+			break;
+		default:
+			lo.i = (int) first;
+			hi.i = (int) last;
+			break;
+		}
+		return BATselect(o, s, &lo, &hi, true, true, false);
+	}
+
+	/* otherwise scan the codes using a lookup table */
+	if ((tab = GDKzalloc(BATcount(u))) == NULL)
+		return NULL;
+	for (BUN i = 0; i < n; i++)
+		tab[BUNtoid(r, i) - u->hseqbase] = 1;
+	canditer_init(&ci, o, s);
+	if ((bn = COLnew(0, TYPE_oid, ci.ncand, TRANSIENT)) == NULL) {
+		GDKfree(tab);
+		return NULL;
+	}
+	dst = (oid *) Tloc(bn, 0);
+	switch (o->ttype) {
+	case TYPE_bte:
+		DICTscan(bte);
+		break;
+	case TYPE_sht:
+		DICTscan(sht);
+		break;
+	default:
+		DICTscan(int);
+		break;
+	}
+	GDKfree(tab);
+	BATsetcount(bn, cnt);
+	bn->tsorted = true;
+	bn->trevsorted = cnt <= 1;
+	bn->tkey = true;
+	bn->tnil = false;
+	bn->tnonil = true;
+	bn->tseqbase = cnt == 0 ? 0 : cnt == 1 ? dst[0] : oid_nil;
+	return bn;
+}
+
+static str
+DICTselectdone(bat *res, BAT *o, BAT *s, BAT *u, BAT *r, const char *func)
+{
+	BAT *bn = NULL;
+
+	if (r != NULL) {
+		bn = DICTselectcodes(o, s, u, r);
+		BBPunfix(r->batCacheid);
+	}
+	BBPunfix(o->batCacheid);
+	BBPunfix(u->batCacheid);
+	if (s)
+		BBPunfix(s->batCacheid);
+	if (bn == NULL)
+		throw(MAL, func, GDK_EXCEPTION);
+	BBPkeepref(*res = bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
+static str
+DICTselectargs(MalStkPtr stk, InstrPtr pci, BAT **o, BAT **s, BAT **u, const char *func)
+{
+	bat oid_ = *getArgReference_bat(stk, pci, 1);
+	bat sid = *getArgReference_bat(stk, pci, 2);
+	bat uid = *getArgReference_bat(stk, pci, 3);
+
+	*s = NULL;
+	if ((*o = BATdescriptor(oid_)) == NULL)
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((*u = BATdescriptor(uid)) == NULL) {
+		BBPunfix((*o)->batCacheid);
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if (!is_bat_nil(sid) && (*s = BATdescriptor(sid)) == NULL) {
+		BBPunfix((*o)->batCacheid);
+		BBPunfix((*u)->batCacheid);
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if (!DICTiscodes(*o)) {
+		BBPunfix((*o)->batCacheid);
+		BBPunfix((*u)->batCacheid);
+		if (*s)
+			BBPunfix((*s)->batCacheid);
+		throw(MAL, func, SEMANTIC_TYPE_MISMATCH);
+	}
+	return MAL_SUCCEED;
+}
+
+str
+DICTthetaselect(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	const void *val = VALptr(&stk->stk[getArg(pci, 4)]);
+	const char *op = *getArgReference_str(stk, pci, 5);
+	BAT *o, *s, *u;
+	str msg;
+
+	(void) cntxt;
+	(void) mb;
+	if ((msg = DICTselectargs(stk, pci, &o, &s, &u, "dict.thetaselect")) != MAL_SUCCEED)
+		return msg;
+	return DICTselectdone(res, o, s, u, BATthetaselect(u, NULL, val, op),
+			      "dict.thetaselect");
+}
+
+str
+DICTselect(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	const void *low = VALptr(&stk->stk[getArg(pci, 4)]);
+	const void *high = VALptr(&stk->stk[getArg(pci, 5)]);
+	bit li = *getArgReference_bit(stk, pci, 6);
+	bit hi = *getArgReference_bit(stk, pci, 7);
+	bit anti = *getArgReference_bit(stk, pci, 8);
+	const void *nil;
+	BAT *o, *s, *u;
+	str msg;
+
+	(void) cntxt;
+	(void) mb;
+	if ((msg = DICTselectargs(stk, pci, &o, &s, &u, "dict.select")) != MAL_SUCCEED)
+		return msg;
+	nil = ATOMnilptr(u->ttype);
+	if (li && hi &&
+	    ATOMcmp(u->ttype, low, nil) == 0 &&
+	    ATOMcmp(u->ttype, high, nil) == 0) {
+		/* special case: equi-select for NIL */
+		high = NULL;
+	}
+	return DICTselectdone(res, o, s, u,
+			      BATselect(u, NULL, low, high, li, hi, anti),
+			      "dict.select");
+}
+
+#define DICTtranslate(TYPE)						\
+	do {								\
+		TYPE *restrict map, *restrict tp;			\
+		if ((map = GDKmalloc(BATcount(lu) * sizeof(TYPE))) == NULL) \
+			goto bailout;					\
+		for (i = 0; i < BATcount(lu); i++)			\
+			map[i] = TYPE##_nil;				\
+		for (i = 0; i < BATcount(m1); i++)			\
+			map[BUNtoid(m1, i) - lu->hseqbase] = (TYPE) (BUNtoid(m2, i) - ru->hseqbase); \
+		tp = (TYPE *) Tloc(lt, 0);				\
+		for (i = 0; i < cnt; i++) {				\
+			tp[i] = map[DICTcode(codes, lo->ttype, i)];	\
+			nils |= is_##TYPE##_nil(tp[i]);			\
+		}							\
+		GDKfree(map);						\
+	} while (0)
+
+str
+DICTjoin(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *r1 = getArgReference_bat(stk, pci, 0);
+	bat *r2 = getArgReference_bat(stk, pci, 1);
+	bat loid = *getArgReference_bat(stk, pci, 2);
+	bat luid = *getArgReference_bat(stk, pci, 3);
+	bat roid = *getArgReference_bat(stk, pci, 4);
+	bat ruid = *getArgReference_bat(stk, pci, 5);
+	bat slid = *getArgReference_bat(stk, pci, 6);
+	bat srid = *getArgReference_bat(stk, pci, 7);
+	bit nil_matches = *getArgReference_bit(stk, pci, 8);
+	lng estimate = *getArgReference_lng(stk, pci, 9);
+	BAT *lo = NULL, *lu = NULL, *ro = NULL, *ru = NULL, *sl = NULL, *sr = NULL;
+	BAT *m1 = NULL, *m2 = NULL, *lt = NULL, *j1 = NULL, *j2 = NULL;
+	const void *codes;
+	bool nils = false;
+	BUN i, cnt;
+	str msg = MAL_SUCCEED;
+
+	(void) cntxt;
+	(void) mb;
+	if ((lo = BATdescriptor(loid)) == NULL ||
+	    (lu = BATdescriptor(luid)) == NULL ||
+	    (ro = BATdescriptor(roid)) == NULL ||
+	    (ru = BATdescriptor(ruid)) == NULL ||
+	    (!is_bat_nil(slid) && (sl = BATdescriptor(slid)) == NULL) ||
+	    (!is_bat_nil(srid) && (sr = BATdescriptor(srid)) == NULL)) {
+		msg = createException(MAL, "dict.join", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+		goto bailout;
+	}
+	if (!DICTiscodes(lo) || !DICTiscodes(ro) ||
+	    ATOMtype(lu->ttype) != ATOMtype(ru->ttype)) {
+		msg = createException(MAL, "dict.join", SEMANTIC_TYPE_MISMATCH);
+		goto bailout;
+	}
+
+	/* join the (small) dictionaries and translate the codes of
+	 * the left side to the codes of the right side; codes that
+	 * have no counterpart become nil, and since codes are never
+	 * nil, those do not match anything */
+	if (BATjoin(&m1, &m2, lu, ru, NULL, NULL, nil_matches, BUN_NONE) != GDK_SUCCEED)
+		goto bailout;
+	cnt = BATcount(lo);
+	if ((lt = COLnew(lo->hseqbase, ro->ttype, cnt, TRANSIENT)) == NULL)
+		goto bailout;
+	codes = Tloc(lo, 0);
+	switch (ro->ttype) {
+	case TYPE_bte:
+		DICTtranslate(bte);
+		break;
+	case TYPE_sht:
+		DICTtranslate(sht);
+		break;
+	default:
+		DICTtranslate(int);
+		break;
+	}
+	BATsetcount(lt, cnt);
+	lt->tsorted = lt->trevsorted = lt->tkey = false;
+	lt->tnil = nils;
+	lt->tnonil = !nils;
+
+	if (BATjoin(&j1, &j2, lt, ro, sl, sr, false,
+		    is_lng_nil(estimate) || estimate <= 0 || estimate > (lng) BUN_MAX ? BUN_NONE : (BUN) estimate) != GDK_SUCCEED)
+		goto bailout;
+	BBPkeepref(*r1 = j1->batCacheid);
+	BBPkeepref(*r2 = j2->batCacheid);
+
+  bailout:
+	if (msg == MAL_SUCCEED && j1 == NULL)
+		msg = createException(MAL, "dict.join", GDK_EXCEPTION);
+	BBPreclaim(m1);
+	BBPreclaim(m2);
+	BBPreclaim(lt);
+	if (lo)
+		BBPunfix(lo->batCacheid);
+	if (lu)
+		BBPunfix(lu->batCacheid);
+	if (ro)
+		BBPunfix(ro->batCacheid);
+	if (ru)
+		BBPunfix(ru->batCacheid);
+	if (sl)
+		BBPunfix(sl->batCacheid);
+	if (sr)
+		BBPunfix(sr->batCacheid);
+	return msg;
+}
@@ -0,0 +1,1067 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * Lightweight compression of integer columns
+ *
+ * A column of an integer type (or a type stored as one, such as date
+ * or timestamp) is cut into blocks of LWC_BLOCKSIZE values, and each
+ * block is compressed on its own with whichever of the following
+ * schemes gives the smallest result:
+ *
+ * - frame of reference: the values are stored as bit-packed offsets
+ *   from the smallest value in the block, using as few bits as the
+ *   range of the block needs;
+ * - delta: for ascending blocks without nils, the bit-packed
+ *   differences between consecutive values are stored;
+ * - run length: the bit-packed offsets (as in frame of reference) of
+ *   the runs of equal values are stored together with the positions
+ *   where the runs end.
+ *
+ * Every block starts with a header that records the scheme, the bit
+ * width and the smallest and largest value in the block, so that the
+ * header doubles as a zone map.  The compressed column is a bte BAT
+ * holding the byte stream.
+ *
+ * Selects skip blocks using the zone map and compare the packed
+ * offsets (frame of reference) or the runs (run length) without
+ * decompressing the values; sum, min and max work on the block
+ * headers and packed offsets.  Everything else should decompress.
+ *
+ *	c := lwc.compress(b);
+ *	s := lwc.thetaselect(c, s, val, op);
+ *	s := lwc.select(c, s, low, high, li, hi, anti);
+ *	v := lwc.sum(c, nil:tpe);
+ *	v := lwc.min(c, nil:tpe);
+ *	v := lwc.max(c, nil:tpe);
+ *	b := lwc.decompress(c, nil:tpe);
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "lwc.h"
+
+#define LWC_MAGIC	0x3143574C /* "LWC1" */
+#define LWC_BLOCKSIZE	1024	   /* must fit in the uint16_t run ends */
+
+/* compression schemes of a block */
+#define LWC_FOR		1
+#define LWC_DELTA	2
+#define LWC_RLE		3
+
+/* properties of the original column */
+#define LWC_SORTED	1
+#define LWC_REVSORTED	2
+#define LWC_KEY		4
+#define LWC_NIL		8
+#define LWC_NONIL	16
+
+struct lwcheader {
+	uint32_t magic;
+	uint8_t width;		/* size of the values in bytes */
+	uint8_t props;		/* LWC_SORTED, etc. */
+	uint16_t unused;
+	uint64_t count;		/* number of values */
+	uint64_t hseqbase;	/* hseqbase of the original column */
+};
+
+/* followed by size bytes of payload, size is a multiple of 8; the
+ * values are bit-packed in 64-bit words:
+ * LWC_FOR: n offsets from min, a nil is stored as max - min + 1;
+ * LWC_DELTA: n - 1 differences between consecutive values, the first
+ *	value is min;
+ * LWC_RLE: nruns uint16_t positions where the runs end, padded to a
+ *	multiple of 8 bytes, followed by nruns offsets as in LWC_FOR
+ * A block that only contains nils has min == max == lng_nil and no
+ * payload. */
+struct lwcblock {
+	uint8_t scheme;		/* LWC_FOR, LWC_DELTA or LWC_RLE */
+	uint8_t bits;		/* bits per packed value */
+	uint8_t hasnil;		/* whether the block contains nils */
+	uint8_t unused;
+	uint32_t n;		/* number of values */
+	uint32_t nruns;		/* LWC_RLE: number of runs */
+	uint32_t size;		/* size of the payload in bytes */
+	lng min, max;		/* smallest and largest non-nil value */
+};
+
+/* result of matching a block with a predicate */
+#define LWC_NONE	0
+#define LWC_SOME	1
+#define LWC_ALL		2
+
+/* inclusive bounds of the non-nil values to select; if anti is set,
+ * the values outside the bounds are selected; if nil is set, only
+ * nils are selected */
+struct lwcpred {
+	lng lo, hi;
+	bool anti;
+	bool nil;
+	bool none;		/* nothing qualifies */
+};
+
+/* the size of the values of type tpe, or 0 if we cannot compress
+ * them */
+static int
+lwcwidth(int tpe)
+{
+	switch (ATOMstorage(tpe)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+		return ATOMsize(ATOMstorage(tpe));
+	default:
+		return 0;
+	}
+}
+
+static inline int
+lwcbits(uint64_t v)
+{
+	int bits = 0;
+
+	while (v != 0) {
+		bits++;
+		v >>= 1;
+	}
+	return bits;
+}
+
+/* bytes needed for n packed values of the given width */
+static inline size_t
+lwcpacked(size_t n, int bits)
+{
+	return (n * bits + 63) / 64 * sizeof(uint64_t);
+}
+
+static inline size_t
+lwcrunends(size_t nruns)
+{
+	return (nruns * sizeof(uint16_t) + 7) & ~(size_t) 7;
+}
+
+static inline void
+lwcpack(uint64_t *restrict w, size_t i, int bits, uint64_t v)
+{
+	size_t pos = i * bits;
+	unsigned off = (unsigned) (pos & 63);
+
+	w[pos >> 6] |= v << off;
+	if (off + bits > 64)
+		w[(pos >> 6) + 1] |= v >> (64 - off);
+}
+
+static inline uint64_t
+lwcunpack(const uint64_t *restrict w, size_t i, int bits)
+{
+	size_t pos = i * bits;
+	unsigned off = (unsigned) (pos & 63);
+	uint64_t v;
+
+	if (bits == 0)
+		return 0;
+	v = w[pos >> 6] >> off;
+	if (off + bits > 64)
+		v |= w[(pos >> 6) + 1] << (64 - off);
+	return bits == 64 ? v : v & (((uint64_t) 1 << bits) - 1);
+}
+
+static inline lng
+lwcvalue(const void *p, int width)
+{
+	switch (width) {
+	case 1:
+		return is_bte_nil(*(const bte *) p) ? lng_nil : *(const bte *) p;
+	case 2:
+		return is_sht_nil(*(const sht *) p) ? lng_nil : *(const sht *) p;
+	case 4:
+		return is_int_nil(*(const int *) p) ? lng_nil : *(const int *) p;
+	default:
+		return *(const lng *) p;
+	}
+}
+
+#define LWCload(TYPE)							\
+	do {								\
+		const TYPE *restrict src = (const TYPE *) vals + off;	\
+		for (i = 0; i < n; i++)					\
+			v[i] = is_##TYPE##_nil(src[i]) ? lng_nil : (lng) src[i]; \
+	} while (0)
+
+/* convert n values starting at position off to lng */
+static void
+lwcload(const void *vals, int width, BUN off, uint32_t n, lng *restrict v)
+{
+	uint32_t i;
+
+	switch (width) {
+	case 1:
+		LWCload(bte);
+		break;
+	case 2:
+		LWCload(sht);
+		break;
+	case 4:
+		LWCload(int);
+		break;
+	default:
+		memcpy(v, (const lng *) vals + off, n * sizeof(lng));
+		break;
+	}
+}
+
+#define LWCstore(TYPE)							\
+	do {								\
+		TYPE *restrict dst = (TYPE *) vals + off;		\
+		for (i = 0; i < n; i++)					\
+			dst[i] = is_lng_nil(v[i]) ? TYPE##_nil : (TYPE) v[i]; \
+	} while (0)
+
+/* the inverse of lwcload */
+static void
+lwcstore(void *vals, int width, BUN off, uint32_t n, const lng *restrict v)
+{
+	uint32_t i;
+
+	switch (width) {
+	case 1:
+		LWCstore(bte);
+		break;
+	case 2:
+		LWCstore(sht);
+		break;
+	case 4:
+		LWCstore(int);
+		break;
+	default:
+		memcpy((lng *) vals + off, v, n * sizeof(lng));
+		break;
+	}
+}
+
+/* fill in the header of the block with values v, choosing the
+ * scheme that gives the smallest payload */
+static void
+lwcanalyse(const lng *restrict v, uint32_t n, struct lwcblock *blk)
+{
+	lng min = lng_nil, max = lng_nil;
+	bool hasnil = false, sorted = true;
+	uint32_t i, nruns = 1;
+	uint64_t range, maxdelta = 0;
+	size_t size;
+	int bits;
+
+	for (i = 0; i < n; i++) {
+		if (i > 0 && v[i] != v[i - 1])
+			nruns++;
+		if (is_lng_nil(v[i])) {
+			hasnil = true;
+			sorted = false;
+			continue;
+		}
+		if (is_lng_nil(min)) {
+			min = max = v[i];
+		} else if (v[i] < min) {
+			min = v[i];
+		} else if (v[i] > max) {
+			max = v[i];
+		}
+		if (sorted && i > 0) {
+			if (v[i] < v[i - 1])
+				sorted = false;
+			else if ((uint64_t) v[i] - (uint64_t) v[i - 1] > maxdelta)
+				maxdelta = (uint64_t) v[i] - (uint64_t) v[i - 1];
+		}
+	}
+	*blk = (struct lwcblock) {
+		.scheme = LWC_FOR,
+		.hasnil = hasnil,
+		.n = n,
+		.min = min,
+		.max = max,
+	};
+	if (is_lng_nil(min))
+		return;		/* only nils */
+
+	/* the range of a block is at most 2^64-2, since nil is not
+	 * part of it, so there is room for the nil offset */
+	range = (uint64_t) max - (uint64_t) min;
+	bits = lwcbits(hasnil ? range + 1 : range);
+	blk->bits = (uint8_t) bits;
+	blk->size = (uint32_t) lwcpacked(n, bits);
+
+	size = lwcrunends(nruns) + lwcpacked(nruns, bits);
+	if (size < blk->size) {
+		blk->scheme = LWC_RLE;
+		blk->nruns = nruns;
+		blk->size = (uint32_t) size;
+	}
+	if (sorted && n > 1) {
+		bits = lwcbits(maxdelta);
+		size = lwcpacked(n - 1, bits);
+		if (size < blk->size) {
+			blk->scheme = LWC_DELTA;
+			blk->bits = (uint8_t) bits;
+			blk->nruns = 0;
+			blk->size = (uint32_t) size;
+		}
+	}
+}
+
+static inline uint64_t
+lwcoffset(const struct lwcblock *blk, lng v)
+{
+	if (is_lng_nil(v))
+		return (uint64_t) blk->max - (uint64_t) blk->min + 1;
+	return (uint64_t) v - (uint64_t) blk->min;
+}
+
+static inline lng
+lwcfromoffset(const struct lwcblock *blk, uint64_t c)
+{
+	if (blk->hasnil && c == (uint64_t) blk->max - (uint64_t) blk->min + 1)
+		return lng_nil;
+	return (lng) ((uint64_t) blk->min + c);
+}
+
+/* write the block with header blk and values v to dst, return the
+ * position after the block */
+static char *
+lwcencode(const lng *restrict v, const struct lwcblock *blk, char *dst)
+{
+	uint64_t *w;
+	uint16_t *ends;
+	uint32_t i, r;
+
+	memcpy(dst, blk, sizeof(*blk));
+	dst += sizeof(*blk);
+	memset(dst, 0, blk->size);
+	switch (blk->scheme) {
+	case LWC_FOR:
+		w = (uint64_t *) dst;
+		if (blk->bits > 0)
+			for (i = 0; i < blk->n; i++)
+				lwcpack(w, i, blk->bits, lwcoffset(blk, v[i]));
+		break;
+	case LWC_DELTA:
+		w = (uint64_t *) dst;
+		if (blk->bits > 0)
+			for (i = 1; i < blk->n; i++)
+				lwcpack(w, i - 1, blk->bits, (uint64_t) v[i] - (uint64_t) v[i - 1]);
+		break;
+	case LWC_RLE:
+		ends = (uint16_t *) dst;
+		w = (uint64_t *) (dst + lwcrunends(blk->nruns));
+		for (i = 0, r = 0; i < blk->n; i++) {
+			if (i > 0) {
+				if (v[i] == v[i - 1])
+					continue;
+				ends[r++] = (uint16_t) i;
+			}
+			if (blk->bits > 0)
+				lwcpack(w, r, blk->bits, lwcoffset(blk, v[i]));
+		}
+		ends[r] = (uint16_t) blk->n;
+		assert(r + 1 == blk->nruns);
+		break;
+	}
+	return dst + blk->size;
+}
+
+/* decompress the block blk into v */
+static void
+lwcdecode(const struct lwcblock *blk, lng *restrict v)
+{
+	const char *p = (const char *) (blk + 1);
+	const uint64_t *w;
+	const uint16_t *ends;
+	uint32_t i, r;
+	lng val;
+
+	if (is_lng_nil(blk->min)) {
+		for (i = 0; i < blk->n; i++)
+			v[i] = lng_nil;
+		return;
+	}
+	switch (blk->scheme) {
+	case LWC_FOR:
+		w = (const uint64_t *) p;
+		for (i = 0; i < blk->n; i++)
+			v[i] = lwcfromoffset(blk, lwcunpack(w, i, blk->bits));
+		break;
+	case LWC_DELTA:
+		w = (const uint64_t *) p;
+		v[0] = blk->min;
+		for (i = 1; i < blk->n; i++)
+			v[i] = (lng) ((uint64_t) v[i - 1] + lwcunpack(w, i - 1, blk->bits));
+		break;
+	case LWC_RLE:
+		ends = (const uint16_t *) p;
+		w = (const uint64_t *) (p + lwcrunends(blk->nruns));
+		for (i = 0, r = 0; r < blk->nruns; r++) {
+			val = lwcfromoffset(blk, lwcunpack(w, r, blk->bits));
+			while (i < ends[r])
+				v[i++] = val;
+		}
+		break;
+	}
+}
+
+/* check that c is a compressed column of values of type tpe and
+ * return its header */
+static str
+lwcopen(BAT *c, int tpe, const struct lwcheader **hdrp, const char *func)
+{
+	const struct lwcheader *hdr;
+	const struct lwcblock *blk;
+	const char *p, *end;
+	const uint16_t *ends;
+	uint64_t rows = 0;
+	size_t size;
+	uint32_t r;
+	int width;
+
+	if (c->ttype != TYPE_bte || (width = lwcwidth(tpe)) == 0)
+		throw(MAL, func, SEMANTIC_TYPE_MISMATCH);
+	p = (const char *) Tloc(c, 0);
+	end = p + BATcount(c);
+	hdr = (const struct lwcheader *) p;
+	if (((uintptr_t) p & 7) != 0 ||
+	    BATcount(c) < sizeof(*hdr) ||
+	    hdr->magic != LWC_MAGIC)
+		goto corrupt;
+	if (hdr->width != width)
+		throw(MAL, func, SEMANTIC_TYPE_MISMATCH);
+	for (p += sizeof(*hdr); rows < hdr->count; p += sizeof(*blk) + blk->size) {
+		blk = (const struct lwcblock *) p;
+		if ((size_t) (end - p) < sizeof(*blk) ||
+		    blk->n == 0 || blk->n > LWC_BLOCKSIZE ||
+		    blk->n > hdr->count - rows ||
+		    blk->bits > 64 ||
+		    (size_t) (end - p) - sizeof(*blk) < blk->size)
+			goto corrupt;
+		if (is_lng_nil(blk->min) || is_lng_nil(blk->max)) {
+			if (!is_lng_nil(blk->min) || !is_lng_nil(blk->max) ||
+			    !blk->hasnil || blk->size != 0)
+				goto corrupt;
+			rows += blk->n;
+			continue;
+		}
+		if (blk->min > blk->max)
+			goto corrupt;
+		switch (blk->scheme) {
+		case LWC_FOR:
+			size = lwcpacked(blk->n, blk->bits);
+			break;
+		case LWC_DELTA:
+			if (blk->hasnil)
+				goto corrupt;
+			size = lwcpacked(blk->n - 1, blk->bits);
+			break;
+		case LWC_RLE:
+			if (blk->nruns == 0 || blk->nruns > blk->n)
+				goto corrupt;
+			size = lwcrunends(blk->nruns) + lwcpacked(blk->nruns, blk->bits);
+			if (size != blk->size)
+				goto corrupt;
+			/* the run ends must be in the payload before we
+			 * look at them */
+			ends = (const uint16_t *) (blk + 1);
+			for (r = 0; r < blk->nruns; r++)
+				if (ends[r] <= (r == 0 ? 0 : ends[r - 1]))
+					goto corrupt;
+			if (ends[blk->nruns - 1] != blk->n)
+				goto corrupt;
+			break;
+		default:
+			goto corrupt;
+		}
+		if (size != blk->size)
+			goto corrupt;
+		rows += blk->n;
+	}
+	*hdrp = hdr;
+	return MAL_SUCCEED;
+
+  corrupt:
+	throw(MAL, func, SQLSTATE(42000) "Not a compressed column");
+}
+
+#define lwcfirst(hdr)	((const struct lwcblock *) ((hdr) + 1))
+#define lwcnext(blk)	((const struct lwcblock *) ((const char *) ((blk) + 1) + (blk)->size))
+
+str
+LWCcompress(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	bat bid = *getArgReference_bat(stk, pci, 1);
+	BAT *b, *c = NULL;
+	struct lwcblock *blks = NULL;
+	struct lwcheader *hdr;
+	lng *v = NULL;
+	BUN cnt, nblocks, i;
+	size_t size;
+	char *dst;
+	int width;
+
+	(void) cntxt;
+	(void) mb;
+	if ((b = BATdescriptor(bid)) == NULL)
+		throw(MAL, "lwc.compress", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((width = lwcwidth(b->ttype)) == 0) {
+		BBPunfix(b->batCacheid);
+		throw(MAL, "lwc.compress", SEMANTIC_TYPE_MISMATCH);
+	}
+	cnt = BATcount(b);
+	nblocks = (cnt + LWC_BLOCKSIZE - 1) / LWC_BLOCKSIZE;
+
+	/* first decide on the scheme of each block, so that we know
+	 * the size of the result */
+	if ((blks = GDKmalloc((nblocks + 1) * sizeof(struct lwcblock))) == NULL ||
+	    (v = GDKmalloc(LWC_BLOCKSIZE * sizeof(lng))) == NULL)
+		goto bailout;
+	size = sizeof(struct lwcheader);
+	for (i = 0; i < nblocks; i++) {
+		uint32_t n = (uint32_t) MIN(cnt - i * LWC_BLOCKSIZE, LWC_BLOCKSIZE);
+		lwcload(Tloc(b, 0), width, i * LWC_BLOCKSIZE, n, v);
+		lwcanalyse(v, n, &blks[i]);
+		size += sizeof(struct lwcblock) + blks[i].size;
+	}
+
+	if ((c = COLnew(0, TYPE_bte, (BUN) size, TRANSIENT)) == NULL)
+		goto bailout;
+	hdr = (struct lwcheader *) Tloc(c, 0);
+	*hdr = (struct lwcheader) {
+		.magic = LWC_MAGIC,
+		.width = (uint8_t) width,
+		.props = (b->tsorted ? LWC_SORTED : 0) |
+			 (b->trevsorted ? LWC_REVSORTED : 0) |
+			 (b->tkey ? LWC_KEY : 0) |
+			 (b->tnil ? LWC_NIL : 0) |
+			 (b->tnonil ? LWC_NONIL : 0),
+		.count = cnt,
+		.hseqbase = b->hseqbase,
+	};
+	dst = (char *) (hdr + 1);
+	for (i = 0; i < nblocks; i++) {
+		lwcload(Tloc(b, 0), width, i * LWC_BLOCKSIZE, blks[i].n, v);
+		dst = lwcencode(v, &blks[i], dst);
+	}
+	assert(dst == (char *) Tloc(c, 0) + size);
+	BATsetcount(c, (BUN) size);
+	c->tsorted = c->trevsorted = c->tkey = false;
+	c->tnil = c->tnonil = false;
+
+	GDKfree(blks);
+	GDKfree(v);
+	BBPunfix(b->batCacheid);
+	BBPkeepref(*res = c->batCacheid);
+	return MAL_SUCCEED;
+
+  bailout:
+	GDKfree(blks);
+	GDKfree(v);
+	BBPunfix(b->batCacheid);
+	throw(MAL, "lwc.compress", GDK_EXCEPTION);
+}
+
+str
+LWCdecompress(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	bat cid = *getArgReference_bat(stk, pci, 1);
+	int tpe = getArgType(mb, pci, 2);
+	const struct lwcheader *hdr;
+	const struct lwcblock *blk;
+	BAT *c, *bn;
+	lng *v;
+	BUN row;
+	str msg;
+
+	(void) cntxt;
+	if ((c = BATdescriptor(cid)) == NULL)
+		throw(MAL, "lwc.decompress", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((msg = lwcopen(c, tpe, &hdr, "lwc.decompress")) != MAL_SUCCEED) {
+		BBPunfix(c->batCacheid);
+		return msg;
+	}
+	if ((v = GDKmalloc(LWC_BLOCKSIZE * sizeof(lng))) == NULL ||
+	    (bn = COLnew((oid) hdr->hseqbase, tpe, (BUN) hdr->count, TRANSIENT)) == NULL) {
+		GDKfree(v);
+		BBPunfix(c->batCacheid);
+		throw(MAL, "lwc.decompress", GDK_EXCEPTION);
+	}
+	for (row = 0, blk = lwcfirst(hdr); row < hdr->count; row += blk->n, blk = lwcnext(blk)) {
+		lwcdecode(blk, v);
+		lwcstore(Tloc(bn, 0), hdr->width, row, blk->n, v);
+	}
+	BATsetcount(bn, (BUN) hdr->count);
+	bn->tsorted = (hdr->props & LWC_SORTED) != 0;
+	bn->trevsorted = (hdr->props & LWC_REVSORTED) != 0;
+	bn->tkey = (hdr->props & LWC_KEY) != 0;
+	bn->tnil = (hdr->props & LWC_NIL) != 0;
+	bn->tnonil = (hdr->props & LWC_NONIL) != 0;
+	GDKfree(v);
+	BBPunfix(c->batCacheid);
+	BBPkeepref(*res = bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
+static inline bool
+lwcmatch(const struct lwcpred *p, lng v)
+{
+	if (is_lng_nil(v))
+		return p->nil;
+	if (p->nil)
+		return false;
+	return (v >= p->lo && v <= p->hi) != p->anti;
+}
+
+/* match the values of block blk with the predicate; if only some of
+ * them qualify, mask tells which; v is scratch space */
+static int
+lwcmatchblock(const struct lwcblock *blk, const struct lwcpred *p,
+	      bte *restrict mask, lng *restrict v)
+{
+	const char *pl = (const char *) (blk + 1);
+	const uint64_t *w;
+	const uint16_t *ends;
+	uint64_t range, clo, chi, c;
+	uint32_t i, r;
+
+	/* use the block header as a zone map */
+	if (is_lng_nil(blk->min))
+		return p->nil ? LWC_ALL : LWC_NONE;
+	if (p->nil) {
+		if (!blk->hasnil)
+			return LWC_NONE;
+	} else if (!p->anti) {
+		if (p->hi < blk->min || p->lo > blk->max)
+			return LWC_NONE;
+		if (p->lo <= blk->min && blk->max <= p->hi && !blk->hasnil)
+			return LWC_ALL;
+	} else {
+		if (p->lo <= blk->min && blk->max <= p->hi)
+			return LWC_NONE;
+		if ((p->hi < blk->min || p->lo > blk->max) && !blk->hasnil)
+			return LWC_ALL;
+	}
+
+	switch (blk->scheme) {
+	case LWC_FOR:
+		/* translate the bounds to offsets and compare those */
+		w = (const uint64_t *) pl;
+		range = (uint64_t) blk->max - (uint64_t) blk->min;
+		if (p->nil) {
+			for (i = 0; i < blk->n; i++)
+				mask[i] = lwcunpack(w, i, blk->bits) == range + 1;
+			break;
+		}
+		if (p->hi < blk->min || p->lo > blk->max) {
+			/* empty range of offsets */
+			clo = 1;
+			chi = 0;
+		} else {
+			clo = p->lo <= blk->min ? 0 : (uint64_t) p->lo - (uint64_t) blk->min;
+			chi = p->hi >= blk->max ? range : (uint64_t) p->hi - (uint64_t) blk->min;
+		}
+		if (!p->anti) {
+			for (i = 0; i < blk->n; i++) {
+				c = lwcunpack(w, i, blk->bits);
+				mask[i] = c >= clo && c <= chi;
+			}
+		} else {
+			for (i = 0; i < blk->n; i++) {
+				c = lwcunpack(w, i, blk->bits);
+				mask[i] = c < clo || (c > chi && c <= range);
+			}
+		}
+		break;
+	case LWC_RLE:
+		/* evaluate once per run */
+		ends = (const uint16_t *) pl;
+		w = (const uint64_t *) (pl + lwcrunends(blk->nruns));
+		for (i = 0, r = 0; r < blk->nruns; r++) {
+			bte m = lwcmatch(p, lwcfromoffset(blk, lwcunpack(w, r, blk->bits)));
+			memset(mask + i, m, ends[r] - i);
+			i = ends[r];
+		}
+		break;
+	default:
+		lwcdecode(blk, v);
+		for (i = 0; i < blk->n; i++)
+			mask[i] = lwcmatch(p, v[i]);
+		break;
+	}
+	return LWC_SOME;
+}
+
+/* set up the predicate for BATselect-like arguments, see the
+ * breakdown in gdk_select.c */
+static void
+lwcpredicate(struct lwcpred *p, lng lo, lng hi, bool li, bool hinc, bool anti)
+{
+	bool empty = false;
+
+	*p = (struct lwcpred) {
+		.lo = GDK_lng_min,
+		.hi = GDK_lng_max,
+		.anti = anti,
+	};
+	if (is_lng_nil(lo) && is_lng_nil(hi) && li && hinc) {
+		/* equi-select for nil, anti-select gives all non-nils */
+		if (anti)
+			p->anti = false;
+		else
+			p->nil = true;
+		return;
+	}
+	if (!is_lng_nil(lo)) {
+		if (li)
+			p->lo = lo;
+		else if (lo == GDK_lng_max)
+			empty = true;
+		else
+			p->lo = lo + 1;
+	}
+	if (!is_lng_nil(hi)) {
+		if (hinc)
+			p->hi = hi;
+		else if (hi == GDK_lng_min)
+			empty = true;
+		else
+			p->hi = hi - 1;
+	}
+	if (empty || p->lo > p->hi) {
+		if (anti) {
+			p->lo = GDK_lng_min;
+			p->hi = GDK_lng_max;
+			p->anti = false;
+		} else {
+			p->none = true;
+		}
+	}
+}
+
+static str
+lwcselect(bat *res, bat cid, bat sid, int tpe, const struct lwcpred *p, const char *func)
+{
+	const struct lwcheader *hdr;
+	const struct lwcblock *blk;
+	struct canditer ci;
+	BAT *c, *s = NULL, *bn;
+	bte *mask = NULL;
+	lng *v = NULL;
+	oid *restrict dst;
+	oid x, bstart, bend;
+	BUN row, len, cnt = 0;
+	int m;
+	str msg;
+
+	if ((c = BATdescriptor(cid)) == NULL)
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if (!is_bat_nil(sid) && (s = BATdescriptor(sid)) == NULL) {
+		BBPunfix(c->batCacheid);
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if ((msg = lwcopen(c, tpe, &hdr, func)) != MAL_SUCCEED) {
+		BBPunfix(c->batCacheid);
+		if (s)
+			BBPunfix(s->batCacheid);
+		return msg;
+	}
+	if (s) {
+		canditer_init(&ci, NULL, s);
+		canditer_setidx(&ci, canditer_search(&ci, (oid) hdr->hseqbase, true));
+	} else {
+		ci = (struct canditer) {
+			.tpe = cand_dense,
+			.seq = (oid) hdr->hseqbase,
+			.ncand = (BUN) hdr->count,
+		};
+	}
+	if ((mask = GDKmalloc(LWC_BLOCKSIZE)) == NULL ||
+	    (v = GDKmalloc(LWC_BLOCKSIZE * sizeof(lng))) == NULL ||
+	    (bn = COLnew(0, TYPE_oid, MIN(ci.ncand - ci.next, (BUN) hdr->count), TRANSIENT)) == NULL) {
+		GDKfree(mask);
+		GDKfree(v);
+		BBPunfix(c->batCacheid);
+		if (s)
+			BBPunfix(s->batCacheid);
+		throw(MAL, func, GDK_EXCEPTION);
+	}
+	dst = (oid *) Tloc(bn, 0);
+	for (row = 0, blk = lwcfirst(hdr);
+	     !p->none && row < hdr->count && ci.next < ci.ncand;
+	     row += blk->n, blk = lwcnext(blk)) {
+		bstart = (oid) (hdr->hseqbase + row);
+		bend = bstart + blk->n;
+		if (canditer_peek(&ci) >= bend)
+			continue;
+		m = lwcmatchblock(blk, p, mask, v);
+		if (m == LWC_NONE) {
+			canditer_setidx(&ci, canditer_search(&ci, bend, true));
+			continue;
+		}
+		while ((x = canditer_peek(&ci)) < bend) {
+			len = canditer_next_run(&ci, &x, bend - x);
+			if (m == LWC_ALL) {
+				for (oid e = x + len; x < e; x++)
+					dst[cnt++] = x;
+			} else {
+				for (oid e = x + len; x < e; x++) {
+					dst[cnt] = x;
+					cnt += mask[x - bstart];
+				}
+			}
+		}
+	}
+	GDKfree(mask);
+	GDKfree(v);
+	BBPunfix(c->batCacheid);
+	if (s)
+		BBPunfix(s->batCacheid);
+	BATsetcount(bn, cnt);
+	bn->tsorted = true;
+	bn->trevsorted = cnt <= 1;
+	bn->tkey = true;
+	bn->tnil = false;
+	bn->tnonil = true;
+	bn->tseqbase = cnt == 0 ? 0 : cnt == 1 || dst[cnt - 1] - dst[0] == cnt - 1 ? dst[0] : oid_nil;
+	BBPkeepref(*res = bn->batCacheid);
+	return MAL_SUCCEED;
+}
+
+str
+LWCthetaselect(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	bat cid = *getArgReference_bat(stk, pci, 1);
+	bat sid = *getArgReference_bat(stk, pci, 2);
+	int tpe = getArgType(mb, pci, 3);
+	const void *val = VALptr(&stk->stk[getArg(pci, 3)]);
+	const char *op = *getArgReference_str(stk, pci, 4);
+	struct lwcpred p;
+	lng v;
+	int width;
+
+	(void) cntxt;
+	if ((width = lwcwidth(tpe)) == 0)
+		throw(MAL, "lwc.thetaselect", SEMANTIC_TYPE_MISMATCH);
+	v = lwcvalue(val, width);
+	if (is_lng_nil(v))
+		p = (struct lwcpred) {.none = true};
+	else if (strcmp(op, "==") == 0 || strcmp(op, "=") == 0)
+		lwcpredicate(&p, v, v, true, true, false);
+	else if (strcmp(op, "!=") == 0 || strcmp(op, "<>") == 0)
+		lwcpredicate(&p, v, v, true, true, true);
+	else if (strcmp(op, "<") == 0)
+		lwcpredicate(&p, lng_nil, v, false, false, false);
+	else if (strcmp(op, "<=") == 0)
+		lwcpredicate(&p, lng_nil, v, false, true, false);
+	else if (strcmp(op, ">") == 0)
+		lwcpredicate(&p, v, lng_nil, false, false, false);
+	else if (strcmp(op, ">=") == 0)
+		lwcpredicate(&p, v, lng_nil, true, false, false);
+	else
+		throw(MAL, "lwc.thetaselect", ILLEGAL_ARGUMENT " Unknown operator");
+	return lwcselect(res, cid, sid, tpe, &p, "lwc.thetaselect");
+}
+
+str
+LWCselect(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *res = getArgReference_bat(stk, pci, 0);
+	bat cid = *getArgReference_bat(stk, pci, 1);
+	bat sid = *getArgReference_bat(stk, pci, 2);
+	int tpe = getArgType(mb, pci, 3);
+	const void *low = VALptr(&stk->stk[getArg(pci, 3)]);
+	const void *high = VALptr(&stk->stk[getArg(pci, 4)]);
+	bit li = *getArgReference_bit(stk, pci, 5);
+	bit hi = *getArgReference_bit(stk, pci, 6);
+	bit anti = *getArgReference_bit(stk, pci, 7);
+	struct lwcpred p;
+	int width;
+
+	(void) cntxt;
+	if ((width = lwcwidth(tpe)) == 0)
+		throw(MAL, "lwc.select", SEMANTIC_TYPE_MISMATCH);
+	lwcpredicate(&p, lwcvalue(low, width), lwcvalue(high, width), li, hi, anti);
+	return lwcselect(res, cid, sid, tpe, &p, "lwc.select");
+}
+
+static inline bool
+lwcadd(lng *s, lng v)
+{
+	if ((v > 0 && *s > GDK_lng_max - v) || (v < 0 && *s < GDK_lng_min - v))
+		return false;
+	*s += v;
+	return true;
+}
+
+static inline bool
+lwcaddmul(lng *s, lng v, lng n)
+{
+	if (n != 0 && (v > GDK_lng_max / n || v < GDK_lng_min / n))
+		return false;
+	return lwcadd(s, v * n);
+}
+
+/* add the non-nil values of block blk to *sum, return the number of
+ * non-nil values or -1 on overflow */
+static lng
+lwcsumblock(const struct lwcblock *blk, lng *sum, lng *restrict v)
+{
+	const char *pl = (const char *) (blk + 1);
+	const uint64_t *w;
+	const uint16_t *ends;
+	uint64_t c, range, csum = 0;
+	uint32_t i, r;
+	lng nvals = 0, val;
+
+	if (is_lng_nil(blk->min))
+		return 0;
+	switch (blk->scheme) {
+	case LWC_FOR:
+		if (blk->bits <= 53) {
+			/* the sum of at most 2^10 offsets of at most 53
+			 * bits cannot overflow */
+			w = (const uint64_t *) pl;
+			range = (uint64_t) blk->max - (uint64_t) blk->min;
+			for (i = 0; i < blk->n; i++) {
+				c = lwcunpack(w, i, blk->bits);
+				if (!blk->hasnil || c <= range) {
+					csum += c;
+					nvals++;
+				}
+			}
+			if (!lwcaddmul(sum, blk->min, nvals) || !lwcadd(sum, (lng) csum))
+				return -1;
+			return nvals;
+		}
+		break;
+	case LWC_RLE:
+		ends = (const uint16_t *) pl;
+		w = (const uint64_t *) (pl + lwcrunends(blk->nruns));
+		for (i = 0, r = 0; r < blk->nruns; r++) {
+			val = lwcfromoffset(blk, lwcunpack(w, r, blk->bits));
+			if (!is_lng_nil(val)) {
+				if (!lwcaddmul(sum, val, ends[r] - i))
+					return -1;
+				nvals += ends[r] - i;
+			}
+			i = ends[r];
+		}
+		return nvals;
+	}
+	lwcdecode(blk, v);
+	for (i = 0; i < blk->n; i++) {
+		if (!is_lng_nil(v[i])) {
+			if (!lwcadd(sum, v[i]))
+				return -1;
+			nvals++;
+		}
+	}
+	return nvals;
+}
+
+str
+LWCsum(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	lng *res = getArgReference_lng(stk, pci, 0);
+	bat cid = *getArgReference_bat(stk, pci, 1);
+	int tpe = getArgType(mb, pci, 2);
+	const struct lwcheader *hdr;
+	const struct lwcblock *blk;
+	BAT *c;
+	BUN row;
+	lng sum = 0, nvals = 0, n, *v;
+	str msg;
+
+	(void) cntxt;
+	if ((c = BATdescriptor(cid)) == NULL)
+		throw(MAL, "lwc.sum", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((msg = lwcopen(c, tpe, &hdr, "lwc.sum")) != MAL_SUCCEED) {
+		BBPunfix(c->batCacheid);
+		return msg;
+	}
+	if ((v = GDKmalloc(LWC_BLOCKSIZE * sizeof(lng))) == NULL) {
+		BBPunfix(c->batCacheid);
+		throw(MAL, "lwc.sum", GDK_EXCEPTION);
+	}
+	for (row = 0, blk = lwcfirst(hdr); row < hdr->count; row += blk->n, blk = lwcnext(blk)) {
+		if ((n = lwcsumblock(blk, &sum, v)) < 0) {
+			GDKfree(v);
+			BBPunfix(c->batCacheid);
+			throw(MAL, "lwc.sum", SQLSTATE(22003) "overflow in calculation");
+		}
+		nvals += n;
+	}
+	GDKfree(v);
+	BBPunfix(c->batCacheid);
+	*res = nvals == 0 ? lng_nil : sum;
+	return MAL_SUCCEED;
+}
+
+/* min and max only need the block headers */
+static str
+lwcminmax(MalBlkPtr mb, MalStkPtr stk, InstrPtr pci, bool max, const char *func)
+{
+	bat cid = *getArgReference_bat(stk, pci, 1);
+	int tpe = getArgType(mb, pci, 2);
+	const struct lwcheader *hdr;
+	const struct lwcblock *blk;
+	BAT *c;
+	BUN row;
+	lng res = lng_nil;
+	union {
+		bte b;
+		sht s;
+		int i;
+		lng l;
+	} val;
+	str msg;
+
+	if ((c = BATdescriptor(cid)) == NULL)
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((msg = lwcopen(c, tpe, &hdr, func)) != MAL_SUCCEED) {
+		BBPunfix(c->batCacheid);
+		return msg;
+	}
+	for (row = 0, blk = lwcfirst(hdr); row < hdr->count; row += blk->n, blk = lwcnext(blk)) {
+		if (is_lng_nil(blk->min))
+			continue;
+		if (max) {
+			if (is_lng_nil(res) || blk->max > res)
+				res = blk->max;
+		} else {
+			if (is_lng_nil(res) || blk->min < res)
+				res = blk->min;
+		}
+	}
+	lwcstore(&val, hdr->width, 0, 1, &res);
+	BBPunfix(c->batCacheid);
+	if (VALinit(&stk->stk[getArg(pci, 0)], tpe, &val) == NULL)
+		throw(MAL, func, GDK_EXCEPTION);
+	return MAL_SUCCEED;
+}
+
+str
+LWCmin(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	(void) cntxt;
+	return lwcminmax(mb, stk, pci, false, "lwc.min");
+}
+
+str
+LWCmax(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	(void) cntxt;
+	return lwcminmax(mb, stk, pci, true, "lwc.max");
+}
@@ -44,9 +44,11 @@ MATpackInternal(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 {
 	int i;
 	bat *ret = getArgReference_bat(stk,p,0);
-	BAT *b, *bn;
-	BUN cap = 0;
+	BAT *b, *bn, **bats;
+	int nbats = 0;
+	BUN cap = 0, cnt = 0;
 	int tt = TYPE_any;
+	gdk_return rc;
 	(void) cntxt;
 	(void) mb;
 
@@ -70,21 +72,32 @@ MATpackInternal(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 	if (bn == NULL)
 		throw(MAL, "mat.pack", SQLSTATE(HY001) MAL_MALLOC_FAIL);
 
+	/* collect all pieces so that they can be appended in one go,
+	 * which allows string heaps to be merged in parallel */
+	bats = GDKmalloc((p->argc - 1) * sizeof(BAT *));
+	if (bats == NULL) {
+		BBPunfix(bn->batCacheid);
+		throw(MAL, "mat.pack", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
 	for (i = 1; i < p->argc; i++) {
 		b = BATdescriptor(stk->stk[getArg(p,i)].val.ival);
 		if( b ){
-			if (BATcount(bn) == 0) {
+			if (cnt == 0) {
 				BAThseqbase(bn, b->hseqbase);
 				BATtseqbase(bn, b->tseqbase);
 			}
-			if (BATappend(bn, b, NULL, false) != GDK_SUCCEED) {
-				BBPunfix(bn->batCacheid);
-				BBPunfix(b->batCacheid);
-				throw(MAL, "mat.pack", GDK_EXCEPTION);
-			}
-			BBPunfix(b->batCacheid);
+			cnt += BATcount(b);
+			bats[nbats++] = b;
 		}
 	}
+	rc = BATappendmany(bn, bats, nbats, false);
+	for (i = 0; i < nbats; i++)
+		BBPunfix(bats[i]->batCacheid);
+	GDKfree(bats);
+	if (rc != GDK_SUCCEED) {
+		BBPunfix(bn->batCacheid);
+		throw(MAL, "mat.pack", GDK_EXCEPTION);
+	}
 	if( !(!bn->tnil || !bn->tnonil)){
 		BBPkeepref(*ret = bn->batCacheid);
 		throw(MAL, "mat.pack", "INTERNAL ERROR" "bn->tnil or  bn->tnonil fails ");
@@ -241,6 +241,7 @@ MDBgetDebugFlags(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 	addFlag("deadcode", OPTdeadcode, OPTdebug);
 	addFlag("emptybind", OPTemptybind, OPTdebug);
 	addFlag("evaluate", OPTevaluate, OPTdebug);
+	addFlag("fuse", OPTfuse, OPTdebug);
 	addFlag("garbagecollector", OPTgarbagecollector, OPTdebug);
 	addFlag("generator", OPTgenerator, OPTdebug);
 	addFlag("inline", OPTinline, OPTdebug);
@@ -303,6 +304,7 @@ MDBsetDebugStr_(int *ret, str *flg)
 	if( strcmp("deadcode", *flg) == 0) OPTdebug ^= OPTdeadcode;
 	if( strcmp("emptybind", *flg) == 0) OPTdebug ^= OPTemptybind;
 	if( strcmp("evaluate", *flg) == 0) OPTdebug ^= OPTevaluate;
+	if( strcmp("fuse", *flg) == 0) OPTdebug ^= OPTfuse;
 	if( strcmp("garbagecollector", *flg) == 0) OPTdebug ^= OPTgarbagecollector;
 	if( strcmp("generator", *flg) == 0) OPTdebug ^= OPTgenerator;
 	if( strcmp("inline", *flg) == 0) OPTdebug ^= OPTinline;
@@ -0,0 +1,658 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2019 MonetDB B.V.
+ */
+
+/*
+ * Expression fusion.
+ * Arithmetic expressions are compiled into a sequence of batcalc
+ * instructions, each of which materializes its result in a new BAT.
+ * For an expression like (a*b + c) / d this means three full passes
+ * over memory and two intermediates that are used only once.
+ *     X_10 := batcalc.*(X_1, X_2);
+ *     X_11 := batcalc.+(X_10, X_3);
+ *     X_12 := batcalc./(X_11, X_4);
+ * This optimizer collects such chains into a single instruction,
+ *     X_12 := batcalc.fuse("0 1 * 2 + 3 /", X_1, X_2, X_3, X_4);
+ * which evaluates the expression (given in postfix notation, operands
+ * referred to by number) in cache-sized vectors without materializing
+ * the intermediates.
+ * Only the plain (overflow-checking) operators +, -, * and / without
+ * candidate lists are fused, and only if all operands and the result
+ * are of the same numeric type, so that the semantics of the fused
+ * expression are those of the individual operations.  An intermediate
+ * is only absorbed if its sole use is in the next operation of the
+ * chain.
+ *
+ * Predicates are handled likewise.  Comparisons and logical operators
+ * produce a bit column each, even if the result is only used to select
+ * rows or to choose between two values, as in OR-heavy WHERE clauses
+ * and CASE expressions:
+ *     X_10 := batcalc.<(X_1, X_2);
+ *     X_11 := batcalc.==(X_3, 0:int);
+ *     X_12 := batcalc.or(X_10, X_11);
+ *     C_13 := algebra.select(X_12, C_5, true, true, true, true, false);
+ * A predicate tree that ends in such a selection or in the condition of
+ * a batcalc.ifthenelse is replaced by a single call,
+ *     C_13 := algebra.maskselect(C_5, "0 1 < 2 3 == or", X_1, X_2, X_3, 0:int);
+ * which evaluates the predicate into bit masks (see BATmaskselect and
+ * BATmaskifthenelse) and never materializes the bit columns.  The
+ * idiom ifthenelse(isnil(X), false, X) that the SQL compiler uses to
+ * turn nil conditions into false is recognized as the operator istrue.
+ */
+#include "monetdb_config.h"
+#include "opt_fuse.h"
+
+/* limits imposed by BATcalcfused */
+#define MAXFUSEDEPTH	16
+#define MAXFUSEOPS	32
+#define MAXFUSEARGS	(MAXFUSEOPS + 1)
+
+/* limits imposed by BATmaskselect and BATmaskifthenelse */
+#define MAXMASKDEPTH	16
+#define MAXMASKOPS	64
+
+static int
+isFusable(MalBlkPtr mb, InstrPtr p)
+{
+	int i, tpe, bats = 0;
+	const char *f;
+
+	if (getModuleId(p) != batcalcRef || p->barrier ||
+	    p->retc != 1 || p->argc != 3)
+		return 0;
+	f = getFunctionId(p);
+	if (f[0] == 0 || f[1] != 0 || strchr("+-*/", f[0]) == NULL)
+		return 0;
+	tpe = getArgType(mb, p, 0);
+	if (!isaBatType(tpe))
+		return 0;
+	tpe = getBatType(tpe);
+	switch (tpe) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		break;
+	default:
+		return 0;
+	}
+	for (i = 1; i < 3; i++) {
+		int t = getArgType(mb, p, i);
+		if (isaBatType(t)) {
+			if (getBatType(t) != tpe)
+				return 0;
+			bats++;
+		} else if (t != tpe)
+			return 0;
+	}
+	return bats > 0;
+}
+
+/* Produce the postfix expression for the tree rooted at instruction
+ * p, collecting the operands in args.  The size of the tree was
+ * limited to MAXFUSEOPS operations, so the buffers suffice. */
+static void
+fuseExpr(InstrPtr *old, const int *def, const int *absorbed, InstrPtr p, char *buf, size_t *len, int *args, int *nargs)
+{
+	int i, j, a;
+
+	for (i = 1; i < 3; i++) {
+		a = getArg(p, i);
+		if (def[a] >= 0 && absorbed[def[a]]) {
+			fuseExpr(old, def, absorbed, old[def[a]], buf, len, args, nargs);
+			continue;
+		}
+		for (j = 0; j < *nargs; j++)
+			if (args[j] == a)
+				break;
+		if (j == *nargs) {
+			assert(*nargs < MAXFUSEARGS);
+			args[(*nargs)++] = a;
+		}
+		*len += sprintf(buf + *len, "%d ", j);
+	}
+	*len += sprintf(buf + *len, "%s ", getFunctionId(p));
+}
+
+/* count the uses of each variable and record the instruction that
+ * assigns it (-1 if none, -2 if more than one) */
+static str
+fuseUses(MalBlkPtr mb, int **usesp, int **defp)
+{
+	int i, j, *uses, *def;
+	InstrPtr p;
+
+	uses = GDKzalloc(mb->vtop * sizeof(int));
+	def = GDKmalloc(mb->vtop * sizeof(int));
+	if (uses == NULL || def == NULL) {
+		GDKfree(uses);
+		GDKfree(def);
+		throw(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	for (i = 0; i < mb->vtop; i++)
+		def[i] = -1;
+	for (i = 0; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		for (j = 0; j < p->argc; j++) {
+			if (j >= p->retc || i == 0)
+				uses[getArg(p, j)]++;
+			else if (def[getArg(p, j)] == -1)
+				def[getArg(p, j)] = i;
+			else
+				def[getArg(p, j)] = -2;	/* assigned more than once */
+		}
+	}
+	*usesp = uses;
+	*defp = def;
+	return MAL_SUCCEED;
+}
+
+/* Undo a partially rewritten block: free the fused instructions that
+ * were added and put back the original instructions, including those
+ * that were to be absorbed into an instruction that wasn't fused. */
+static void
+fuseRestore(MalBlkPtr mb, InstrPtr *old, int limit, int slimit)
+{
+	int i, j = 0, k;
+
+	for (i = 0; i < mb->stop; i++) {
+		for (k = j; k < limit && old[k] != mb->stmt[i]; k++)
+			;
+		if (k == limit)
+			freeInstruction(mb->stmt[i]);
+		else
+			j = k + 1;
+	}
+	GDKfree(mb->stmt);
+	mb->stmt = old;
+	mb->stop = limit;
+	mb->ssize = slimit;
+}
+
+static str
+fuseArithmetic(Client cntxt, MalBlkPtr mb, int *actions)
+{
+	int i, j, k, limit, slimit;
+	InstrPtr p, q, *old = NULL;
+	int *uses = NULL, *def = NULL, *absorbed = NULL, *nops = NULL, *depth = NULL;
+	int args[MAXFUSEARGS], nargs, fused = 0;
+	char expr[8 * MAXFUSEARGS];
+	size_t len;
+	str msg = MAL_SUCCEED;
+
+	for (i = 1; i < mb->stop; i++)
+		if (isFusable(mb, getInstrPtr(mb, i)))
+			break;
+	if (i == mb->stop)
+		return MAL_SUCCEED;
+
+	if ((msg = fuseUses(mb, &uses, &def)) != MAL_SUCCEED)
+		return msg;
+	absorbed = GDKzalloc(mb->stop * sizeof(int));
+	nops = GDKzalloc(mb->stop * sizeof(int));
+	depth = GDKzalloc(mb->stop * sizeof(int));
+	if (absorbed == NULL || nops == NULL || depth == NULL) {
+		msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+
+	/* decide which instructions are absorbed into the expression of
+	 * their (only) consumer; nops and depth keep track of the size
+	 * of the fused expression and the evaluation stack it needs */
+	for (i = 1; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		if (!isFusable(mb, p))
+			continue;
+		int d[2], n = 1;
+		for (j = 1; j < 3; j++) {
+			int a = getArg(p, j), s = def[a] >= 0 ? def[a] : 0;
+			d[j - 1] = 1;
+			if (s > 0 && nops[s] > 0 && uses[a] == 1 && !absorbed[s] &&
+			    n + nops[s] <= MAXFUSEOPS &&
+			    depth[s] + j - 1 <= MAXFUSEDEPTH) {
+				absorbed[s] = 1;
+				n += nops[s];
+				d[j - 1] = depth[s];
+			}
+		}
+		nops[i] = n;
+		depth[i] = MAX(d[0], d[1] + 1);
+	}
+
+	old = mb->stmt;
+	limit = mb->stop;
+	slimit = mb->ssize;
+	if (newMalBlkStmt(mb, mb->ssize) < 0) {
+		old = NULL;
+		msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+	for (i = 0; i < limit; i++) {
+		p = old[i];
+		if (absorbed[i])
+			continue;	/* will be part of its consumer */
+		if (nops[i] <= 1) {
+			pushInstruction(mb, p);
+			continue;
+		}
+		len = 0;
+		nargs = 0;
+		fuseExpr(old, def, absorbed, p, expr, &len, args, &nargs);
+		expr[len - 1] = 0;	/* drop trailing space */
+		q = newInstructionArgs(mb, batcalcRef, fuseRef, nargs + 2);
+		if (q == NULL) {
+			msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+			fuseRestore(mb, old, limit, slimit);
+			goto wrapup;
+		}
+		getArg(q, 0) = getArg(p, 0);
+		q = pushStr(mb, q, expr);
+		for (k = 0; k < nargs; k++)
+			q = pushArgument(mb, q, args[k]);
+		pushInstruction(mb, q);
+		typeChecker(cntxt->usermodule, mb, q, TRUE);
+		fused += nops[i] - 1;
+		if (OPTdebug & OPTfuse) {
+			fprintf(stderr, "#fused %d operations\n", nops[i]);
+			fprintInstruction(stderr, mb, 0, q, LIST_MAL_ALL);
+		}
+	}
+	/* the fused instructions are no longer referenced */
+	for (i = 0; i < limit; i++)
+		if (absorbed[i] || nops[i] > 1)
+			freeInstruction(old[i]);
+	*actions += fused;
+	for (; i < slimit; i++)
+		if (old[i])
+			freeInstruction(old[i]);
+	GDKfree(old);
+
+wrapup:
+	GDKfree(uses);
+	GDKfree(def);
+	GDKfree(absorbed);
+	GDKfree(nops);
+	GDKfree(depth);
+	return msg;
+}
+
+/* kinds of instructions that can be part of a fused predicate */
+enum {
+	PRED_NONE,
+	PRED_CMP,		/* comparison of two values */
+	PRED_LOGIC,		/* and, or, not on bit columns */
+	PRED_ISTRUE,		/* ifthenelse(isnil(X), false, X) */
+};
+
+static int
+isBitArg(MalBlkPtr mb, InstrPtr p, int i)
+{
+	int t = getArgType(mb, p, i);
+	return t == TYPE_bit || t == newBatType(TYPE_bit);
+}
+
+static int
+isBitConstant(MalBlkPtr mb, int a, bit v)
+{
+	return isVarConstant(mb, a) && getVarType(mb, a) == TYPE_bit &&
+		getVarConstant(mb, a).val.btval == v;
+}
+
+static int
+isComparison(const char *f)
+{
+	static const char *cmps[] = {"<", "<=", "==", "!=", ">", ">=", NULL};
+
+	for (int i = 0; cmps[i]; i++)
+		if (strcmp(f, cmps[i]) == 0)
+			return 1;
+	return 0;
+}
+
+static int
+predicateKind(MalBlkPtr mb, InstrPtr p, const int *uses, const int *def)
+{
+	const char *f;
+	int t1, t2;
+
+	if (getModuleId(p) != batcalcRef || p->barrier || p->retc != 1 ||
+	    getArgType(mb, p, 0) != newBatType(TYPE_bit))
+		return PRED_NONE;
+	f = getFunctionId(p);
+	if (p->argc == 3 && isComparison(f)) {
+		t1 = getArgType(mb, p, 1);
+		t2 = getArgType(mb, p, 2);
+		if (!isaBatType(t1) && !isaBatType(t2))
+			return PRED_NONE;
+		if (getBatType(t1) != getBatType(t2))
+			return PRED_NONE;
+		switch (ATOMstorage(getBatType(t1))) {
+		case TYPE_bte:
+		case TYPE_sht:
+		case TYPE_int:
+		case TYPE_lng:
+#ifdef HAVE_HGE
+		case TYPE_hge:
+#endif
+		case TYPE_flt:
+		case TYPE_dbl:
+			return PRED_CMP;
+		default:
+			return PRED_NONE;
+		}
+	}
+	if (p->argc == 3 && (f == andRef || strcmp(f, "or") == 0) &&
+	    isBitArg(mb, p, 1) && isBitArg(mb, p, 2))
+		return PRED_LOGIC;
+	if (p->argc == 2 && f == notRef &&
+	    getArgType(mb, p, 1) == newBatType(TYPE_bit))
+		return PRED_LOGIC;
+	if (p->argc == 4 && f == ifthenelseRef &&
+	    getArgType(mb, p, 3) == newBatType(TYPE_bit) &&
+	    isBitConstant(mb, getArg(p, 2), 0)) {
+		int c = getArg(p, 1), x = getArg(p, 3);
+		InstrPtr q;
+
+		if (def[c] <= 0 || uses[c] != 1 || uses[x] != 2)
+			return PRED_NONE;
+		q = getInstrPtr(mb, def[c]);
+		if (getModuleId(q) == batcalcRef && strcmp(getFunctionId(q), "isnil") == 0 &&
+		    q->retc == 1 && q->argc == 2 && getArg(q, 1) == x)
+			return PRED_ISTRUE;
+	}
+	return PRED_NONE;
+}
+
+struct predexpr {
+	char expr[8 * MAXMASKOPS];
+	size_t len;
+	int nops;
+	int args[MAXMASKOPS];
+	int nargs;
+	int absorb[2 * MAXMASKOPS];	/* instructions taken over */
+	int nabsorb;
+	int invalid;		/* an operand is assigned more than once */
+};
+
+static void
+predToken(struct predexpr *pe, const char *tok)
+{
+	if (++pe->nops <= MAXMASKOPS)
+		pe->len += sprintf(pe->expr + pe->len, "%s ", tok);
+}
+
+/* Produce the postfix predicate for bit column a, which has need uses
+ * in the tree.  Returns the depth of the evaluation stack needed. */
+static int
+predExpr(MalBlkPtr mb, const int *kind, const int *uses, const int *def,
+	 int a, int need, struct predexpr *pe)
+{
+	int d = def[a], dep, j;
+	InstrPtr p;
+	char num[16];
+
+	if (d > 0 && kind[d] != PRED_NONE && uses[a] == need &&
+	    pe->nabsorb < 2 * MAXMASKOPS - 1) {
+		p = getInstrPtr(mb, d);
+		pe->absorb[pe->nabsorb++] = d;
+		switch (kind[d]) {
+		case PRED_ISTRUE:
+			pe->absorb[pe->nabsorb++] = def[getArg(p, 1)];
+			dep = predExpr(mb, kind, uses, def, getArg(p, 3), 2, pe);
+			predToken(pe, "istrue");
+			break;
+		case PRED_LOGIC:
+			if (p->argc == 2) {
+				dep = predExpr(mb, kind, uses, def, getArg(p, 1), 1, pe);
+				predToken(pe, "not");
+				break;
+			}
+			/* fall through */
+		default:
+			dep = predExpr(mb, kind, uses, def, getArg(p, 1), 1, pe);
+			j = predExpr(mb, kind, uses, def, getArg(p, 2), 1, pe) + 1;
+			dep = MAX(dep, j);
+			predToken(pe, getFunctionId(p));
+			break;
+		}
+		return dep;
+	}
+	if (d == -2)
+		pe->invalid = 1;
+	for (j = 0; j < pe->nargs; j++)
+		if (pe->args[j] == a)
+			break;
+	if (j == pe->nargs && pe->nargs < MAXMASKOPS)
+		pe->args[pe->nargs++] = a;
+	snprintf(num, sizeof(num), "%d", j);
+	predToken(pe, num);
+	return 1;
+}
+
+/* Is instruction p a selection of the rows for which the bit column
+ * is true, or an ifthenelse, whose condition is a predicate?  Returns
+ * the argument number of the candidate list of a selection (-1 if
+ * there is none), 0 for an ifthenelse, and -2 otherwise. */
+static int
+predicateRoot(MalBlkPtr mb, InstrPtr p, const int *kind, const int *uses, const int *def)
+{
+	int c, k, tpe;
+
+	if (p->barrier || p->retc != 1 || p->argc < 2 ||
+	    getArgType(mb, p, 1) != newBatType(TYPE_bit))
+		return -2;
+	c = getArg(p, 1);
+	if (def[c] <= 0 || kind[def[c]] == PRED_NONE || uses[c] != 1)
+		return -2;
+	if (getModuleId(p) == algebraRef && getFunctionId(p) == selectRef) {
+		if (p->argc == 7)
+			k = 2;
+		else if (p->argc == 8 && isaBatType(getArgType(mb, p, 2)))
+			k = 3;
+		else
+			return -2;
+		if (!isBitConstant(mb, getArg(p, k), 1) ||
+		    !isBitConstant(mb, getArg(p, k + 1), 1) ||
+		    !isBitConstant(mb, getArg(p, k + 2), 1) ||
+		    !isBitConstant(mb, getArg(p, k + 3), 1) ||
+		    !isBitConstant(mb, getArg(p, k + 4), 0))
+			return -2;
+		return k == 3 ? 2 : -1;
+	}
+	if (getModuleId(p) == batcalcRef && getFunctionId(p) == ifthenelseRef &&
+	    p->argc == 4) {
+		tpe = getArgType(mb, p, 0);
+		if (!isaBatType(tpe) || getBatType(tpe) == TYPE_oid ||
+		    getBatType(tpe) == TYPE_void || getBatType(tpe) == TYPE_any)
+			return -2;
+		return 0;
+	}
+	return -2;
+}
+
+static str
+fusePredicates(Client cntxt, MalBlkPtr mb, int *actions)
+{
+	int i, k, limit, slimit;
+	InstrPtr p, q, *old = NULL;
+	int *uses = NULL, *def = NULL, *kind = NULL, *absorbed = NULL;
+	int *roots = NULL;
+	char **exprs = NULL;
+	int **args = NULL;
+	struct predexpr pe;
+	str msg = MAL_SUCCEED;
+
+	for (i = 1; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		if (getModuleId(p) == batcalcRef && getArgType(mb, p, 0) == newBatType(TYPE_bit))
+			break;
+	}
+	if (i == mb->stop)
+		return MAL_SUCCEED;
+
+	if ((msg = fuseUses(mb, &uses, &def)) != MAL_SUCCEED)
+		return msg;
+	limit = mb->stop;
+	kind = GDKzalloc(mb->stop * sizeof(int));
+	absorbed = GDKzalloc(mb->stop * sizeof(int));
+	roots = GDKmalloc(mb->stop * sizeof(int));
+	exprs = GDKzalloc(mb->stop * sizeof(char *));
+	args = GDKzalloc(mb->stop * sizeof(int *));
+	if (kind == NULL || absorbed == NULL || roots == NULL || exprs == NULL || args == NULL) {
+		msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+	for (i = 1; i < mb->stop; i++)
+		kind[i] = predicateKind(mb, getInstrPtr(mb, i), uses, def);
+
+	/* collect the predicate trees of the selections and ifthenelses;
+	 * an instruction is taken over if its result has no other use
+	 * than in the tree */
+	for (i = 1; i < mb->stop; i++) {
+		p = getInstrPtr(mb, i);
+		roots[i] = predicateRoot(mb, p, kind, uses, def);
+		if (roots[i] == -2)
+			continue;
+		pe = (struct predexpr) {.len = 0};
+		k = predExpr(mb, kind, uses, def, getArg(p, 1), 1, &pe);
+		if (k > MAXMASKDEPTH || pe.nops > MAXMASKOPS ||
+		    pe.nargs == MAXMASKOPS || pe.invalid) {
+			roots[i] = -2;
+			continue;
+		}
+		pe.expr[pe.len - 1] = 0;	/* drop trailing space */
+		exprs[i] = GDKstrdup(pe.expr);
+		args[i] = GDKmalloc((pe.nargs + 1) * sizeof(int));
+		if (exprs[i] == NULL || args[i] == NULL) {
+			msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+			goto wrapup;
+		}
+		args[i][0] = pe.nargs;
+		memcpy(args[i] + 1, pe.args, pe.nargs * sizeof(int));
+		for (k = 0; k < pe.nabsorb; k++)
+			absorbed[pe.absorb[k]] = 1;
+	}
+
+	old = mb->stmt;
+	slimit = mb->ssize;
+	if (newMalBlkStmt(mb, mb->ssize) < 0) {
+		old = NULL;
+		msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto wrapup;
+	}
+	for (i = 0; i < limit; i++) {
+		p = old[i];
+		if (absorbed[i])
+			continue;	/* will be part of its consumer */
+		if (exprs[i] == NULL) {
+			pushInstruction(mb, p);
+			continue;
+		}
+		if (roots[i] == 0) {
+			q = newInstructionArgs(mb, batcalcRef, maskifthenelseRef, args[i][0] + 4);
+			if (q != NULL) {
+				getArg(q, 0) = getArg(p, 0);
+				q = pushArgument(mb, q, getArg(p, 2));
+				q = pushArgument(mb, q, getArg(p, 3));
+			}
+		} else {
+			q = newInstructionArgs(mb, algebraRef, maskselectRef, args[i][0] + 3);
+			if (q != NULL) {
+				getArg(q, 0) = getArg(p, 0);
+				if (roots[i] > 0)
+					q = pushArgument(mb, q, getArg(p, roots[i]));
+				else
+					q = pushNil(mb, q, newBatType(TYPE_oid));
+			}
+		}
+		if (q == NULL) {
+			msg = createException(MAL, "optimizer.fuse", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+			fuseRestore(mb, old, limit, slimit);
+			goto wrapup;
+		}
+		q = pushStr(mb, q, exprs[i]);
+		for (k = 1; k <= args[i][0]; k++)
+			q = pushArgument(mb, q, args[i][k]);
+		pushInstruction(mb, q);
+		typeChecker(cntxt->usermodule, mb, q, TRUE);
+		if (OPTdebug & OPTfuse) {
+			fprintf(stderr, "#fused predicate\n");
+			fprintInstruction(stderr, mb, 0, q, LIST_MAL_ALL);
+		}
+	}
+	/* the fused instructions are no longer referenced */
+	for (i = 0; i < limit; i++)
+		if (absorbed[i] || exprs[i]) {
+			*actions += absorbed[i];
+			freeInstruction(old[i]);
+		}
+	for (; i < slimit; i++)
+		if (old[i])
+			freeInstruction(old[i]);
+	GDKfree(old);
+
+wrapup:
+	if (exprs) {
+		for (i = 0; i < limit; i++) {
+			GDKfree(exprs[i]);
+			GDKfree(args[i]);
+		}
+	}
+	GDKfree(uses);
+	GDKfree(def);
+	GDKfree(kind);
+	GDKfree(absorbed);
+	GDKfree(roots);
+	GDKfree(exprs);
+	GDKfree(args);
+	return msg;
+}
+
+str
+OPTfuseImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	int i, actions = 0;
+	char buf[256];
+	lng usec = GDKusec();
+	str msg = MAL_SUCCEED;
+
+	(void) pci;
+	(void) stk;		/* to fool compilers */
+
+	for (i = 1; i < mb->stop; i++) {
+		if (blockStart(getInstrPtr(mb, i)))	/* leave control flow alone */
+			goto wrapup;
+	}
+	msg = fuseArithmetic(cntxt, mb, &actions);
+	if (msg == MAL_SUCCEED)
+		msg = fusePredicates(cntxt, mb, &actions);
+
+	/* Defense line against incorrect plans */
+	if (actions > 0) {
+		chkTypes(cntxt->usermodule, mb, FALSE);
+		chkFlow(mb);
+		chkDeclarations(mb);
+	}
+wrapup:
+	/* keep all actions taken as a post block comment */
+	usec = GDKusec() - usec;
+	snprintf(buf, 256, "%-20s actions=%2d time=" LLFMT " usec", "fuse", actions, usec);
+	newComment(mb, buf);
+	if (actions >= 0)
+		addtoMalBlkHistory(mb);
+
+	if (OPTdebug & OPTfuse) {
+		fprintf(stderr, "#FUSE optimizer exit\n");
+		fprintFunction(stderr, mb, 0, LIST_MAL_ALL);
+	}
+	return msg;
+}
@@ -79,6 +79,7 @@ static struct PIPELINES {
 	 "optimizer.commonTerms();"
 	 "optimizer.projectionpath();"
 	 "optimizer.deadcode();"
+	 "optimizer.fuse();"
 	 "optimizer.reorder();"
 	 "optimizer.matpack();"
 	 "optimizer.dataflow();"
@@ -115,6 +116,7 @@ static struct PIPELINES {
 	 "optimizer.commonTerms();"
 	 "optimizer.projectionpath();"
 	 "optimizer.deadcode();"
+	 "optimizer.fuse();"
 	 "optimizer.reorder();"
 	 "optimizer.matpack();"
 	 "optimizer.dataflow();"
@@ -151,6 +153,7 @@ static struct PIPELINES {
 	 "optimizer.commonTerms();"
 	 "optimizer.projectionpath();"
 	 "optimizer.deadcode();"
+	 "optimizer.fuse();"
 	 "optimizer.reorder();"
 	 "optimizer.matpack();"
 	 "optimizer.dataflow();"
@@ -193,6 +196,7 @@ static struct PIPELINES {
 	 "optimizer.commonTerms();"
 	 "optimizer.projectionpath();"
 	 "optimizer.deadcode();"
+	 "optimizer.fuse();"
 	 "optimizer.reorder();"
 	 "optimizer.matpack();"
 	 "optimizer.dataflow();"
@@ -234,6 +238,7 @@ static struct PIPELINES {
 	 "optimizer.commonTerms();"
 	 "optimizer.projectionpath();"
 	 "optimizer.deadcode();"
+	 "optimizer.fuse();"
 	 "optimizer.reorder();"
 	 "optimizer.matpack();"
 	 "optimizer.querylog();"
@@ -133,6 +133,7 @@ str findRef;
 str finishRef;
 str firstnRef;
 str first_valueRef;
+str fuseRef;
 str generatorRef;
 str getRef;
 str getTraceRef;
@@ -174,6 +175,8 @@ str malRef;
 str manifoldRef;
 str mapiRef;
 str markRef;
+str maskifthenelseRef;
+str maskselectRef;
 str matRef;
 str max_no_nilRef;
 str maxRef;
@@ -436,6 +439,7 @@ void optimizerInit(void)
 	finishRef = putName("finish");
 	firstnRef = putName("firstn");
 	first_valueRef = putName("first_value");
+	fuseRef = putName("fuse");
 	generatorRef = putName("generator");
 	getRef = putName("get");
 	getTraceRef = putName("getTrace");
@@ -477,6 +481,8 @@ void optimizerInit(void)
 	manifoldRef = putName("manifold");
 	mapiRef = putName("mapi");
 	markRef = putName("mark");
+	maskifthenelseRef = putName("maskifthenelse");
+	maskselectRef = putName("maskselect");
 	matRef = putName("mat");
 	max_no_nilRef = putName("max_no_nil");
 	maxRef = putName("max");
@@ -130,6 +130,7 @@ mal_export  str findRef;
 mal_export  str finishRef;
 mal_export  str firstnRef;
 mal_export  str first_valueRef;
+mal_export  str fuseRef;
 mal_export  str generatorRef;
 mal_export  str getRef;
 mal_export  str getTraceRef;
@@ -173,6 +174,8 @@ mal_export  str malRef;
 mal_export  str manifoldRef;
 mal_export  str mapiRef;
 mal_export  str markRef;
+mal_export  str maskifthenelseRef;
+mal_export  str maskselectRef;
 mal_export  str matRef;
 mal_export  str max_no_nilRef;
 mal_export  str maxRef;
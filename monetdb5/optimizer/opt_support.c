@@ -36,6 +36,7 @@ struct OPTcatalog {
 {"deadcode",	0,	0,	0},
 {"emptybind",	0,	0,	0},
 {"evaluate",	0,	0,	0},
+{"fuse",		0,	0,	0},
 {"garbage",		0,	0,	0},
 {"generator",	0,	0,	0},
 {"history",		0,	0,	0},
@@ -30,6 +30,7 @@
 #include "opt_deadcode.h"
 #include "opt_emptybind.h"
 #include "opt_evaluate.h"
+#include "opt_fuse.h"
 #include "opt_garbageCollector.h"
 #include "opt_generator.h"
 #include "opt_inline.h"
@@ -68,6 +69,7 @@ struct{
 	{"deadcode", &OPTdeadcodeImplementation,0,0},
 	{"emptybind", &OPTemptybindImplementation,0,0},
 	{"evaluate", &OPTevaluateImplementation,0,0},
+	{"fuse", &OPTfuseImplementation,0,0},
 	{"garbageCollector", &OPTgarbageCollectorImplementation,0,0},
 	{"generator", &OPTgeneratorImplementation,0,0},
 	{"inline", &OPTinlineImplementation,0,0},
@@ -155,6 +155,9 @@ sqlcleanup(mvc *c, int err)
 		}
 		store_unlock();
 		c->emod = 0;
+		/* as in mvc_commit, sync the log outside the store lock */
+		if (!err && logger_funcs.log_tsync() != LOG_OK)
+			GDKfatal("transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", GDKerrbuf);
 	}
 	/* some statements dynamically disable caching */
 	c->sym = NULL;
@@ -1183,6 +1186,12 @@ mvc_bind_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 					throw(SQL, "sql.bind", SQLSTATE(HY001) MAL_MALLOC_FAIL);
 				}
 				BAThseqbase(bn, part_nr * psz);
+				/* the binds of all partitions of a
+				 * mitosis plan are done up front, so
+				 * this gets the OS reading the later
+				 * partitions while the first ones are
+				 * being worked on */
+				BATadvise(bn, MMAP_WILLNEED);
 			} else {
 				/* BAT b holds the UPD_ID bat */
 				oid l, h;
@@ -1514,6 +1523,7 @@ mvc_bind_idxbat_wrap(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 				if(bn == NULL)
 					throw(SQL, "sql.bindidx", SQLSTATE(HY001) MAL_MALLOC_FAIL);
 				BAThseqbase(bn, part_nr * psz);
+				BATadvise(bn, MMAP_WILLNEED);
 			} else {
 				/* BAT b holds the UPD_ID bat */
 				oid l, h;
@@ -2136,10 +2146,44 @@ DELTAproject(bat *result, const bat *sub, const bat *col, const bat *uid, const
 
 	/* projection(sub,col).union(projection(sub,i)) */
 	res = c;
+	tres = NULL;
 	if (i && BATcount(i)) {
 		if (BATcount(c) == 0) {
 			res = i;
 			i = c;
+		} else if (BATtordered(s) &&
+			   i->hseqbase == c->hseqbase + BATcount(c)) {
+			/* the first part of sub refers to col and the
+			 * rest to the inserts, so project the two parts
+			 * separately instead of first copying all of col
+			 * to append the inserts to */
+			BUN p = SORTfndfirst(s, &i->hseqbase);
+			BAT *s1 = BATslice(s, 0, p);
+			BAT *s2 = BATslice(s, p, BATcount(s));
+			BAT *t2 = NULL;
+
+			if (s1 && s2 &&
+			    (tres = BATproject(s1, c)) != NULL &&
+			    ((t2 = BATproject(s2, i)) == NULL ||
+			     (tres = setwritable(tres)) == NULL ||
+			     BATappend(tres, t2, NULL, false) != GDK_SUCCEED)) {
+				if (tres)
+					BBPunfix(tres->batCacheid);
+				tres = NULL;
+			}
+			if (s1)
+				BBPunfix(s1->batCacheid);
+			if (s2)
+				BBPunfix(s2->batCacheid);
+			if (t2)
+				BBPunfix(t2->batCacheid);
+			BBPunfix(c->batCacheid);
+			BBPunfix(i->batCacheid);
+			if (tres == NULL) {
+				BBPunfix(s->batCacheid);
+				throw(MAL, "sql.projectdelta", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+			}
+			res = i = NULL;
 		} else {
 			if ((res = COLcopy(c, c->ttype, true, TRANSIENT)) == NULL) {
 				BBPunfix(s->batCacheid);
@@ -2158,11 +2202,13 @@ DELTAproject(bat *result, const bat *sub, const bat *col, const bat *uid, const
 	if (i)
 		BBPunfix(i->batCacheid);
 
-	tres = BATproject(s, res);
-	BBPunfix(res->batCacheid);
 	if (tres == NULL) {
-		BBPunfix(s->batCacheid);
-		throw(MAL, "sql.projectdelta", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		tres = BATproject(s, res);
+		BBPunfix(res->batCacheid);
+		if (tres == NULL) {
+			BBPunfix(s->batCacheid);
+			throw(MAL, "sql.projectdelta", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		}
 	}
 	res = tres;
 
@@ -2372,9 +2418,8 @@ SQLtid(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 		if (ret != GDK_SUCCEED)
 			throw(MAL, "sql.tids", SQLSTATE(HY001) MAL_MALLOC_FAIL);
 
-		/* TODO handle dense o, ie full range out of the dense tids, could be at beginning or end (reduce range of tids) 
-		 * else materialize */
-		/* copy into heap */
+		/* copy into heap; deleted runs at the beginning or end
+		 * only reduce the range of tids */
 		ret = BATnegcands(tids, o);
 		BBPunfix(o->batCacheid);
 		if (ret != GDK_SUCCEED)
@@ -4566,6 +4611,67 @@ SQLvacuum(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	return MAL_SUCCEED;
 }
 
+/*
+ * The background vacuum of user tables (see idle_manager) keeps the
+ * status of its most recent runs, which is shown by sys.vacuum_status.
+ */
+str
+SQLvacuum_status(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *rtid = getArgReference_bat(stk, pci, 0);
+	bat *rstatus = getArgReference_bat(stk, pci, 1);
+	bat *rstarted = getArgReference_bat(stk, pci, 2);
+	bat *rfinished = getArgReference_bat(stk, pci, 3);
+	bat *rrows = getArgReference_bat(stk, pci, 4);
+	bat *rremoved = getArgReference_bat(stk, pci, 5);
+	BAT *tid, *status, *started, *finished, *rows, *removed;
+	vacuum_status vs[32];
+	timestamp ts;
+	int i, n;
+
+	(void) cntxt;
+	(void) mb;
+	n = store_vacuum_status(vs, (int) (sizeof(vs) / sizeof(vs[0])));
+	tid = COLnew(0, TYPE_int, n, TRANSIENT);
+	status = COLnew(0, TYPE_str, n, TRANSIENT);
+	started = COLnew(0, TYPE_timestamp, n, TRANSIENT);
+	finished = COLnew(0, TYPE_timestamp, n, TRANSIENT);
+	rows = COLnew(0, TYPE_lng, n, TRANSIENT);
+	removed = COLnew(0, TYPE_lng, n, TRANSIENT);
+	if (tid == NULL || status == NULL || started == NULL ||
+	    finished == NULL || rows == NULL || removed == NULL)
+		goto bailout;
+	for (i = 0; i < n; i++) {
+		if (BUNappend(tid, &vs[i].table_id, false) != GDK_SUCCEED ||
+		    BUNappend(status, vs[i].status, false) != GDK_SUCCEED)
+			goto bailout;
+		ts = timestamp_fromtime(vs[i].started);
+		if (BUNappend(started, &ts, false) != GDK_SUCCEED)
+			goto bailout;
+		ts = vs[i].finished ? timestamp_fromtime(vs[i].finished) : timestamp_nil;
+		if (BUNappend(finished, &ts, false) != GDK_SUCCEED ||
+		    BUNappend(rows, &vs[i].rows, false) != GDK_SUCCEED ||
+		    BUNappend(removed, &vs[i].removed, false) != GDK_SUCCEED)
+			goto bailout;
+	}
+	BBPkeepref(*rtid = tid->batCacheid);
+	BBPkeepref(*rstatus = status->batCacheid);
+	BBPkeepref(*rstarted = started->batCacheid);
+	BBPkeepref(*rfinished = finished->batCacheid);
+	BBPkeepref(*rrows = rows->batCacheid);
+	BBPkeepref(*rremoved = removed->batCacheid);
+	return MAL_SUCCEED;
+
+  bailout:
+	BBPreclaim(tid);
+	BBPreclaim(status);
+	BBPreclaim(started);
+	BBPreclaim(finished);
+	BBPreclaim(rows);
+	BBPreclaim(removed);
+	throw(SQL, "sql.vacuum_status", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+}
+
 /*
  * The drop_hash operation cleans up any hash indices on any of the tables columns.
  */
@@ -5275,7 +5381,19 @@ SQLhot_snapshot(void *ret, const str *tarfile_arg)
 {
 	(void)ret;
 	char *tarfile = *tarfile_arg;
-	lng result = store_hot_snapshot(tarfile);
+	lng result = store_hot_snapshot(tarfile, 0);
+	if (result)
+		return MAL_SUCCEED;
+	else
+		throw(SQL, "sql.hot_snapshot", GDK_EXCEPTION);
+}
+
+str
+SQLhot_snapshot_since(void *ret, const str *tarfile_arg, const lng *since)
+{
+	(void)ret;
+	char *tarfile = *tarfile_arg;
+	lng result = store_hot_snapshot(tarfile, is_lng_nil(*since) ? 0 : *since);
 	if (result)
 		return MAL_SUCCEED;
 	else
@@ -116,6 +116,7 @@ sql5_export str not_unique(bit *ret, const bat *bid);
 sql5_export str SQLshrink(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sql5_export str SQLreuse(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sql5_export str SQLvacuum(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+sql5_export str SQLvacuum_status(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sql5_export str SQLdrop_hash(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sql5_export str SQLargRecord(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 sql5_export str SQLoptimizersUpdate(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
@@ -311,5 +312,6 @@ sql5_export str SQLflush_log(void *ret);
 sql5_export str SQLsuspend_log_flushing(void *ret);
 sql5_export str SQLresume_log_flushing(void *ret);
 sql5_export str SQLhot_snapshot(void *ret, const str *tarfile);
+sql5_export str SQLhot_snapshot_since(void *ret, const str *tarfile, const lng *since);
 
 #endif /* _SQL_H */
@@ -2464,10 +2464,81 @@ sql_update_default(Client c, mvc *sql, const char *prev_schema)
 	return err;		/* usually MAL_SUCCEED */
 }
 
+static str
+sql_update_vacuum_status(Client c, mvc *sql, const char *prev_schema)
+{
+	size_t bufsize = 2048, pos = 0;
+	char *err = NULL, *buf = GDKmalloc(bufsize);
+
+	(void) sql;
+	if (buf == NULL)
+		throw(SQL, "sql_update_vacuum_status", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+
+	/* 20_vacuum */
+	pos += snprintf(buf + pos, bufsize - pos,
+			"set schema \"sys\";\n"
+			"create function vacuum_status()\n"
+			"returns table(\n"
+			"	table_id int,\n"
+			"	status string,\n"
+			"	started timestamp,\n"
+			"	finished timestamp,\n"
+			"	\"rows\" bigint,\n"
+			"	removed bigint\n"
+			")\n"
+			"external name sql.vacuum_status;\n"
+			"create view vacuum_status as\n"
+			"select s.name as \"schema\", t.name as \"table\", v.status, v.started, v.finished, v.\"rows\", v.removed\n"
+			"  from vacuum_status() v\n"
+			"  left join _tables t on v.table_id = t.id\n"
+			"  left join schemas s on t.schema_id = s.id;\n");
+	pos += snprintf(buf + pos, bufsize - pos,
+			"update sys.functions set system = true where schema_id = (select id from sys.schemas where name = 'sys')"
+			" and name = 'vacuum_status' and type = %d;\n", (int) F_UNION);
+	pos += snprintf(buf + pos, bufsize - pos,
+			"update sys._tables set system = true where schema_id = (select id from sys.schemas where name = 'sys')"
+			" and name = 'vacuum_status';\n");
+
+	pos += snprintf(buf + pos, bufsize - pos, "set schema \"%s\";\n", prev_schema);
+	assert(pos < bufsize);
+
+	printf("Running database upgrade commands:\n%s\n", buf);
+	err = SQLstatementIntern(c, &buf, "update", 1, 0, NULL);
+	GDKfree(buf);
+	return err;		/* usually MAL_SUCCEED */
+}
+
+static str
+sql_update_hot_snapshot_since(Client c, mvc *sql, const char *prev_schema)
+{
+	size_t bufsize = 1024, pos = 0;
+	char *err = NULL, *buf = GDKmalloc(bufsize);
+
+	(void) sql;
+	if (buf == NULL)
+		throw(SQL, "sql_update_hot_snapshot_since", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+
+	/* 58_hot_snapshot */
+	pos += snprintf(buf + pos, bufsize - pos,
+			"set schema \"sys\";\n"
+			"create procedure hot_snapshot(tarfile string, since bigint)\n"
+			" external name sql.hot_snapshot;\n"
+			"update sys.functions set system = true where schema_id = (select id from sys.schemas where name = 'sys')"
+			" and name = 'hot_snapshot' and type = %d;\n", (int) F_PROC);
+
+	pos += snprintf(buf + pos, bufsize - pos, "set schema \"%s\";\n", prev_schema);
+	assert(pos < bufsize);
+
+	printf("Running database upgrade commands:\n%s\n", buf);
+	err = SQLstatementIntern(c, &buf, "update", 1, 0, NULL);
+	GDKfree(buf);
+	return err;		/* usually MAL_SUCCEED */
+}
+
 int
 SQLupgrades(Client c, mvc *m)
 {
-	sql_subtype tp;
+	sql_subtype tp, tp2;
 	sql_subfunc *f;
 	char *err, *prev_schema = GDKstrdup(stack_get_string(m, "current_schema"));
 	sql_schema *s = mvc_bind_schema(m, "sys");
@@ -2744,6 +2815,24 @@ SQLupgrades(Client c, mvc *m)
 		}
 	}
 
+	if (!res && !sql_bind_func(m->sa, s, "vacuum_status", NULL, NULL, F_UNION)) {
+		if ((err = sql_update_vacuum_status(c, m, prev_schema)) != NULL) {
+			fprintf(stderr, "!%s\n", err);
+			freeException(err);
+			res = -1;
+		}
+	}
+
+	sql_find_subtype(&tp, "clob", 0, 0);
+	sql_find_subtype(&tp2, "bigint", 0, 0);
+	if (!res && !sql_bind_func(m->sa, s, "hot_snapshot", &tp, &tp2, F_PROC)) {
+		if ((err = sql_update_hot_snapshot_since(c, m, prev_schema)) != NULL) {
+			fprintf(stderr, "!%s\n", err);
+			freeException(err);
+			res = -1;
+		}
+	}
+
 	GDKfree(prev_schema);
 	return res;
 }
@@ -20,3 +20,22 @@ create procedure reuse(sys string, tab string)
 create procedure vacuum(sys string, tab string)
 	external name sql.vacuum;
 
+
+-- User tables with many deleted rows are vacuumed in the background;
+-- this shows the most recent of those vacuums.
+create function vacuum_status()
+returns table(
+	table_id int,
+	status string,	-- running, done, conflict or failed
+	started timestamp,
+	finished timestamp,
+	"rows" bigint,	-- rows before the vacuum
+	removed bigint	-- deleted rows removed
+)
+external name sql.vacuum_status;
+
+create view vacuum_status as
+select s.name as "schema", t.name as "table", v.status, v.started, v.finished, v."rows", v.removed
+  from vacuum_status() v
+  left join _tables t on v.table_id = t.id
+  left join schemas s on t.schema_id = s.id;
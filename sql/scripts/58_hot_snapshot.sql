@@ -10,3 +10,12 @@
 create procedure hot_snapshot(tarfile string)
 	external name sql.hot_snapshot;
 
+-- Incremental snapshot: leave out the BAT files that did not change since
+-- the snapshot with the given id.  The procedures do not return the id of
+-- a snapshot; it is on the first line ("id <n>") of the snapshot.manifest
+-- file in the tar file.  Extract an incremental snapshot over a copy of
+-- the database restored from the earlier snapshot, then remove the files
+-- not listed in its manifest.
+create procedure hot_snapshot(tarfile string, since bigint)
+	external name sql.hot_snapshot;
+
@@ -595,6 +595,14 @@ build up the hash (not copied in the trans dup)) */
 	if (chain)
 		sql_trans_begin(m->session);
 	store_unlock();
+	/* the commit is only done when it is on disk; syncing the log
+	 * outside the store lock lets concurrent commits share the
+	 * sync */
+	if (logger_funcs.log_tsync() != LOG_OK) {
+		char *err = sql_message(SQLSTATE(40000) "%s transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", operation, GDKerrbuf);
+		GDKfatal("%s", err);
+		_DELETE(err);
+	}
 	m->type = Q_TRANS;
 	if (mvc_debug)
 		fprintf(stderr, "#mvc_commit done\n");
@@ -704,6 +712,8 @@ mvc_release(mvc *m, const char *name)
 	}
 	tr = m->session->tr;
 	store_lock();
+	/* these commit into the savepoint being released, not into
+	 * gtrans, so nothing is logged and there is no log to sync */
 	while (ok == SQL_OK && (!tr->name || strcmp(tr->name, name) != 0)) {
 		/* commit all intermediate savepoints */
 		if (sql_trans_commit(tr) != SQL_OK)
@@ -748,8 +748,12 @@ bl_create(int debug, const char *logdir, int cat_version)
 	if (bat_logger)
 		return LOG_ERR;
 	bat_logger = logger_create(debug, "sql", logdir, cat_version, bl_preversion, bl_postversion);
-	if (bat_logger)
+	if (bat_logger) {
+		/* commits sync the log after releasing the store lock
+		 * (see mvc_commit) */
+		logger_group_commit(bat_logger, GDKgetenv_int("sql_commit_delay", 0));
 		return LOG_OK;
+	}
 	return LOG_ERR;
 }
 
@@ -765,6 +769,9 @@ bl_destroy(void)
 		GDKfree(l->dir);
 		GDKfree(l->local_dir);
 		GDKfree(l->buf);
+		ATOMIC_DESTROY(&l->flushed);
+		ATOMIC_DESTROY(&l->synced);
+		MT_lock_destroy(&l->synclock);
 		GDKfree(l);
 	}
 }
@@ -831,6 +838,12 @@ bl_tend(void)
 	return log_tend(bat_logger) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
 }
 
+static int 
+bl_tsync(void)
+{
+	return log_tsync(bat_logger) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
 static int 
 bl_sequence(int seq, lng id)
 {
@@ -972,6 +985,17 @@ snapshot_wal(stream *plan, const char *db_dir)
 	return GDK_SUCCEED;
 }
 
+/* The heap of a read-only BAT may be saved as a compressed segment
+ * (see BATcompress), which is smaller than the heap it holds.  Such a
+ * file is copied whole. */
+static uint64_t
+snapshot_extent(const struct stat *statbuf, uint64_t extent)
+{
+	if ((uint64_t) statbuf->st_size < extent)
+		return (uint64_t) statbuf->st_size;
+	return extent;
+}
+
 static gdk_return
 snapshot_heap(stream *plan, const char *db_dir, uint64_t batid, const char *filename, const char *suffix, uint64_t extent)
 {
@@ -983,7 +1007,7 @@ snapshot_heap(stream *plan, const char *db_dir, uint64_t batid, const char *file
 	// first check the backup dir
 	snprintf(path1, FILENAME_MAX, "%s/%s/%" PRIo64 "%s", db_dir, BAKDIR, batid, suffix);
 	if (stat(path1, &statbuf) == 0) {
-		snapshot_lazy_copy_file(plan, path1 + offset, extent);
+		snapshot_lazy_copy_file(plan, path1 + offset, snapshot_extent(&statbuf, extent));
 		return GDK_SUCCEED;
 	}
 	if (errno != ENOENT) {
@@ -994,7 +1018,7 @@ snapshot_heap(stream *plan, const char *db_dir, uint64_t batid, const char *file
 	// then check the regular location
 	snprintf(path2, FILENAME_MAX, "%s/%s/%s%s", db_dir, BATDIR, filename, suffix);
 	if (stat(path2, &statbuf) == 0) {
-		snapshot_lazy_copy_file(plan, path2 + offset, extent);
+		snapshot_lazy_copy_file(plan, path2 + offset, snapshot_extent(&statbuf, extent));
 		return GDK_SUCCEED;
 	}
 	if (errno != ENOENT) {
@@ -1191,6 +1215,7 @@ bat_logger_init( logger_functions *lf )
 	lf->log_needs_update = bl_log_needs_update;
 	lf->log_tstart = bl_tstart;
 	lf->log_tend = bl_tend;
+	lf->log_tsync = bl_tsync;
 	lf->log_sequence = bl_sequence;
 	lf->log_find_table_value = bl_find_table_value;
 	lf->get_snapshot_files = bl_snapshot;
@@ -244,6 +244,81 @@ bind_idx(sql_trans *tr, sql_idx * i, int access)
 	return delta_bind_bat( i->data, access, isTemp(i));
 }
 
+/* Once the update bats have grown to at least twice their size after
+ * the previous compaction, sort them on row id and keep only the last
+ * update of each row.  This keeps repeated updates of the same rows
+ * from piling up in the deltas and hands readers and the merge at
+ * commit a sorted, duplicate free set of updates. */
+#define UPD_COMPACT_MIN 1024
+
+static int
+delta_compact_updates(sql_delta *bat)
+{
+	BAT *ui, *uv, *sui = NULL, *ord = NULL, *keep = NULL, *pos = NULL, *nui = NULL, *nuv = NULL;
+	log_bid nuibid, nuvbid;
+	BUN cnt, i, k;
+	oid *kp;
+	int res = LOG_ERR;
+
+	ui = temp_descriptor(bat->uibid);
+	uv = temp_descriptor(bat->uvbid);
+	if (ui == NULL || uv == NULL) {
+		bat_destroy(ui);
+		bat_destroy(uv);
+		return LOG_ERR;
+	}
+	cnt = BATcount(ui);
+	if (cnt < UPD_COMPACT_MIN || cnt < 2 * bat->ucompact ||
+	    (BATtordered(ui) && BATtkey(ui))) {
+		bat_destroy(ui);
+		bat_destroy(uv);
+		return LOG_OK;
+	}
+	/* stable, so duplicates stay in the order they were applied */
+	if (BATsort(&sui, &ord, NULL, ui, NULL, NULL, false, false, true) != GDK_SUCCEED)
+		goto bailout;
+	if ((keep = COLnew(0, TYPE_oid, cnt, TRANSIENT)) == NULL)
+		goto bailout;
+	kp = (oid *) Tloc(keep, 0);
+	for (i = 0, k = 0; i < cnt; i++) {
+		if (i + 1 == cnt || BUNtoid(sui, i) != BUNtoid(sui, i + 1))
+			kp[k++] = i;
+	}
+	BATsetcount(keep, k);
+	keep->tsorted = true;
+	keep->trevsorted = k <= 1;
+	keep->tkey = true;
+	keep->tnonil = true;
+	keep->tnil = false;
+	if ((nui = BATproject(keep, sui)) == NULL ||
+	    (pos = BATproject(keep, ord)) == NULL ||
+	    (nuv = BATproject(pos, uv)) == NULL)
+		goto bailout;
+	BATkey(nui, true);
+	if ((nuibid = temp_copy(nui->batCacheid, false)) == BID_NIL)
+		goto bailout;
+	if ((nuvbid = temp_copy(nuv->batCacheid, false)) == BID_NIL) {
+		temp_destroy(nuibid);
+		goto bailout;
+	}
+	temp_destroy(bat->uibid);
+	temp_destroy(bat->uvbid);
+	bat->uibid = nuibid;
+	bat->uvbid = nuvbid;
+	bat->ucompact = BATcount(nui);
+	res = LOG_OK;
+  bailout:
+	bat_destroy(ui);
+	bat_destroy(uv);
+	bat_destroy(sui);
+	bat_destroy(ord);
+	bat_destroy(keep);
+	bat_destroy(pos);
+	bat_destroy(nui);
+	bat_destroy(nuv);
+	return res;
+}
+
 static int
 delta_update_bat( sql_delta *bat, BAT *tids, BAT *updates, int is_new) 
 {
@@ -336,6 +411,8 @@ delta_update_bat( sql_delta *bat, BAT *tids, BAT *updates, int is_new)
 		bat_destroy(o);
 		bat_destroy(ui);
 		bat_destroy(uv);
+		if (delta_compact_updates(bat) != LOG_OK)
+			return LOG_ERR;
 	} else if (is_new && bat->bid) { 
 		BAT *ib = temp_descriptor(bat->ibid);
 		b = temp_descriptor(bat->bid);
@@ -490,6 +567,10 @@ delta_update_val( sql_delta *bat, oid rid, void *upd)
 			bat->ucnt++;
 			bat_destroy(ui);
 			bat_destroy(uv);
+			if (delta_compact_updates(bat) != LOG_OK) {
+				bat_destroy(ib);
+				return LOG_ERR;
+			}
 		}
 		bat_destroy(ib);
 	} else {
@@ -516,6 +597,7 @@ dup_delta(sql_trans *tr, sql_delta *obat, sql_delta *bat, int type, int oc_isnew
 	bat->ibase = obat->ibase;
 	bat->cnt = obat->cnt;
 	bat->ucnt = obat->ucnt;
+	bat->ucompact = obat->ucompact;
 	bat->wtime = obat->wtime;
 	bat->cleared = obat->cleared;
 
@@ -1283,6 +1365,7 @@ load_delta(sql_delta *bat, int bid, int type)
 	bat->ibase = BATcount(b);
 	bat->cnt = bat->ibase; 
 	bat->ucnt = 0; 
+	bat->ucompact = 0;
 	bat->uibid = e_bat(TYPE_oid);
 	bat->uvbid = e_bat(type);
 	bat->ibid = e_bat(type);
@@ -1365,6 +1448,7 @@ new_persistent_delta( sql_delta *bat, int sz )
 		bat->ibase = BATcount(b);
 		bat->cnt = BATcount(b) + BATcount(i);
 		bat->ucnt = 0;
+		bat->ucompact = 0;
 		bat->ibid = temp_copy(i->batCacheid, FALSE);
 		bat_destroy(i);
 		bat_destroy(b);
@@ -1386,6 +1470,7 @@ new_persistent_delta( sql_delta *bat, int sz )
 		bat->bid = bat->ibid;
 		bat->cnt = bat->ibase = BATcount(b);
 		bat->ucnt = 0;
+		bat->ucompact = 0;
 		bat_destroy(b);
 
 		i = COLnew(bat->ibase, type, sz, PERSISTENT);
@@ -1420,6 +1505,7 @@ create_delta( sql_delta *d, BAT *b, BAT *i)
 	}
 	d->uibid = d->uvbid = 0;
 	d->ucnt = 0;
+	d->ucompact = 0;
 }
 
 static int
@@ -1603,6 +1689,7 @@ create_idx(sql_trans *tr, sql_idx *ni)
 		bat->ibase = d->ibase;
 		bat->cnt = d->cnt;
 		bat->ucnt = 0;
+		bat->ucompact = 0;
 
 		if (d->uibid) {
 			bat->uibid = e_bat(TYPE_oid);
@@ -2030,6 +2117,7 @@ clear_delta(sql_trans *tr, sql_delta *bat)
 	bat->ibase = 0;
 	bat->cnt = 0;
 	bat->ucnt = 0;
+	bat->ucompact = 0;
 	bat->wtime = tr->wstime;
 	return sz;
 }
@@ -2184,6 +2272,7 @@ gtr_update_delta( sql_trans *tr, sql_delta *cbat, int *changes, int id, int tpe)
 			if(cbat->uibid == BID_NIL || cbat->uvbid == BID_NIL)
 				ok = LOG_ERR;
 			cbat->ucnt = 0;
+			cbat->ucompact = 0;
 		}
 		bat_destroy(ui);
 		bat_destroy(uv);
@@ -2432,7 +2521,10 @@ tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
 	}
 	/* any inserts */
 	if (BUNlast(ins) > 0 || cbat->cleared) {
-		if ((!obat->ibase && BATcount(ins) > SNAPSHOT_MINSIZE)){
+		/* this must match the condition under which tr_log_delta
+		 * logged ins as the new snapshot; note that cbat->ibase
+		 * is reset by clearing the table, obat->ibase is not */
+		if ((!cbat->ibase && BATcount(ins) > SNAPSHOT_MINSIZE)){
 			/* swap cur and ins */
 			BAT *newcur = ins;
 
@@ -2503,6 +2595,7 @@ tr_update_delta( sql_trans *tr, sql_delta *obat, sql_delta *cbat, int unique)
 			temp_destroy(cbat->uvbid);
 			cbat->uibid = cbat->uvbid = 0;
 			cbat->ucnt = obat->ucnt = 0;
+			cbat->ucompact = obat->ucompact = 0;
 		}
 		bat_destroy(ui);
 		bat_destroy(uv);
@@ -2599,6 +2692,7 @@ tr_merge_delta( sql_trans *tr, sql_delta *obat, int unique)
 			if(obat->uibid == BID_NIL || obat->uvbid == BID_NIL)
 				ok = LOG_ERR;
 			obat->ucnt = 0;
+			obat->ucompact = 0;
 		}
 		bat_destroy(ui);
 		bat_destroy(uv);
@@ -2689,6 +2783,23 @@ tr_merge_dbat(sql_trans *tr, sql_dbat *tdb)
 	return ok;
 }
 
+/* mark the main bat of a column or index to be saved compressed (see
+ * BATcompress); the segments are written at the next checkpoint */
+static int
+compress_delta(sql_delta *d, bool compress)
+{
+	BAT *b;
+	gdk_return ret;
+
+	if (d == NULL || !d->bid)
+		return LOG_OK;
+	if ((b = temp_descriptor(d->bid)) == NULL)
+		return LOG_ERR;
+	ret = BATcompress(b, compress);
+	bat_destroy(b);
+	return ret == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
 static int
 update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 {
@@ -2884,6 +2995,23 @@ update_table(sql_trans *tr, sql_table *ft, sql_table *tt)
 			ci->base.allocated = 0;
 		}
 	}
+	/* read only tables are cold: store their columns compressed */
+	if (ok == LOG_OK && ft->access != tt->access &&
+	    tr->parent == gtrans && isTable(tt) &&
+	    tt->persistence == SQL_PERSIST) {
+		bool compress = ft->access == TABLE_READONLY;
+
+		for (n = tt->columns.set->h; ok == LOG_OK && n; n = n->next) {
+			sql_column *c = n->data;
+			ok = compress_delta(c->data, compress);
+		}
+		if (tt->idxs.set) {
+			for (n = tt->idxs.set->h; ok == LOG_OK && n; n = n->next) {
+				sql_idx *i = n->data;
+				ok = compress_delta(i->data, compress);
+			}
+		}
+	}
 	if (tt->base.rtime < ft->base.rtime)
 		tt->base.rtime = ft->base.rtime;
 	if (tt->base.wtime < ft->base.wtime)
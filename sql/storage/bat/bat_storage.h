@@ -22,6 +22,7 @@ typedef struct sql_delta {
 	int cleared;
 	size_t cnt;		/* number of tuples (excluding the deletes) */
 	size_t ucnt;		/* number of updates */
+	size_t ucompact;	/* size of the update bats after their last compaction */
 	BAT *cached;		/* cached copy, used for schema bats only */
 	int wtime;		/* time stamp */
 	struct sql_delta *next;	/* possibly older version of the same column/idx */
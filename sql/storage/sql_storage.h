@@ -314,6 +314,7 @@ typedef int (*log_isnew_fptr)(void);
 typedef bool (*log_needs_update_fptr)(void);
 typedef int (*log_tstart_fptr) (void);
 typedef int (*log_tend_fptr) (void);
+typedef int (*log_tsync_fptr) (void);
 typedef int (*log_sequence_fptr) (int seq, lng id);
 
 /*
@@ -350,6 +351,7 @@ typedef struct logger_functions {
 	log_needs_update_fptr log_needs_update;
 	log_tstart_fptr log_tstart;
 	log_tend_fptr log_tend;
+	log_tsync_fptr log_tsync;
 	log_sequence_fptr log_sequence;
 	log_find_table_value_fptr log_find_table_value;
 } logger_functions;
@@ -374,11 +376,22 @@ extern int store_apply_deltas(bool locked);
 extern void store_flush_log(void);
 extern void store_suspend_log(void);
 extern void store_resume_log(void);
-extern lng store_hot_snapshot(str tarfile);
+extern lng store_hot_snapshot(str tarfile, lng since);
 
 extern void store_manager(void);
 extern void idle_manager(void);
 
+typedef struct vacuum_status {
+	sqlid table_id;
+	const char *status;	/* running, done, conflict or failed */
+	time_t started;
+	time_t finished;	/* 0 while running */
+	lng rows;		/* number of rows before the vacuum */
+	lng removed;		/* number of deleted rows removed */
+} vacuum_status;
+
+extern int store_vacuum_status(vacuum_status *vs, int n);
+
 extern void store_lock(void);
 extern void store_unlock(void);
 extern int store_next_oid(void);
@@ -1954,7 +1954,8 @@ store_load(void) {
 		insert_aggrs(tr, funcs, args);
 		insert_schemas(tr);
 
-		if (sql_trans_commit(tr) != SQL_OK) {
+		if (sql_trans_commit(tr) != SQL_OK ||
+		    logger_funcs.log_tsync() != LOG_OK) {
 			fprintf(stderr, "cannot commit initial transaction\n");
 		}
 		sql_trans_destroy(tr, true);
@@ -2071,6 +2072,160 @@ store_vacuum( sql_trans *tr )
 	return 0;
 }
 
+/* Besides the system tables, the idle manager also vacuums user tables
+ * once enough of their rows have been deleted.  User tables can be
+ * large, so this runs as an ordinary transaction: the columns are
+ * rewritten without the deleted rows while the store lock is not held,
+ * and the result is swapped in atomically by the commit (and saved at
+ * the next checkpoint).  If another transaction changed the table in
+ * the meantime, the vacuum fails validation and is retried later.  To
+ * limit the I/O, at most one table is vacuumed at a time, after which
+ * the idle manager waits in proportion to the number of rows that were
+ * rewritten.  Tables with keys or indices are skipped, just like by
+ * sys.vacuum. */
+#define VACUUM_MIN_DELETES	1024
+#define VACUUM_MIN_PERCENT	10
+#define VACUUM_ROWS_PER_SEC	1000000
+#define VACUUM_HISTORY		32
+
+static MT_Lock vacuum_lock = MT_LOCK_INITIALIZER("vacuum_lock");
+static vacuum_status vacuum_history[VACUUM_HISTORY];
+static int vacuum_nr = 0;
+
+/* copy the status of the (at most n) most recent user table vacuums,
+ * latest first */
+int
+store_vacuum_status(vacuum_status *vs, int n)
+{
+	int i;
+
+	MT_lock_set(&vacuum_lock);
+	if (n > vacuum_nr)
+		n = vacuum_nr;
+	if (n > VACUUM_HISTORY)
+		n = VACUUM_HISTORY;
+	for (i = 0; i < n; i++)
+		vs[i] = vacuum_history[(vacuum_nr - 1 - i) % VACUUM_HISTORY];
+	MT_lock_unset(&vacuum_lock);
+	return n;
+}
+
+static bool
+store_vacuum_candidate(sql_trans *tr, sql_table *t, size_t *rows, size_t *dels)
+{
+	sql_column *c;
+
+	if (t->system || !isTable(t) || t->persistence != SQL_PERSIST ||
+	    t->commit_action || t->access != TABLE_WRITABLE ||
+	    !list_empty(t->idxs.set) || !list_empty(t->keys.set) ||
+	    !t->columns.set || !t->columns.set->h)
+		return false;
+	c = t->columns.set->h->data;
+	/* the committed state has no parent to take missing deltas from */
+	if (!tr->parent && (!t->data || !c->data))
+		return false;
+	/* no inserts, updates and enough deletes ? */
+	if (store_funcs.count_col(tr, c, 0) != 0 ||
+	    store_funcs.count_upd(tr, t) != 0)
+		return false;
+	*dels = store_funcs.count_del(tr, t);
+	*rows = store_funcs.count_col(tr, c, 1);
+	return *dels >= VACUUM_MIN_DELETES &&
+		*dels * 100 >= *rows * VACUUM_MIN_PERCENT;
+}
+
+/* vacuum the user table with the most deleted rows, returns the number
+ * of rows that were rewritten */
+static size_t
+store_vacuum_user_table(void)
+{
+	sql_session *s;
+	sql_schema *vs_schema = NULL;
+	sql_table *vt = NULL;
+	size_t rows, dels, vrows = 0, vdels = 0;
+	vacuum_status *vs;
+	const char *status;
+	node *n, *m;
+	int ok;
+
+	MT_lock_set(&bs_lock);
+	if (store_readonly || ATOMIC_GET(&store_nr_active) || GDKexiting()) {
+		MT_lock_unset(&bs_lock);
+		return 0;
+	}
+	/* look for a candidate in the committed state first, so that a
+	 * session (a copy of the catalog) is only created when there is
+	 * something to vacuum */
+	for (n = gtrans->schemas.set->h; n; n = n->next) {
+		sql_schema *sc = n->data;
+
+		if (isTempSchema(sc) || !sc->tables.set)
+			continue;
+		for (m = sc->tables.set->h; m; m = m->next) {
+			sql_table *t = m->data;
+
+			if (store_vacuum_candidate(gtrans, t, &rows, &dels) &&
+			    dels > vdels) {
+				vs_schema = sc;
+				vt = t;
+				vdels = dels;
+			}
+		}
+	}
+	if (vt == NULL ||
+	    (s = sql_session_create(gtrans->stk, 0)) == NULL) {
+		MT_lock_unset(&bs_lock);
+		return 0;
+	}
+	sql_trans_begin(s);
+	if ((vs_schema = find_sql_schema_id(s->tr, vs_schema->base.id)) == NULL ||
+	    (vt = find_sql_table_id(vs_schema, vt->base.id)) == NULL ||
+	    !store_vacuum_candidate(s->tr, vt, &vrows, &vdels)) {
+		sql_trans_end(s);
+		sql_session_destroy(s);
+		MT_lock_unset(&bs_lock);
+		return 0;
+	}
+	MT_lock_set(&vacuum_lock);
+	vs = &vacuum_history[vacuum_nr++ % VACUUM_HISTORY];
+	*vs = (vacuum_status) {
+		.table_id = vt->base.id,
+		.status = "running",
+		.started = time(NULL),
+		.rows = (lng) vrows,
+		.removed = (lng) vdels,
+	};
+	MT_lock_unset(&vacuum_lock);
+	MT_lock_unset(&bs_lock);
+
+	MT_thread_setworking("vacuuming");
+	ok = table_funcs.table_vacuum(s->tr, vt);
+
+	MT_lock_set(&bs_lock);
+	if (ok != SQL_OK)
+		status = "failed";
+	else if (!sql_trans_validate(s->tr))
+		status = "conflict";
+	else if (sql_trans_commit(s->tr) != SQL_OK)
+		status = "failed";
+	else
+		status = "done";
+	sql_trans_end(s);
+	sql_session_destroy(s);
+	MT_lock_unset(&bs_lock);
+	/* as in mvc_commit, the vacuum is only done when its commit is
+	 * on disk; sync the log outside the store lock */
+	if (strcmp(status, "done") == 0 && logger_funcs.log_tsync() != LOG_OK)
+		GDKfatal("vacuum commit failed (perhaps your disk is full?) exiting (kernel error: %s)", GDKerrbuf);
+	MT_thread_setworking("sleeping");
+
+	MT_lock_set(&vacuum_lock);
+	vs->status = status;
+	vs->finished = time(NULL);
+	MT_lock_unset(&vacuum_lock);
+	return vrows;
+}
+
 // All this must only be accessed while holding the bs_lock.
 // The exception is flush_now, which can be set by anyone at any
 // time and therefore needs some special treatment.
@@ -2078,9 +2233,12 @@ static struct {
 	// These two are inputs, set from outside the store_manager
 	bool enabled;
 	ATOMIC_TYPE flush_now;
+	// Number of hot snapshots copying files, set by store_hot_snapshot
+	int snapshots;
 	// These are state set from within the store_manager
 	bool working;
 	int countdown_ms;
+	int changes;
 	unsigned int cycle;
 	char *reason_to;
 	char *reason_not_to;
@@ -2123,7 +2281,7 @@ flusher_should_run(void)
 		reason_to = "timer expired";
 
 	int many_changes = GDKdebug & FORCEMITOMASK ? 100 : 1000000;
-	if ((changes = logger_funcs.changes()) >= many_changes)
+	if ((changes = flusher.changes = logger_funcs.changes()) >= many_changes)
 		reason_to = "many changes";
 	else if (changes == 0)
 		reason_not_to = "no changes";
@@ -2139,6 +2297,9 @@ flusher_should_run(void)
 	if (ATOMIC_GET(&store_nr_active) > 0)
 		reason_not_to = "awaiting idle time";
 
+	if (flusher.snapshots > 0)
+		reason_not_to = "hot snapshot in progress";
+
 	if (!flusher.enabled && !my_flush_now)
 		reason_not_to = "disabled";
 
@@ -2205,6 +2366,17 @@ store_exit(void)
 }
 
 
+/* Merge the deltas of the global transaction into the main BATs.
+ * Call locked, without active transactions! */
+static void
+store_merge_deltas(void)
+{
+	/* make sure we reset all transactions on re-activation */
+	gtrans->wstime = timestamp();
+	if (store_funcs.gtrans_update)
+		store_funcs.gtrans_update(gtrans);
+}
+
 /* call locked! */
 int
 store_apply_deltas(bool not_locked)
@@ -2212,10 +2384,7 @@ store_apply_deltas(bool not_locked)
 	int res = LOG_OK;
 
 	flusher.working = true;
-	/* make sure we reset all transactions on re-activation */
-	gtrans->wstime = timestamp();
-	if (store_funcs.gtrans_update)
-		store_funcs.gtrans_update(gtrans);
+	store_merge_deltas();
 	res = logger_funcs.restart();
 	if (res == LOG_OK) {
 		if (!not_locked)
@@ -2263,9 +2432,30 @@ store_resume_log(void)
 	MT_lock_unset(&bs_lock);
 }
 
+/* Between checkpoints, whenever the store is idle, the deltas are
+ * merged into the main BATs ahead of time (crash recovery does not
+ * depend on when that happens, since the main BATs are only saved by
+ * the checkpoint and the log is replayed on top of what was saved).
+ * The modified pages of the main BATs are then written back a slice
+ * at a time without holding bs_lock (see BBPwriteback), so that the
+ * checkpoint itself has little left to merge and write.  The slices
+ * grow with the rate at which the write-ahead log grows.  Under a
+ * heavy update load the deltas are merged as soon as enough changes
+ * have accumulated, rather than waiting for the interval to pass. */
+#define MERGE_INTERVAL_MS	2000
+#define MERGE_CHANGES		100000
+#define WRITEBACK_MIN		((size_t) 4 << 20) /* per sleep */
+#define WRITEBACK_MAX		((size_t) 64 << 20)
+#define WRITEBACK_PER_CHANGE	64
+
 void
 store_manager(void)
 {
+	bat wb_bat = 0;
+	size_t wb_offset = 0;
+	int wb_changes = 0, merged_changes = 0;
+	int merge_ms = MERGE_INTERVAL_MS;
+
 	MT_thread_setworking("sleeping");
 
 	// In the main loop we always hold the lock except when sleeping
@@ -2276,9 +2466,32 @@ store_manager(void)
 
 		if (!flusher_should_run()) {
 			const int sleeptime = 100;
+			size_t wbsize = 0;
+
+			if (flusher.enabled && flusher.changes > 0) {
+				if ((merge_ms <= 0 ||
+				     flusher.changes - merged_changes >= MERGE_CHANGES) &&
+				    flusher.changes != merged_changes &&
+				    flusher.snapshots == 0 &&
+				    ATOMIC_GET(&store_nr_active) == 0) {
+					MT_thread_setworking("merging");
+					store_merge_deltas();
+					MT_thread_setworking("sleeping");
+					merged_changes = flusher.changes;
+					merge_ms = MERGE_INTERVAL_MS;
+				}
+				wbsize = WRITEBACK_MIN;
+				if (flusher.changes > wb_changes)
+					wbsize += (size_t) (flusher.changes - wb_changes) * WRITEBACK_PER_CHANGE;
+				wbsize = MIN(wbsize, WRITEBACK_MAX);
+				wb_changes = flusher.changes;
+			}
 			MT_lock_unset(&bs_lock);
+			if (wbsize > 0)
+				(void) BBPwriteback(&wb_bat, &wb_offset, wbsize);
 			MT_sleep_ms(sleeptime);
 			flusher.countdown_ms -= sleeptime;
+			merge_ms -= sleeptime;
 			MT_lock_set(&bs_lock);
 			continue;
 		}
@@ -2292,6 +2505,8 @@ store_manager(void)
 		}
 
 		flusher_new_cycle();
+		wb_changes = merged_changes = 0;
+		merge_ms = MERGE_INTERVAL_MS;
 		MT_thread_setworking("sleeping");
 #ifdef STORE_FLUSHER_DEBUG
 		fprintf(stderr, "#store flusher done\n");
@@ -2307,11 +2522,12 @@ idle_manager(void)
 {
 	const int sleeptime = GDKdebug & FORCEMITOMASK ? 10 : 50;
 	const int timeout = GDKdebug & FORCEMITOMASK ? 50 : 5000;
+	lng vacuum_pause = 0;
 
 	MT_thread_setworking("sleeping");
 	while (!GDKexiting()) {
 		sql_session *s;
-		int t;
+		int t, ok;
 
 		for (t = timeout; t > 0; t -= sleeptime) {
 			MT_sleep_ms(sleeptime);
@@ -2320,6 +2536,9 @@ idle_manager(void)
 		}
 		/* cleanup any collected intermediate storage */
 		store_funcs.cleanup();
+		vacuum_pause -= timeout;
+		if (vacuum_pause <= 0)
+			vacuum_pause = (lng) store_vacuum_user_table() * 1000 / VACUUM_ROWS_PER_SEC;
 		MT_lock_set(&bs_lock);
 		if (ATOMIC_GET(&store_nr_active) || GDKexiting() || !store_needs_vacuum(gtrans)) {
 			MT_lock_unset(&bs_lock);
@@ -2333,12 +2552,15 @@ idle_manager(void)
 		}
 		MT_thread_setworking("vacuuming");
 		sql_trans_begin(s);
-		if (store_vacuum( s->tr ) == 0)
-			sql_trans_commit(s->tr);
+		ok = store_vacuum( s->tr ) == 0 &&
+			sql_trans_commit(s->tr) == SQL_OK;
 		sql_trans_end(s);
 		sql_session_destroy(s);
 
 		MT_lock_unset(&bs_lock);
+		/* as in mvc_commit, sync the log outside the store lock */
+		if (ok && logger_funcs.log_tsync() != LOG_OK)
+			GDKfatal("vacuum commit failed (perhaps your disk is full?) exiting (kernel error: %s)", GDKerrbuf);
 		MT_thread_setworking("sleeping");
 	}
 }
@@ -2475,123 +2697,298 @@ tar_write_data(stream *tarfile, const char *path, time_t mtime, const char *data
 	return tar_write(tarfile, data, size);
 }
 
-static gdk_return
-tar_copy_stream(stream *tarfile, const char *path, time_t mtime, stream *contents, ssize_t size)
-{
-	const ssize_t bufsize = 64 * 1024;
-	gdk_return ret = GDK_FAIL;
-	ssize_t file_size;
-	char *buf = NULL;
-	ssize_t to_read;
-
-	file_size = getFileSize(contents);
-	if (file_size < size) {
-		GDKerror("Have to copy %zd bytes but only %zd exist in %s", size, file_size, path);
-		goto end;
-	}
-
-	assert( (bufsize % TAR_BLOCK_SIZE) == 0);
-	assert(bufsize >= TAR_BLOCK_SIZE);
+/* The files of a snapshot are read by several threads at once, a chunk
+ * at a time, while the tar stream is written in order by the caller.
+ * Chunk j is read by reader j % nreaders into slot j % nslots.  The
+ * number of slots is a multiple of the number of readers, so each slot
+ * is only ever used by one reader, and the readers are at most nslots
+ * chunks ahead of the writer.
+ */
+#define SNAPSHOT_CHUNK		((size_t) 1 << 20)
+#define SNAPSHOT_READERS	4
+#define SNAPSHOT_SLOTS		4	/* per reader */
+
+struct snapshot_entry {
+	char command;		/* 'c': copy from file, 'w': data in plan */
+	bool skip;		/* file unchanged since the base snapshot */
+	size_t size;
+	size_t first;		/* first chunk of a file to copy */
+	char *name;		/* relative to the database directory */
+	const char *data;	/* contents of a 'w' entry */
+};
 
-	buf = malloc(bufsize);
-	if (!buf) {
-		GDKerror("could not allocate buffer");
-		goto end;
-	}
+struct snapshot_slot {
+	MT_Sema full, empty;
+	ssize_t len;		/* bytes read, -1 on error */
+	int err;		/* errno of a failed read */
+	char *buf;
+};
 
-	if (tar_write_header(tarfile, path, mtime, size) != GDK_SUCCEED)
-		goto end;
+struct snapshot_copy {
+	const char *dir;
+	struct snapshot_entry *entries;
+	int nentries;
+	size_t nchunks;
+	int nreaders, nslots;
+	ATOMIC_TYPE abort;
+	struct snapshot_slot slots[SNAPSHOT_READERS * SNAPSHOT_SLOTS];
+};
 
-	to_read = size;
+struct snapshot_reader {
+	struct snapshot_copy *c;
+	int nr;
+	MT_Id tid;
+};
 
-	while (to_read > 0) {
-		ssize_t chunk = (to_read <= bufsize) ? to_read : bufsize;
-		ssize_t nbytes = mnstr_read(contents, buf, 1, chunk);
-		if (nbytes != chunk) {
-			GDKerror("Read only %zd/%zd bytes of component %s: %s", nbytes, chunk, path, mnstr_error(contents));
-			goto end;
+static void
+snapshot_read_chunks(void *arg)
+{
+	struct snapshot_reader *r = arg;
+	struct snapshot_copy *c = r->c;
+	char path[2 * FILENAME_MAX];
+	int fd = -1, e = 0, cur = -1;
+
+	for (size_t j = r->nr; j < c->nchunks; j += c->nreaders) {
+		struct snapshot_slot *s = &c->slots[j % c->nslots];
+		struct snapshot_entry *f;
+		size_t off, len, got = 0;
+
+		MT_sema_down(&s->empty);
+		if (ATOMIC_GET(&c->abort))
+			break;
+		// the chunks of a reader are increasing, and so are the files
+		for (;;) {
+			f = &c->entries[e];
+			if (f->command == 'c' && !f->skip &&
+			    j < f->first + (f->size + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK)
+				break;
+			e++;
+		}
+		if (e != cur) {
+			if (fd >= 0)
+				close(fd);
+			snprintf(path, sizeof(path), "%s%c%s", c->dir, DIR_SEP, f->name);
+			fd = open(path, O_RDONLY);
+			cur = e;
+		}
+		off = (j - f->first) * SNAPSHOT_CHUNK;
+		len = MIN(SNAPSHOT_CHUNK, f->size - off);
+		s->len = -1;
+		s->err = 0;
+		if (fd >= 0 && lseek(fd, (off_t) off, SEEK_SET) == (off_t) off) {
+			while (got < len) {
+				ssize_t n = read(fd, s->buf + got, len - got);
+				if (n <= 0) {
+					s->err = n < 0 ? errno : 0;
+					break;
+				}
+				got += (size_t) n;
+			}
+			s->len = (ssize_t) got;
+		} else {
+			s->err = errno;
 		}
-		ret = tar_write(tarfile, buf, chunk);
-		if (ret != GDK_SUCCEED)
-			goto end;
-		to_read -= chunk;
+		MT_sema_up(&s->full);
 	}
-
-	ret = GDK_SUCCEED;
-end:
-	if (buf)
-		free(buf);
-	return ret;
+	if (fd >= 0)
+		close(fd);
 }
 
+/* Write the tar file described by the plan.  With since > 0, files to
+ * be copied whose modification and status change times both lie before
+ * since are left out; they must then be taken from the earlier snapshot
+ * the tar file is applied to.  A manifest with the snapshot id and the
+ * names of all files that make up the snapshot, including the ones left
+ * out, is written last.
+ */
 static gdk_return
-hot_snapshot_write_tar(stream *out, const char *prefix, char *plan)
+hot_snapshot_write_tar(stream *out, const char *prefix, char *plan, lng id, lng since)
 {
 	gdk_return ret = GDK_FAIL;
 	const char *p = plan; // our cursor in the plan
-	time_t timestamp = time(NULL);
-	// Name convention: _path for the absolute path
-	// and _name for the corresponding local relative path
+	time_t timestamp = (time_t) id;
+	char db_dir[FILENAME_MAX];
 	char abs_src_path[2 * FILENAME_MAX];
-	char *src_name = abs_src_path;
+	char src_name[101];
 	char dest_path[100]; // size imposed by tar format.
 	char *dest_name = dest_path + snprintf(dest_path, sizeof(dest_path), "%s/", prefix);
-	stream *infile = NULL;
-
+	struct snapshot_copy c = { .nentries = 0 };
+	struct snapshot_reader readers[SNAPSHOT_READERS];
+	int nallocated = 0, nslots = 0, nstarted = 0, i;
+	buffer *manifest_buf = NULL;
+	stream *manifest = NULL;
+	size_t j = 0;
+
+	ATOMIC_INIT(&c.abort, 0);
 	int len;
-	if (sscanf(p, "%[^\n]\n%n", abs_src_path, &len) != 1) {
+	if (sscanf(p, "%[^\n]\n%n", db_dir, &len) != 1) {
 		GDKerror("internal error: first line of plan is malformed");
 		goto end;
 	}
 	p += len;
-	src_name = abs_src_path + len - 1; // - 1 because len includes the trailing newline
-	*src_name++ = DIR_SEP;
+	c.dir = db_dir;
 
 	char command;
 	long size;
 	while (sscanf(p, "%c %ld %100s\n%n", &command, &size, src_name, &len) == 3) {
+		struct snapshot_entry *f;
+
 		p += len;
-		strcpy(dest_name, src_name);
 		if (size < 0) {
 			GDKerror("malformed snapshot plan for %s: size %ld < 0", src_name, size);
 			goto end;
 		}
-		switch (command) {
-			case 'c':
-				infile = open_rstream(abs_src_path);
-				if (!infile) {
-					GDKerror("Could not open %s", abs_src_path);
-					goto end;
-				}
-				if (tar_copy_stream(out, dest_path, timestamp, infile, size) != GDK_SUCCEED)
-					goto end;
-				close_stream(infile);
-				infile = NULL;
-				break;
-			case 'w':
-				if (tar_write_data(out, dest_path, timestamp, p, size) != GDK_SUCCEED)
-					goto end;
-				p += size;
-				break;
-			default:
-				GDKerror("Unknown command in snapshot plan: %c (%s)", command, src_name);
+		if (command != 'c' && command != 'w') {
+			GDKerror("Unknown command in snapshot plan: %c (%s)", command, src_name);
+			goto end;
+		}
+		if (c.nentries == nallocated) {
+			struct snapshot_entry *n;
+
+			nallocated = nallocated ? 2 * nallocated : 1024;
+			n = GDKrealloc(c.entries, nallocated * sizeof(struct snapshot_entry));
+			if (n == NULL)
 				goto end;
+			c.entries = n;
+		}
+		f = &c.entries[c.nentries++];
+		*f = (struct snapshot_entry) {
+			.command = command,
+			.size = (size_t) size,
+			.name = GDKstrdup(src_name),
+		};
+		if (f->name == NULL)
+			goto end;
+		if (command == 'w') {
+			f->data = p;
+			p += size;
+			continue;
+		}
+		if (since > 0) {
+			struct stat st;
+
+			snprintf(abs_src_path, sizeof(abs_src_path), "%s%c%s", db_dir, DIR_SEP, src_name);
+			if (stat(abs_src_path, &st) < 0) {
+				GDKerror("stat failed on %s: %s", abs_src_path, strerror(errno));
+				goto end;
+			}
+			// renames only change the status change time
+			f->skip = (lng) MAX(st.st_mtime, st.st_ctime) < since;
+		}
+		if (!f->skip) {
+			f->first = c.nchunks;
+			c.nchunks += (f->size + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK;
 		}
 	}
+
+	manifest_buf = buffer_create(64 * 1024);
+	if (manifest_buf == NULL ||
+	    (manifest = buffer_wastream(manifest_buf, "snapshot_manifest")) == NULL) {
+		GDKerror("Failed to allocate manifest buffer");
+		goto end;
+	}
+	mnstr_printf(manifest, "id " LLFMT "\nsince " LLFMT "\n", id, since);
+	for (i = 0; i < c.nentries; i++)
+		mnstr_printf(manifest, "%s\n", c.entries[i].name);
+
+	c.nreaders = MAX(1, MIN(SNAPSHOT_READERS, GDKnr_threads));
+	c.nslots = c.nreaders * SNAPSHOT_SLOTS;
+	for (nslots = 0; nslots < c.nslots; nslots++) {
+		struct snapshot_slot *s = &c.slots[nslots];
+
+		if ((s->buf = GDKmalloc(SNAPSHOT_CHUNK)) == NULL)
+			goto end;
+		MT_sema_init(&s->full, 0, "snapfull");
+		MT_sema_init(&s->empty, 1, "snapempty");
+	}
+	for (nstarted = 0; nstarted < c.nreaders; nstarted++) {
+		char name[16];
+
+		snprintf(name, sizeof(name), "snapread%d", nstarted);
+		readers[nstarted] = (struct snapshot_reader) {
+			.c = &c,
+			.nr = nstarted,
+		};
+		if (MT_create_thread(&readers[nstarted].tid, snapshot_read_chunks, &readers[nstarted], MT_THR_JOINABLE, name) < 0) {
+			GDKerror("could not start snapshot reader");
+			goto end;
+		}
+	}
+
+	for (i = 0; i < c.nentries; i++) {
+		struct snapshot_entry *f = &c.entries[i];
+
+		if (GDKexiting()) {
+			GDKerror("server is shutting down");
+			goto end;
+		}
+		strcpy(dest_name, f->name);
+		if (f->command == 'w') {
+			if (tar_write_data(out, dest_path, timestamp, f->data, f->size) != GDK_SUCCEED)
+				goto end;
+			continue;
+		}
+		if (f->skip)
+			continue;
+		if (tar_write_header(out, dest_path, timestamp, f->size) != GDK_SUCCEED)
+			goto end;
+		for (size_t off = 0; off < f->size; off += SNAPSHOT_CHUNK, j++) {
+			struct snapshot_slot *s = &c.slots[j % c.nslots];
+			size_t chunk = MIN(SNAPSHOT_CHUNK, f->size - off);
+
+			MT_sema_down(&s->full);
+			if (s->len != (ssize_t) chunk) {
+				if (s->len < 0)
+					GDKerror("Could not read %s%c%s: %s", db_dir, DIR_SEP, f->name, strerror(s->err));
+				else
+					GDKerror("Read only %zd/%zu bytes of component %s", s->len, chunk, f->name);
+				goto end;
+			}
+			if (tar_write(out, s->buf, chunk) != GDK_SUCCEED)
+				goto end;
+			MT_sema_up(&s->empty);
+		}
+	}
+
+	strcpy(dest_name, "snapshot.manifest");
+	close_stream(manifest);
+	manifest = NULL;
+	if (tar_write_data(out, dest_path, timestamp, manifest_buf->buf, manifest_buf->pos) != GDK_SUCCEED)
+		goto end;
 	ret = GDK_SUCCEED;
 
 end:
+	// let readers that are still waiting for a slot find out that we quit
+	ATOMIC_SET(&c.abort, 1);
+	for (i = 0; i < nslots; i++)
+		MT_sema_up(&c.slots[i].empty);
+	for (i = 0; i < nstarted; i++)
+		MT_join_thread(readers[i].tid);
+	for (i = 0; i < nslots; i++) {
+		MT_sema_destroy(&c.slots[i].full);
+		MT_sema_destroy(&c.slots[i].empty);
+		GDKfree(c.slots[i].buf);
+	}
+	ATOMIC_DESTROY(&c.abort);
+	for (i = 0; i < c.nentries; i++)
+		GDKfree(c.entries[i].name);
+	GDKfree(c.entries);
+	if (manifest)
+		close_stream(manifest);
+	if (manifest_buf)
+		buffer_destroy(manifest_buf);
 	free(plan);
-	if (infile)
-		close_stream(infile);
 	return ret;
 }
 
 extern lng
-store_hot_snapshot(str tarfile)
+store_hot_snapshot(str tarfile, lng since)
 {
-	int locked = 0;
-	lng result = 0;
+	int locked = 0, copying = 0;
+	lng result = 0, id = 0;
+	bat wb_bat = 0;
+	size_t wb_offset = 0;
+	const char *ext;
 	char tmppath[FILENAME_MAX];
 	char dirpath[FILENAME_MAX];
 	int do_remove = 0;
@@ -2606,7 +3003,12 @@ store_hot_snapshot(str tarfile)
 		goto end;
 	}
 
-	snprintf(tmppath, sizeof(tmppath), "%s.tmp", tarfile);
+	// open_wstream compresses depending on the extension, so keep it
+	ext = strrchr(tarfile, '.');
+	if (ext && ext > tarfile && strchr(ext, DIR_SEP) == NULL)
+		snprintf(tmppath, sizeof(tmppath), "%.*s.tmp%s", (int) (ext - tarfile), tarfile, ext);
+	else
+		snprintf(tmppath, sizeof(tmppath), "%s.tmp", tarfile);
 	tar_stream = open_wstream(tmppath);
 	if (!tar_stream) {
 		GDKerror("Failed to open %s for writing", tmppath);
@@ -2660,18 +3062,39 @@ store_hot_snapshot(str tarfile)
 		goto end;
 	}
 
+	// The plan refers to parts of files that must not change until
+	// they are copied.  Commits only append to the log, so it is
+	// enough to keep the store manager from merging deltas and
+	// from checkpointing while the files are copied.
 	MT_lock_set(&bs_lock);
 	locked = 1;
 	wait_until_flusher_idle();
 	if (GDKexiting())
 		goto end;
+	flusher.snapshots++;
+	copying = 1;
+	MT_lock_unset(&bs_lock);
+	locked = 0;
+
+	// For the same reason the heap files do not change from here on.
+	// Their modified pages are written back without holding the lock,
+	// so that a later change of a heap faults its page and updates
+	// the modification time of the file, which the next incremental
+	// snapshot relies on.
+	(void) BBPwriteback(&wb_bat, &wb_offset, SIZE_MAX);
 
+	MT_lock_set(&bs_lock);
+	locked = 1;
+	id = (lng) time(NULL);
 	r = logger_funcs.get_snapshot_files(plan_stream);
 	if (r != GDK_SUCCEED)
 		goto end; // should already have set a GDK error
 	close_stream(plan_stream);
 	plan_stream = NULL;
-	r = hot_snapshot_write_tar(tar_stream, GDKgetenv("gdk_dbname"), buffer_get_buf(plan_buf));
+	MT_lock_unset(&bs_lock);
+	locked = 0;
+
+	r = hot_snapshot_write_tar(tar_stream, GDKgetenv("gdk_dbname"), buffer_get_buf(plan_buf), id, since);
 	if (r != GDK_SUCCEED)
 		goto end;
 
@@ -2692,18 +3115,21 @@ store_hot_snapshot(str tarfile)
 		goto end;
 	}
 #endif
-	// the original idea was to return a sort of sequence number of the
-	// database that identifies exactly which version has been snapshotted
-	// but no such number is available:
-	// logger_functions.read_last_transaction_id is not implemented
-	// anywhere.
-	//
-	// So we return a random positive integer instead.
-	result = 42;
+	// The snapshot is identified by the time its plan was made, in
+	// seconds since the epoch, which is also written to the
+	// snapshot.manifest file in the tar.  Passing it as since to a
+	// later snapshot makes that one incremental.
+	result = id;
 
 end:
 	if (dir_fd >= 0)
 		close(dir_fd);
+	if (copying) {
+		if (!locked)
+			MT_lock_set(&bs_lock);
+		flusher.snapshots--;
+		locked = 1;
+	}
 	if (locked)
 		MT_lock_unset(&bs_lock);
 	if (tar_stream)
@@ -3589,6 +4015,10 @@ trans_init(sql_trans *tr, backend_stack stk, sql_trans *otr)
 		if (s->base.id == ps->base.id) {
 			node *k, *l;
 
+			/* nothing to reset in a schema we didn't touch and which
+			 * didn't change since we last looked at it */
+			if (!istmp && !s->base.rtime && !s->base.wtime && s->base.stime == ps->base.wtime)
+				continue;
 			s->base.rtime = s->base.wtime = 0;
 			s->base.stime = ps->base.wtime;
 
@@ -3597,6 +4027,8 @@ trans_init(sql_trans *tr, backend_stack stk, sql_trans *otr)
 				sql_table *pt = k->data; /* parent transactions table */
 				sql_table *t = l->data; 
 
+				if (!istmp && !t->base.rtime && !t->base.wtime && t->base.stime == pt->base.wtime)
+					continue;
 				t->base.rtime = t->base.wtime = 0;
 				t->base.stime = pt->base.wtime;
 				if (!istmp && !t->base.allocated)
@@ -4356,6 +4788,17 @@ validate_tables(sql_schema *s, sql_schema *os)
 /* merge any changes from the global transaction into the local transaction */
 typedef int (*resetf) (sql_trans *tr, sql_base * fs, sql_base * pfs);
 
+/* The sets of objects in the catalog only change by committed schema
+ * updates, which bump the schema number, or by our own schema updates.
+ * Without either, the lists without a reset function (types, functions,
+ * keys, triggers) are still the same as the parent's and walking them
+ * can be skipped. */
+static int
+reset_structure(sql_trans *tr)
+{
+	return tr->schema_updates || tr->schema_number != store_schema_number();
+}
+
 static int
 reset_changeset(sql_trans *tr, changeset * fs, changeset * pfs, sql_base *b, resetf rf, dupfunc fd)
 {
@@ -4538,9 +4981,9 @@ reset_table(sql_trans *tr, sql_table *ft, sql_table *pft)
 			ok = reset_changeset( tr, &ft->columns, &pft->columns, &ft->base, (resetf) &reset_column, (dupfunc) &column_dup);
 		if (ok == LOG_OK)
 			ok = reset_changeset( tr, &ft->idxs, &pft->idxs, &ft->base, (resetf) &reset_idx, (dupfunc) &idx_dup);
-		if (ok == LOG_OK)
+		if (ok == LOG_OK && reset_structure(tr))
 			ok = reset_changeset( tr, &ft->keys, &pft->keys, &ft->base, (resetf) NULL, (dupfunc) &key_dup);
-		if (ok == LOG_OK)
+		if (ok == LOG_OK && reset_structure(tr))
 			ok = reset_changeset( tr, &ft->triggers, &pft->triggers, &ft->base, (resetf) NULL, (dupfunc) &trigger_dup);
 		if (ok == LOG_OK)
 			ok = reset_changeset( tr, &ft->members, &pft->members, &ft->base, (resetf) &reset_part, (dupfunc) &part_dup);
@@ -4593,9 +5036,9 @@ reset_schema(sql_trans *tr, sql_schema *fs, sql_schema *pfs)
 				ok = LOG_ERR;
 		}
 
-		if (ok == LOG_OK)
+		if (ok == LOG_OK && reset_structure(tr))
 			ok = reset_changeset(tr, &fs->types, &pfs->types, &fs->base, (resetf) NULL, (dupfunc) &type_dup);
-		if (ok == LOG_OK)
+		if (ok == LOG_OK && reset_structure(tr))
 			ok = reset_changeset(tr, &fs->funcs, &pfs->funcs, &fs->base, (resetf) NULL, (dupfunc) &func_dup);
 		if (ok == LOG_OK)
 			ok = reset_changeset(tr, &fs->seqs, &pfs->seqs, &fs->base, (resetf) &reset_seq, (dupfunc) &seq_dup);
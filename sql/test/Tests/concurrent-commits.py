@@ -0,0 +1,50 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import sys, threading
+
+# Commit from several connections at the same time, so that the
+# commits share syncs of the write-ahead log (group commit), then kill
+# the server without giving it a chance to shut down cleanly.  Every
+# commit that was acknowledged must be there after the restart.  Each
+# connection inserts into a table of its own, otherwise the concurrent
+# transactions would conflict.
+
+NCONN = 4
+NROWS = 100
+
+def client(script):
+    c = process.client('sql', stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+    return c.communicate(script)
+
+def sql(script):
+    out, err = client(script)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+s = process.server(args = ['--set', 'sql_commit_delay=2'], stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(''.join(['create table tcommit%d (i int);\n' % c for c in range(NCONN)]))
+
+res = [None] * NCONN
+def inserts(c):
+    res[c] = client(''.join(['insert into tcommit%d values (%d);\n' % (c, i) for i in range(NROWS)]))
+threads = [threading.Thread(target = inserts, args = (c,)) for c in range(NCONN)]
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+for out, err in res:
+    sys.stderr.write(err)
+
+# all commits have been acknowledged: kill the server
+s.kill()
+s.communicate()
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(''.join(['select %d, count(*), count(distinct i), min(i), max(i) from tcommit%d;\n' % (c, c) for c in range(NCONN)]) +
+    ''.join(['drop table tcommit%d;\n' % c for c in range(NCONN)]))
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
@@ -0,0 +1,82 @@
+import os, sys
+import pymonetdb
+
+# A transaction start only resets the catalog objects that were used
+# or changed since the previous one, and skips the lists of types,
+# functions, keys and triggers when no schema changed.  Check that a
+# session still gets a consistent view when one transaction changes
+# the schema of one schema while another commits data to a different
+# schema, and the first transaction is rolled back.
+
+def connect(autocommit):
+    return pymonetdb.connect(hostname = os.getenv('MAPIHOST', 'localhost'),
+                             port = int(os.getenv('MAPIPORT', '50000')),
+                             database = os.getenv('TSTDB', 'demo'),
+                             username = 'monetdb', password = 'monetdb',
+                             autocommit = autocommit)
+
+def query(name, cur, q):
+    cur.execute(q)
+    print('%s: %s' % (name, q))
+    for row in cur.fetchall():
+        print('\t' + '\t'.join([str(v) for v in row]))
+
+def views(name, cur):
+    query(name, cur, 'select count(*), sum(i) from sdml.t')
+    query(name, cur, "select t.name from sys.tables t, sys.schemas s where t.schema_id = s.id and s.name = 'sddl' order by t.name")
+    query(name, cur, "select c.name from sys.columns c, sys.tables t, sys.schemas s where c.table_id = t.id and t.schema_id = s.id and s.name = 'sddl' order by t.name, c.number")
+    query(name, cur, "select f.name from sys.functions f, sys.schemas s where f.schema_id = s.id and s.name = 'sddl' order by f.name")
+    query(name, cur, "select k.name from sys.keys k, sys.tables t, sys.schemas s where k.table_id = t.id and t.schema_id = s.id and s.name = 'sddl' order by k.name")
+    query(name, cur, "select g.name from sys.triggers g, sys.tables t, sys.schemas s where g.table_id = t.id and t.schema_id = s.id and s.name = 'sddl' order by g.name")
+
+c = connect(True)
+cc = c.cursor()
+cc.execute('create schema sddl')
+cc.execute('create table sddl.t0 (i int primary key)')
+cc.execute('create schema sdml')
+cc.execute('create table sdml.t (i int)')
+cc.execute('insert into sdml.t values (1), (2), (3)')
+
+a = connect(False)              # does the DDL and rolls back
+ac = a.cursor()
+b = connect(True)               # commits data in the other schema
+bc = b.cursor()
+r = connect(True)               # only reads
+rc = r.cursor()
+views('r', rc)
+
+ac.execute('create table sddl.t1 (i int, j varchar(10), constraint t1_pk primary key (i))')
+ac.execute('insert into sddl.t1 values (1, \'one\')')
+ac.execute('alter table sddl.t0 add column k int')
+ac.execute('create function sddl.f(x int) returns int begin return x + 1; end')
+ac.execute('create trigger t1_trg after insert on sddl.t1 for each row insert into sddl.t0 values (0, 0)')
+bc.execute('insert into sdml.t values (4), (5)')
+# the open transaction keeps its snapshot of the data and sees its
+# own schema changes; the others see the new data but not the schema
+# changes
+views('a', ac)
+views('b', bc)
+a.rollback()
+
+# after the rollback, everybody sees the committed data and the
+# original schema
+views('a', ac)
+views('b', bc)
+views('r', rc)
+
+# the other way around: schema changes are committed while a
+# transaction that changed data is rolled back
+ac.execute('insert into sdml.t values (6)')
+bc.execute('create table sddl.t2 (i int unique)')
+bc.execute('create function sddl.g() returns int begin return 2; end')
+views('a', ac)
+a.rollback()
+views('a', ac)
+views('r', rc)
+
+a.close()
+b.close()
+r.close()
+cc.execute('drop schema sddl cascade')
+cc.execute('drop schema sdml cascade')
+c.close()
@@ -0,0 +1,51 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import sys, time
+
+# A DELETE without WHERE followed by an insert that is large enough to
+# become the new main BAT, in one transaction, must be checkpointed as
+# the BAT that was logged.
+
+def client(lang, script, args = []):
+    c = process.client(lang, args = args, stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+    return c.communicate(script)
+
+def sql(script):
+    out, err = client('sql', script)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+check = '''
+select count(*), cast(sum(i) as bigint), min(i), max(i) from tdel;
+'''
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql('''
+create table tdel (i int);
+insert into tdel select value from generate_series(0, 1000);
+''')
+sql('call sys.flush_log();\n')
+time.sleep(2)
+sql('''
+start transaction;
+delete from tdel;
+insert into tdel select value from generate_series(1000000, 1200000);
+commit;
+''' + check)
+sql('call sys.flush_log();\n')
+time.sleep(2)
+sql(check)
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(check + '''
+drop table tdel;
+''')
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
@@ -9,6 +9,14 @@
 # We start a server on the untarred db dir and check the data.
 # The committed data should exist in the snapshot.
 # The uncommitted data should not.
+#
+# Before killing the server we also commit more data and make an
+# incremental snapshot on top of the first one.  Its manifest lists the
+# files of the full database, of which the unchanged ones are left out.
+# Checkpoints are suspended meanwhile, so that the BAT files do not
+# change and are left out.
+# Restoring the incremental snapshot over the first one must give back
+# all committed data.
 
 
 from __future__ import print_function
@@ -35,6 +43,17 @@ assert tstdb
 mydb = tstdb + '_snap'
 mydbdir = os.path.join(dbfarm, mydb)
 tarname = os.path.join(dbfarm, mydb + '.tar')
+tarname2 = os.path.join(dbfarm, mydb + '_incr.tar')
+
+def read_manifest(name):
+    # return the id, the since value, the files listed in the manifest
+    # and the files in the tar file, relative to the database directory
+    with tarfile.open(name) as tar:
+        members = [m[len(mydb) + 1:] for m in tar.getnames()]
+        manifest = tar.extractfile(mydb + '/snapshot.manifest').read().decode('utf-8').splitlines()
+    assert manifest[0].startswith('id ')
+    assert manifest[1].startswith('since ')
+    return int(manifest[0][3:]), int(manifest[1][6:]), manifest[2:], members
 
 def main():
     server = None
@@ -42,8 +61,9 @@ def main():
         # clean up remainder of earlier run
         if os.path.exists(mydbdir):
             shutil.rmtree(mydbdir)
-        if os.path.exists(tarname):
-            os.remove(tarname)
+        for name in [tarname, tarname2]:
+            if os.path.exists(name):
+                os.remove(name)
 
         # figure out a free port number
         s = socket.socket()
@@ -56,6 +76,19 @@ def main():
         server = process.server(dbname=mydb, mapiport = mapi_port, stdin=process.PIPE)
         time.sleep(2)
 
+        # connection 3 stops the checkpoints, so that from now on only
+        # the log files change; wait so that the BAT files are more
+        # than a second older than the first snapshot
+        conn3 = pymonetdb.connect(
+            database=server.dbname, hostname='localhost',
+            port=mapi_port,
+            username="monetdb", password="monetdb",
+            autocommit=True
+        )
+        cur3 = conn3.cursor()
+        cur3.execute("call sys.suspend_log_flushing()")
+        time.sleep(2)
+
         # connection 1 creates, inserts, commits and inserts uncommitted
         conn1 = pymonetdb.connect(
             database=server.dbname, hostname='localhost',
@@ -82,6 +115,34 @@ def main():
         # then conn1 creates the snapshot
         cur1.execute("call sys.hot_snapshot(%(tarname)s)", dict(tarname=tarname))
 
+        # a full snapshot contains all files listed in its manifest
+        snapid, since, files, members1 = read_manifest(tarname)
+        assert snapid > 0
+        assert since == 0
+        assert sorted(files + ['snapshot.manifest']) == sorted(members1)
+
+        # commit some more data and make an incremental snapshot
+        cur3.execute("insert into foo values ('committed2')")
+        cur3.execute("call sys.hot_snapshot(%(tarname)s, %(since)s)", dict(tarname=tarname2, since=snapid))
+
+        # the incremental snapshot contains the files of its manifest
+        # that changed since the first snapshot, and leaves out the
+        # others, which are in the first snapshot
+        snapid2, since, files, members = read_manifest(tarname2)
+        assert snapid2 >= snapid
+        assert since == snapid
+        assert set(members) - set(files) == set(['snapshot.manifest'])
+        for f in files:
+            st = os.stat(os.path.join(mydbdir, f))
+            if max(int(st.st_mtime), int(st.st_ctime)) >= since:
+                assert f in members, f
+        skipped = set(files) - set(members)
+        assert skipped
+        assert skipped <= set(members1)
+        cur3.execute("call sys.resume_log_flushing()")
+        cur3.close()
+        conn3.close()
+
         # we shut down the server and delete the dbdir
         cur1.close()
         conn1.close()
@@ -91,26 +152,36 @@ def main():
         time.sleep(1)
         shutil.rmtree(mydbdir)
 
-        # and extract the tarname
+        # and extract the tarname, then the incremental one over it
+        # and remove the files not listed in its manifest
         tar = tarfile.open(tarname)
         tar.extractall(dbfarm)
+        tar.close()
+        tar = tarfile.open(tarname2)
+        tar.extractall(dbfarm)
+        tar.close()
+        for dirpath, dirnames, filenames in os.walk(mydbdir):
+            for f in filenames:
+                path = os.path.join(dirpath, f)
+                if os.path.relpath(path, mydbdir) not in files + ['snapshot.manifest']:
+                    os.remove(path)
 
         # and restart the server
         server = process.server(dbname=mydb, mapiport = mapi_port, stdin=process.PIPE)
 
         # question is, is our data still there?
-        conn3 = pymonetdb.connect(
+        conn4 = pymonetdb.connect(
             database=server.dbname, hostname='localhost',
             port=mapi_port,
             username="monetdb", password="monetdb",
             autocommit=False
         )
-        cur3 = conn3.cursor()
-        cur3.execute('select * from foo')
-        foo = cur3.fetchall()
+        cur4 = conn4.cursor()
+        cur4.execute('select * from foo order by t')
+        foo = cur4.fetchall()
 
         # uncommitted1 and uncommitted2 should not be present
-        assert foo == [('committed1',)]
+        assert foo == [('committed1',), ('committed2',)]
 
         server.terminate()
         shutil.rmtree(mydbdir)
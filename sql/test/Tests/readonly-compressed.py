@@ -0,0 +1,102 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import os, re, sys, threading, time
+
+# The columns of a read-only table are saved as compressed segments at
+# the next checkpoint.  Let the checkpoint happen while views on the
+# (memory mapped) columns are in use, and check that the views and the
+# columns reloaded from the segments still see the same values.
+# Also check that the checkpoint really wrote the columns as segments;
+# the segment of a memory mapped heap X is written to X.new, which
+# replaces X when the heap is next loaded.
+
+def issegment(path):
+    for p in [path + '.new', path]:
+        if os.path.exists(p):
+            with open(p, 'rb') as f:
+                return f.read(8) == b'MDBSEG1\0'
+    return False
+
+def client(lang, script, args = []):
+    c = process.client(lang, args = args, stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+    return c.communicate(script)
+
+def sql(script):
+    out, err = client('sql', script)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+check = '''
+select count(*), sum(i), sum(length(s)) from tcomp;
+select i, s from tcomp where i between 500000 and 500004 order by i;
+'''
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql('''
+create table tcomp (i bigint, s varchar(10));
+insert into tcomp select value * 7919 % 1000003, cast(value * 7919 % 1000003 as varchar(10)) from generate_series(0, 1000000);
+''' + check)
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
+
+# after the restart the columns are memory mapped
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(check + '''
+alter table tcomp set read only;
+''')
+out, err = client('sql', "select location from sys.storage where schema = 'sys' and table = 'tcomp' order by column;\n")
+# the BAT with location dd/nnn is called tmp_nnn
+locations = re.findall(r'"((?:[0-7]+/)*[0-7]+)"', out)
+names = ['tmp_' + l.split('/')[-1] for l in locations]
+batdir = os.path.join(os.getenv('GDK_DBFARM'), os.getenv('TSTDB'), 'bat')
+files = [os.path.join(batdir, locations[0] + '.tail'),
+         os.path.join(batdir, locations[1] + '.theap')]
+mal = '''
+i:bat[:lng] := bbp.bind("%s");
+s:bat[:str] := bbp.bind("%s");
+vi := algebra.slice(i, 0:lng, 999999:lng);
+vs := algebra.slice(s, 0:lng, 999999:lng);
+alarm.sleep(6);
+si := aggr.sum(vi);
+io.print(si);
+l := batstr.length(vs);
+sl := aggr.sum(l);
+io.print(sl);
+''' % (names[0], names[1])
+res = []
+t = threading.Thread(target = lambda: res.append(client('mal', mal)))
+t.start()
+time.sleep(2)
+# the checkpoint runs while the MAL client holds the views
+sql('call sys.flush_log();\n')
+t.join()
+sys.stdout.write(res[0][0])
+sys.stderr.write(res[0][1])
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
+for f in files:
+    if not issegment(f):
+        sys.stderr.write('%s was not saved as a segment\n' % os.path.relpath(f, batdir))
+
+# reload from the segments, then make the table writable again
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(check + '''
+alter table tcomp set read write;
+insert into tcomp values (1000003, 'x');
+''' + check)
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(check + '''
+drop table tcomp;
+''')
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
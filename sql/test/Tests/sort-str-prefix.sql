@@ -0,0 +1,42 @@
+start transaction;
+
+-- strings that share long prefixes, tie on their first four bytes,
+-- are shorter than four bytes, or are null
+create table sortpfx (s varchar(40));
+insert into sortpfx values
+	('abcdefgh2'), ('abcd'), (null), ('abc'), (''), ('abcdefgh10'),
+	('abcdefgh1'), ('ab'), ('abcdd'), ('a'), ('abce'), (null),
+	('abcdefgh'), ('abcdefgh1'), ('abcd '), ('b'), ('ab c'), ('abc'),
+	('zzzz'), ('zzz'), (''), ('abcdefgh0'), ('abcdefgh00'),
+	('é'), ('ée'), ('e'), ('ef'), ('ff');
+select s from sortpfx order by s;
+select s from sortpfx order by s desc;
+
+-- enough rows for the quicksort to partition; the sorted order is
+-- checked pairwise with the normal string comparison
+create table sortpfx2 (s varchar(40));
+insert into sortpfx2
+	select case when value % 101 = 0 then null
+		    when value % 7 = 0 then substring('common', 1, cast(value % 5 as int))
+		    else 'common prefix ' || (value * 7919 % 20011) end
+	from generate_series(0, 20000);
+insert into sortpfx2 select s from sortpfx;
+
+with o as (select s, row_number() over (order by s) as r from sortpfx2)
+select count(*) from o a, o b where b.r = a.r + 1 and a.s > b.s;
+with o as (select s, row_number() over (order by s desc) as r from sortpfx2)
+select count(*) from o a, o b where b.r = a.r + 1 and a.s < b.s;
+-- the nulls stay together
+with o as (select s, row_number() over (order by s) as r from sortpfx2)
+select count(*) from o a, o b where b.r = a.r + 1 and (a.s is null) <> (b.s is null);
+with o as (select s, row_number() over (order by s desc) as r from sortpfx2)
+select count(*) from o a, o b where b.r = a.r + 1 and (a.s is null) <> (b.s is null);
+
+-- the same without nulls
+delete from sortpfx2 where s is null;
+with o as (select s, row_number() over (order by s) as r from sortpfx2)
+select count(*) from o a, o b where b.r = a.r + 1 and a.s > b.s;
+with o as (select s, row_number() over (order by s desc) as r from sortpfx2)
+select count(*) from o a, o b where b.r = a.r + 1 and a.s < b.s;
+
+rollback;
@@ -0,0 +1,64 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import sys
+
+# A join whose hash table, or a grouping whose partial hash table,
+# doesn't fit in the memory budget is done in partitions (gracejoin
+# and GRPpartitioned in gdk).  That only happens when the tables are
+# at least 16MB, so run the queries once in a server with a small
+# gdk_mem_maxsize, checking that the partitioned implementations were
+# used (from the ALGODEBUG output), and once with the default memory
+# size, which must give the same results.  The in-memory join comes
+# last, since the hash table it creates on the column is kept.
+
+ALGOMASK = 1 << 21
+
+queries = '''
+select count(*), sum(a.i), sum(b.j) from tspilla a, tspillb b where a.i = b.i;
+select count(*), sum(n), max(n) from (select i, count(*) as n from tspilla group by i) as t;
+select count(*), sum(n), max(n) from (select i, count(*) as n from tspillb group by i) as t;
+'''
+
+def client(script):
+    c = process.client('sql', stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+    return c.communicate(script)
+
+def sql(script):
+    out, err = client(script)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql('''
+create table tspilla (i int);
+insert into tspilla select value * 7919 % 1000003 from generate_series(0, 2000000);
+create table tspillb (i int, j int);
+insert into tspillb select value * 104729 % 1000003, value from generate_series(0, 2000000);
+''')
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
+
+s = process.server(args = ['--set', 'gdk_mem_maxsize=%d' % (1 << 26),
+                           '--debug=%d' % ALGOMASK],
+                   stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(queries)
+out, err = s.communicate()
+sys.stdout.write(out)
+# the debug output itself is too variable to compare
+for name, pattern in [('gracejoin', ': gracejoin('),
+                      ('GRPpartitioned', '): partitioned in ')]:
+    if pattern not in err:
+        sys.stderr.write('%s was not used\n' % name)
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(queries + '''
+drop table tspilla;
+drop table tspillb;
+''')
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
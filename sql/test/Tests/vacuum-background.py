@@ -0,0 +1,55 @@
+try:
+    from MonetDBtesting import process
+except ImportError:
+    import process
+
+import sys, time
+
+# The idle manager vacuums a user table once at least 10% (and at
+# least 1024) of its rows are deleted.  Wait for that to happen and
+# check that the table keeps its remaining rows, also after a restart.
+
+def client(lang, script, args = []):
+    c = process.client(lang, args = args, stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+    return c.communicate(script)
+
+def sql(script):
+    out, err = client('sql', script)
+    sys.stdout.write(out)
+    sys.stderr.write(err)
+
+check = '''
+select count(*), cast(sum(i) as bigint), min(i), max(i) from tvac;
+'''
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql('''
+create table tvac (i int, s varchar(20));
+insert into tvac select value, 'row ' || value from generate_series(0, 10000);
+''')
+# the table is only a candidate once its inserts are checkpointed
+sql('call sys.flush_log();\n')
+time.sleep(2)
+sql('''
+delete from tvac where i % 4 = 0;
+''' + check)
+for i in range(60):
+    out, err = client('sql', "select count(*) from sys.vacuum_status where \"table\" = 'tvac' and status = 'done';\n", args = ['-fcsv'])
+    if out.strip().split('\n')[-1] == '1':
+        break
+    time.sleep(1)
+sql('''
+select "schema", "table", status, "rows", removed from sys.vacuum_status where "table" = 'tvac';
+''' + check)
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)
+
+s = process.server(stdin = process.PIPE, stdout = process.PIPE, stderr = process.PIPE)
+sql(check + '''
+select i, s from tvac where i between 100 and 104 order by i;
+drop table tvac;
+''')
+out, err = s.communicate()
+sys.stdout.write(out)
+sys.stderr.write(err)